@@ -0,0 +1,364 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+/**
+ * @brief Wraps a string literal into a compile-time checked format string for the typed logging API.
+ *
+ * The placeholders of the string are checked against the arguments when the call is compiled, e.g.
+ * `log->info(LOG4CPP_FMT("user {} logged in after {:.2f} ms"), name, elapsed)`.
+ */
+#define LOG4CPP_FMT(str)                                                                                              \
+    [] {                                                                                                               \
+        struct log4cpp_format_literal {                                                                                \
+            static constexpr std::string_view value() {                                                                \
+                return str;                                                                                            \
+            }                                                                                                          \
+        };                                                                                                             \
+        return ::log4cpp::format::format_string<log4cpp_format_literal>{};                                             \
+    }()
+
+namespace log4cpp::format {
+    /* The largest field width of a replacement field, e.g. {:1024} */
+    constexpr unsigned int FORMAT_WIDTH_MAX = 1024;
+    /* The largest precision of a replacement field, e.g. {:.64f} */
+    constexpr int FORMAT_PRECISION_MAX = 64;
+
+    /**
+     * @enum arg_type
+     * @brief How an argument of the typed API is stored and formatted.
+     */
+    enum class arg_type : uint8_t {
+        // Not supported by the format API
+        NONE,
+        BOOL,
+        CHAR,
+        // Signed integers, stored as long long
+        INT,
+        // Unsigned integers, stored as unsigned long long
+        UINT,
+        // float and double, stored as double
+        DOUBLE,
+        // NUL-terminated string
+        CSTRING,
+        // std::string and std::string_view, pointer and length
+        STRING,
+        POINTER
+    };
+
+    /**
+     * @brief One type-erased argument, built on the caller's stack by the typed logging methods.
+     */
+    class format_arg {
+    public:
+        arg_type type{arg_type::NONE};
+
+        union {
+            long long i;
+            unsigned long long u;
+            double d;
+            const char *s;
+            const void *p;
+        } value{0};
+
+        /* The length of a STRING */
+        size_t size{0};
+    };
+
+    /**
+     * @brief A format string and its arguments, the non-template form the library formats from.
+     */
+    class format_args {
+    public:
+        // Must have static storage duration, deferred async formatting keeps only the pointer
+        std::string_view fmt;
+        const format_arg *args{nullptr};
+        size_t count{0};
+    };
+
+    /**
+     * @brief A parsed format specification, the part of a replacement field after ':'.
+     *
+     * Grammar: [align][0][width][.precision][type], align is '<' or '>', type is one of d x X o b (integers),
+     * f e g (floating point), s (strings, bool), c (char) and p (pointers).
+     */
+    class format_spec {
+    public:
+        // '<' or '>', 0 for the default: numbers right-aligned, everything else left-aligned
+        char align{0};
+        // Pad numbers with zeros after the sign instead of spaces
+        bool zero_pad{false};
+        unsigned int width{0};
+        // -1 if not given
+        int precision{-1};
+        // The presentation type, 0 for the default
+        char type{0};
+    };
+
+    enum class format_error : uint8_t {
+        NONE,
+        // An argument type the format API cannot format
+        UNSUPPORTED_TYPE,
+        // A '{' without its '}' or a single '}'
+        UNMATCHED_BRACE,
+        // A replacement field that is not {} or {:spec}, or a malformed spec
+        BAD_SPEC,
+        // A spec that does not fit the type of its argument, e.g. {:x} for a string
+        TYPE_MISMATCH,
+        // More replacement fields than arguments
+        TOO_FEW_ARGS,
+        // More arguments than replacement fields
+        TOO_MANY_ARGS
+    };
+
+    /**
+     * @brief Parses the format specification of a replacement field.
+     * @param spec The text between ':' and '}'.
+     * @param[out] out The parsed specification.
+     * @return false if the specification is malformed.
+     */
+    constexpr bool parse_spec(std::string_view spec, format_spec &out) {
+        size_t i = 0;
+        if (i < spec.size() && ('<' == spec[i] || '>' == spec[i])) {
+            out.align = spec[i++];
+        }
+        if (i < spec.size() && '0' == spec[i]) {
+            out.zero_pad = true;
+            ++i;
+        }
+        for (; i < spec.size() && spec[i] >= '0' && spec[i] <= '9'; ++i) {
+            out.width = out.width * 10 + static_cast<unsigned int>(spec[i] - '0');
+            if (out.width > FORMAT_WIDTH_MAX) {
+                return false;
+            }
+        }
+        if (i < spec.size() && '.' == spec[i]) {
+            ++i;
+            if (i == spec.size() || spec[i] < '0' || spec[i] > '9') {
+                return false;
+            }
+            out.precision = 0;
+            for (; i < spec.size() && spec[i] >= '0' && spec[i] <= '9'; ++i) {
+                out.precision = out.precision * 10 + (spec[i] - '0');
+                if (out.precision > FORMAT_PRECISION_MAX) {
+                    return false;
+                }
+            }
+        }
+        if (i < spec.size()) {
+            out.type = spec[i++];
+        }
+        return i == spec.size();
+    }
+
+    /**
+     * @brief Whether a format specification can be applied to an argument type.
+     */
+    constexpr bool spec_accepts(arg_type type, const format_spec &spec) {
+        const char t = spec.type;
+        switch (type) {
+            case arg_type::BOOL:
+                return spec.precision < 0 && (0 == t || 's' == t || 'd' == t);
+            case arg_type::CHAR:
+                return spec.precision < 0 && (0 == t || 'c' == t || 'd' == t || 'x' == t || 'X' == t);
+            case arg_type::INT:
+            case arg_type::UINT:
+                return spec.precision < 0 && (0 == t || 'd' == t || 'x' == t || 'X' == t || 'o' == t || 'b' == t);
+            case arg_type::DOUBLE:
+                return 0 == t || 'f' == t || 'e' == t || 'g' == t;
+            case arg_type::CSTRING:
+            case arg_type::STRING:
+                return 0 == t || 's' == t;
+            case arg_type::POINTER:
+                return spec.precision < 0 && (0 == t || 'p' == t);
+            default:
+                return false;
+        }
+    }
+
+    /**
+     * @brief Checks a format string against the types of its arguments.
+     *
+     * Replacement fields are {} or {:spec} and consume the arguments in order, "{{" and "}}" are literal braces.
+     * @param fmt The format string.
+     * @param types The argument types.
+     * @param count The number of arguments.
+     * @return The first problem found, format_error::NONE if the arguments fit.
+     */
+    constexpr format_error check_format(std::string_view fmt, const arg_type *types, size_t count) {
+        for (size_t i = 0; i < count; ++i) {
+            if (arg_type::NONE == types[i]) {
+                return format_error::UNSUPPORTED_TYPE;
+            }
+        }
+        size_t index = 0;
+        for (size_t i = 0; i < fmt.size(); ++i) {
+            if ('{' == fmt[i]) {
+                if (i + 1 < fmt.size() && '{' == fmt[i + 1]) {
+                    ++i;
+                    continue;
+                }
+                const size_t close = fmt.find('}', i + 1);
+                if (std::string_view::npos == close) {
+                    return format_error::UNMATCHED_BRACE;
+                }
+                const std::string_view field = fmt.substr(i + 1, close - i - 1);
+                format_spec spec;
+                if (!field.empty() && (field[0] != ':' || !parse_spec(field.substr(1), spec))) {
+                    return format_error::BAD_SPEC;
+                }
+                if (index == count) {
+                    return format_error::TOO_FEW_ARGS;
+                }
+                if (!spec_accepts(types[index], spec)) {
+                    return format_error::TYPE_MISMATCH;
+                }
+                ++index;
+                i = close;
+            }
+            else if ('}' == fmt[i]) {
+                if (i + 1 < fmt.size() && '}' == fmt[i + 1]) {
+                    ++i;
+                    continue;
+                }
+                return format_error::UNMATCHED_BRACE;
+            }
+        }
+        return index < count ? format_error::TOO_MANY_ARGS : format_error::NONE;
+    }
+
+    /**
+     * @brief The arg_type an argument of type T is formatted as, arg_type::NONE if T is not supported.
+     */
+    template<typename T>
+    constexpr arg_type type_of() {
+        using U = std::decay_t<T>;
+        if constexpr (std::is_same_v<U, bool>) {
+            return arg_type::BOOL;
+        }
+        else if constexpr (std::is_same_v<U, char>) {
+            return arg_type::CHAR;
+        }
+        else if constexpr (std::is_integral_v<U> && std::is_signed_v<U>) {
+            return arg_type::INT;
+        }
+        else if constexpr (std::is_integral_v<U>) {
+            return arg_type::UINT;
+        }
+        else if constexpr (std::is_same_v<U, float> || std::is_same_v<U, double>) {
+            return arg_type::DOUBLE;
+        }
+        else if constexpr (std::is_same_v<U, const char *> || std::is_same_v<U, char *>) {
+            return arg_type::CSTRING;
+        }
+        else if constexpr (std::is_same_v<U, std::string> || std::is_same_v<U, std::string_view>) {
+            return arg_type::STRING;
+        }
+        else if constexpr ((std::is_pointer_v<U> && !std::is_function_v<std::remove_pointer_t<U>>) ||
+                           std::is_null_pointer_v<U>) {
+            return arg_type::POINTER;
+        }
+        else {
+            return arg_type::NONE;
+        }
+    }
+
+    template<typename... Args>
+    inline constexpr arg_type arg_types[] = {type_of<Args>()..., arg_type::NONE};
+
+    /**
+     * @brief Type-erases one argument. The result refers to, and must not outlive, string arguments.
+     */
+    template<typename T>
+    format_arg make_arg(const T &value) {
+        constexpr arg_type type = type_of<T>();
+        format_arg arg;
+        arg.type = type;
+        if constexpr (arg_type::BOOL == type || arg_type::CHAR == type || arg_type::INT == type) {
+            arg.value.i = static_cast<long long>(value);
+        }
+        else if constexpr (arg_type::UINT == type) {
+            arg.value.u = static_cast<unsigned long long>(value);
+        }
+        else if constexpr (arg_type::DOUBLE == type) {
+            arg.value.d = static_cast<double>(value);
+        }
+        else if constexpr (arg_type::CSTRING == type) {
+            arg.value.s = value;
+        }
+        else if constexpr (arg_type::STRING == type) {
+            arg.value.s = value.data();
+            arg.size = value.size();
+        }
+        else if constexpr (arg_type::POINTER == type) {
+            arg.value.p = static_cast<const void *>(value);
+        }
+        return arg;
+    }
+
+    /**
+     * @brief A format string checked at compile time, created with LOG4CPP_FMT().
+     * @tparam S A type whose static constexpr value() returns the string.
+     */
+    template<typename S>
+    class format_string {
+    public:
+        static constexpr std::string_view view() {
+            return S::value();
+        }
+    };
+
+    /**
+     * @brief Checks a format string against its argument types, for use in static_assert.
+     */
+    template<typename S, typename... Args>
+    constexpr format_error check() {
+        return check_format(S::value(), arg_types<Args...>, sizeof...(Args));
+    }
+
+/* Turns a format_error of check<S, Args...>() into a compile error with a readable message */
+#define LOG4CPP_FORMAT_ASSERT(err)                                                                                     \
+    static_assert((err) != ::log4cpp::format::format_error::UNSUPPORTED_TYPE,                                        \
+                  "log4cpp: an argument type is not supported by the format API");                                     \
+    static_assert((err) != ::log4cpp::format::format_error::UNMATCHED_BRACE,                                         \
+                  "log4cpp: unmatched brace in the format string, write {{ and }} for literal braces");                \
+    static_assert((err) != ::log4cpp::format::format_error::BAD_SPEC,                                                \
+                  "log4cpp: malformed replacement field in the format string");                                        \
+    static_assert((err) != ::log4cpp::format::format_error::TYPE_MISMATCH,                                           \
+                  "log4cpp: a format specification does not fit the type of its argument");                           \
+    static_assert((err) != ::log4cpp::format::format_error::TOO_FEW_ARGS,                                            \
+                  "log4cpp: the format string has more replacement fields than arguments");                            \
+    static_assert((err) != ::log4cpp::format::format_error::TOO_MANY_ARGS,                                           \
+                  "log4cpp: the format string has fewer replacement fields than arguments")
+
+    /**
+     * @brief Formats type-erased arguments.
+     *
+     * Integers and floating point numbers are converted with std::to_chars. The format string must have passed
+     * check_format(), a field without a matching argument is written as is.
+     * @param buf The output buffer, always NUL-terminated if len > 0.
+     * @param len The size of the buffer, output beyond it is truncated.
+     * @param args The format string and arguments.
+     * @return The length of the output, without the NUL.
+     */
+    size_t vformat(char *buf, size_t len, const format_args &args);
+
+    /**
+     * @brief Formats arguments into a buffer, the format string is checked at compile time.
+     * @param buf The output buffer, always NUL-terminated if len > 0.
+     * @param len The size of the buffer, output beyond it is truncated.
+     * @param fmt The format string, from LOG4CPP_FMT().
+     * @param args The arguments.
+     * @return The length of the output, without the NUL.
+     */
+    template<typename S, typename... Args>
+    size_t format_to(char *buf, size_t len, format_string<S> fmt, const Args &...args) {
+        LOG4CPP_FORMAT_ASSERT((check<S, Args...>()));
+        const format_arg array[] = {make_arg(args)..., format_arg{}};
+        return vformat(buf, len, format_args{fmt.view(), array, sizeof...(Args)});
+    }
+} // namespace log4cpp::format
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <atomic>
+#include <cstdint>
 #include <memory>
 #include <mutex>
 #include <shared_mutex>
@@ -7,8 +9,9 @@
 #include <thread>
 #include <unordered_map>
 
+#include "log4cpp/format.hpp"
+
 #ifndef _WIN32
-#include <atomic>
 #include <csignal> // for SIGHUP
 #include <vector>
 #endif
@@ -70,12 +73,17 @@ namespace log4cpp {
     namespace config {
         class logger;
         class log4cpp;
+        class file_appender;
     } // namespace config
 
     namespace appender {
         class log_appender;
     }
 
+    namespace async {
+        class async_dispatcher;
+    }
+
     /**
      * @class logger
      * @brief The abstract base class (interface) for a logger.
@@ -141,6 +149,92 @@ namespace log4cpp {
          * @param ... Variable arguments.
          */
         virtual void trace(const char *__restrict fmt, ...) const = 0;
+
+        /**
+         * @brief Logs a message of the typed format API with a specific log level.
+         *
+         * With deferred async formatting the line is formatted after the call returns, so args.fmt must be a string
+         * literal (as from LOG4CPP_FMT()). String arguments are copied.
+         * @param _level The log level.
+         * @param args The format string and the type-erased arguments.
+         */
+        virtual void log(log_level _level, const format::format_args &args) const = 0;
+
+        /**
+         * @brief Logs a message with a compile-time checked format string, e.g.
+         * `log->log(log_level::INFO, LOG4CPP_FMT("{} of {} done"), n, total)`.
+         *
+         * The arguments are formatted without printf: integers and floating point numbers with std::to_chars.
+         * @param _level The log level.
+         * @param fmt The format string, from LOG4CPP_FMT().
+         * @param args The arguments.
+         */
+        template<typename S, typename... Args>
+        void log(log_level _level, format::format_string<S> fmt, const Args &...args) const {
+            LOG4CPP_FORMAT_ASSERT((format::check<S, Args...>()));
+            const format::format_arg array[] = {format::make_arg(args)..., format::format_arg{}};
+            log(_level, format::format_args{fmt.view(), array, sizeof...(Args)});
+        }
+
+        /**
+         * @brief Logs a message at the FATAL level, with a compile-time checked format string.
+         * @param fmt The format string, from LOG4CPP_FMT().
+         * @param args The arguments.
+         */
+        template<typename S, typename... Args>
+        void fatal(format::format_string<S> fmt, const Args &...args) const {
+            log(log_level::FATAL, fmt, args...);
+        }
+
+        /**
+         * @brief Logs a message at the ERROR level, with a compile-time checked format string.
+         * @param fmt The format string, from LOG4CPP_FMT().
+         * @param args The arguments.
+         */
+        template<typename S, typename... Args>
+        void error(format::format_string<S> fmt, const Args &...args) const {
+            log(log_level::ERROR, fmt, args...);
+        }
+
+        /**
+         * @brief Logs a message at the WARN level, with a compile-time checked format string.
+         * @param fmt The format string, from LOG4CPP_FMT().
+         * @param args The arguments.
+         */
+        template<typename S, typename... Args>
+        void warn(format::format_string<S> fmt, const Args &...args) const {
+            log(log_level::WARN, fmt, args...);
+        }
+
+        /**
+         * @brief Logs a message at the INFO level, with a compile-time checked format string.
+         * @param fmt The format string, from LOG4CPP_FMT().
+         * @param args The arguments.
+         */
+        template<typename S, typename... Args>
+        void info(format::format_string<S> fmt, const Args &...args) const {
+            log(log_level::INFO, fmt, args...);
+        }
+
+        /**
+         * @brief Logs a message at the DEBUG level, with a compile-time checked format string.
+         * @param fmt The format string, from LOG4CPP_FMT().
+         * @param args The arguments.
+         */
+        template<typename S, typename... Args>
+        void debug(format::format_string<S> fmt, const Args &...args) const {
+            log(log_level::DEBUG, fmt, args...);
+        }
+
+        /**
+         * @brief Logs a message at the TRACE level, with a compile-time checked format string.
+         * @param fmt The format string, from LOG4CPP_FMT().
+         * @param args The arguments.
+         */
+        template<typename S, typename... Args>
+        void trace(format::format_string<S> fmt, const Args &...args) const {
+            log(log_level::TRACE, fmt, args...);
+        }
     };
 
     class logger_manager;
@@ -217,6 +311,21 @@ namespace log4cpp {
 
         const config::log4cpp *get_config() const;
 
+        /**
+         * @brief Gets the number of records discarded by the async overflow policies since startup.
+         * @return The total over all loggers.
+         */
+        [[nodiscard]] uint64_t get_dropped_records() const;
+
+        /**
+         * @brief Gets the number of records of one logger discarded by the async overflow policies since startup.
+         *
+         * The count is kept across hot reloads.
+         * @param name The name of the logger.
+         * @return The count, 0 for a logger that has never dropped a record.
+         */
+        [[nodiscard]] uint64_t get_dropped_records(const std::string &name) const;
+
         logger_manager(const logger_manager &) = delete;
 
         logger_manager &operator=(const logger_manager &) = delete;
@@ -250,12 +359,20 @@ namespace log4cpp {
         // @brief Sets the global log pattern based on the current configuration.
         void set_log_pattern() const;
 
-        // @brief Builds (or rebuilds) all required Appender instances based on the current config. Uses lazy
-        // initialization.
+        // @brief Builds (or rebuilds) all required Appender instances and the async dispatcher based on the current
+        // config. Uses lazy initialization.
         void build_appender();
 
-        // @brief Builds a concrete logger instance based on the given logger configuration.
-        std::shared_ptr<logger> build_logger(const config::logger &log_cfg) const;
+        class file_appender_entry;
+
+        // @brief Builds a file appender for cfg, or reuses the running one if it was built from the same config.
+        file_appender_entry build_file_appender(const config::file_appender &cfg) const;
+
+        // @brief Builds a concrete logger instance named `name` based on the given logger configuration.
+        std::shared_ptr<logger> build_logger(const config::logger &log_cfg, const std::string &name) const;
+
+        // @brief Gets (or creates) the drop counter of the logger `name`.
+        std::atomic<uint64_t> *get_drop_counter(const std::string &name) const;
 
         // @brief Gets or creates a logger if it doesn't exist. Uses a double-checked locking pattern for thread-safety
         // and efficiency.
@@ -288,14 +405,98 @@ namespace log4cpp {
 
         // A shared pointer to the console appender.
         std::shared_ptr<appender::log_appender> console_appender_ptr;
-        // A shared pointer to the file appender.
-        std::shared_ptr<appender::log_appender> file_appender_ptr;
+        // A file appender and the configuration it was built from, a reload with the same one keeps the file open.
+        class file_appender_entry final {
+        public:
+            std::shared_ptr<appender::log_appender> appender;
+            std::shared_ptr<const config::file_appender> cfg;
+        };
+        // The file appenders by name: "file" and the named ones, each with its own file, fd and buffer.
+        std::unordered_map<std::string, file_appender_entry> file_appenders;
         // A shared pointer to the socket appender.
         std::shared_ptr<appender::log_appender> socket_appender_ptr;
+        // The async dispatcher shared by all loggers, nullptr unless "async" is configured.
+        std::shared_ptr<async::async_dispatcher> async_dispatcher_ptr;
 
         // A read-write lock to protect the logger map.
         mutable std::shared_mutex logger_rw_lock;
         // A map storing all active logger proxies (name -> weak_ptr of logger_proxy).
         std::unordered_map<std::string, std::weak_ptr<logger_proxy>> loggers;
+
+        // A mutex to protect the drop counter map.
+        mutable std::mutex drop_counters_mtx;
+        // Records dropped by the async overflow policies (logger name -> count), entries are never removed.
+        mutable std::unordered_map<std::string, std::unique_ptr<std::atomic<uint64_t>>> drop_counters;
     };
 } // namespace log4cpp
+
+/*
+ * Level stripping macros
+ *
+ * LOG4CPP_FATAL(logger, ...) .. LOG4CPP_TRACE(logger, ...) call the method of the same level, with the printf or the
+ * typed format arguments:
+ *     LOG4CPP_INFO(log, "user %s", name);
+ *     LOG4CPP_DEBUG(log, LOG4CPP_FMT("took {} us"), elapsed());
+ * Levels above LOG4CPP_ACTIVE_LEVEL expand to nothing, the arguments are not compiled in. Enabled levels check the
+ * logger's level first, the arguments are only evaluated when the message is written.
+ * LOG4CPP_ACTIVE_LEVEL is set by the LOG4CPP_ACTIVE_LEVEL CMake option or the active_level meson option, it defaults
+ * to LOG4CPP_LEVEL_TRACE (nothing stripped). LOG4CPP_LEVEL_OFF strips every level.
+ */
+#define LOG4CPP_LEVEL_OFF (-1)
+#define LOG4CPP_LEVEL_FATAL 0
+#define LOG4CPP_LEVEL_ERROR 1
+#define LOG4CPP_LEVEL_WARN 2
+#define LOG4CPP_LEVEL_INFO 3
+#define LOG4CPP_LEVEL_DEBUG 4
+#define LOG4CPP_LEVEL_TRACE 5
+
+#ifndef LOG4CPP_ACTIVE_LEVEL
+#define LOG4CPP_ACTIVE_LEVEL LOG4CPP_LEVEL_TRACE
+#endif
+
+// The values must follow log4cpp::log_level
+static_assert(LOG4CPP_LEVEL_TRACE == static_cast<int>(log4cpp::log_level::TRACE));
+
+#define LOG4CPP_LOG_IF_ENABLED(logger, level, method, ...)                                                             \
+    do {                                                                                                               \
+        const auto &log4cpp_logger_ = (logger);                                                                        \
+        if (log4cpp_logger_->get_level() >= (level)) {                                                                 \
+            log4cpp_logger_->method(__VA_ARGS__);                                                                      \
+        }                                                                                                              \
+    } while (0)
+
+#if LOG4CPP_ACTIVE_LEVEL >= LOG4CPP_LEVEL_FATAL
+#define LOG4CPP_FATAL(logger, ...) LOG4CPP_LOG_IF_ENABLED(logger, log4cpp::log_level::FATAL, fatal, __VA_ARGS__)
+#else
+#define LOG4CPP_FATAL(logger, ...) ((void)0)
+#endif
+
+#if LOG4CPP_ACTIVE_LEVEL >= LOG4CPP_LEVEL_ERROR
+#define LOG4CPP_ERROR(logger, ...) LOG4CPP_LOG_IF_ENABLED(logger, log4cpp::log_level::ERROR, error, __VA_ARGS__)
+#else
+#define LOG4CPP_ERROR(logger, ...) ((void)0)
+#endif
+
+#if LOG4CPP_ACTIVE_LEVEL >= LOG4CPP_LEVEL_WARN
+#define LOG4CPP_WARN(logger, ...) LOG4CPP_LOG_IF_ENABLED(logger, log4cpp::log_level::WARN, warn, __VA_ARGS__)
+#else
+#define LOG4CPP_WARN(logger, ...) ((void)0)
+#endif
+
+#if LOG4CPP_ACTIVE_LEVEL >= LOG4CPP_LEVEL_INFO
+#define LOG4CPP_INFO(logger, ...) LOG4CPP_LOG_IF_ENABLED(logger, log4cpp::log_level::INFO, info, __VA_ARGS__)
+#else
+#define LOG4CPP_INFO(logger, ...) ((void)0)
+#endif
+
+#if LOG4CPP_ACTIVE_LEVEL >= LOG4CPP_LEVEL_DEBUG
+#define LOG4CPP_DEBUG(logger, ...) LOG4CPP_LOG_IF_ENABLED(logger, log4cpp::log_level::DEBUG, debug, __VA_ARGS__)
+#else
+#define LOG4CPP_DEBUG(logger, ...) ((void)0)
+#endif
+
+#if LOG4CPP_ACTIVE_LEVEL >= LOG4CPP_LEVEL_TRACE
+#define LOG4CPP_TRACE(logger, ...) LOG4CPP_LOG_IF_ENABLED(logger, log4cpp::log_level::TRACE, trace, __VA_ARGS__)
+#else
+#define LOG4CPP_TRACE(logger, ...) ((void)0)
+#endif
@@ -14,6 +14,9 @@ namespace log4cpp {
      * to the client, which holds a `shared_ptr` to this proxy. The `logger_manager`
      * can then atomically swap the underlying `target_` when the configuration
      * is hot-reloaded, without invalidating the client's logger instance.
+     * Calls are forwarded without locks or reference counting: `target_` is read
+     * inside an RCU read-side section, and `set_target` waits for a grace period
+     * before it releases the old target.
      */
     class logger_proxy: public logger {
     public:
@@ -36,15 +39,25 @@ namespace log4cpp {
 
         /**
          * @brief Gets the current log level.
-         * @return The log level of the underlying real logger.
+         * @return The log level of the underlying real logger, as cached by the proxy.
          */
         [[nodiscard]] log_level get_level() const override;
         /**
          * @brief Sets the log level.
+         * Change the level through the proxy, not through get_target(), so the proxy's cached level follows.
          * @param level The new log level for the underlying real logger.
          */
         void set_level(log_level level) override;
 
+        // The typed format API templates of the base class
+        using logger::log;
+        using logger::fatal;
+        using logger::error;
+        using logger::warn;
+        using logger::info;
+        using logger::debug;
+        using logger::trace;
+
         /**
          * @brief Forwards a formatted log message to the real logger.
          * @param _level The log level.
@@ -53,6 +66,13 @@ namespace log4cpp {
          */
         void log(log_level _level, const char *__restrict fmt, va_list args) const override;
 
+        /**
+         * @brief Forwards a message of the typed format API to the real logger.
+         * @param _level The log level.
+         * @param args The format string and the type-erased arguments.
+         */
+        void log(log_level _level, const format::format_args &args) const override;
+
         // The following methods are convenience wrappers that forward calls to the real logger.
         void fatal(const char *__restrict fmt, ...) const override;
         void error(const char *__restrict fmt, ...) const override;
@@ -75,15 +95,21 @@ namespace log4cpp {
     private:
         /**
          * @brief Atomically swaps the underlying real logger.
-         * This is the core mechanism for hot-reloading.
+         * This is the core mechanism for hot-reloading. The old logger is released once every call still using it
+         * has returned.
          * @param target The new logger implementation to use.
          */
         void set_target(std::shared_ptr<logger> target);
 
-        /// @brief A read-write mutex to protect access to `target_`.
-        /// Logging operations use a shared lock, while `set_target` uses a unique lock.
-        mutable std::shared_mutex mtx;
-        /// @brief A pointer to the actual logger implementation that does the work.
-        std::shared_ptr<logger> target_;
+        /// @brief Serializes the writers (`set_target`, `set_name`, `set_level`) and protects `owner_`.
+        /// Logging operations take no lock, they read `target_` inside an RCU read-side section.
+        mutable std::mutex mtx;
+        /// @brief The actual logger implementation that does the work, published for lock-free readers.
+        std::atomic<logger *> target_{nullptr};
+        /// @brief Owns `*target_`.
+        std::shared_ptr<logger> owner_;
+        /// @brief The level of the target, checked before anything else so disabled calls cost one relaxed load.
+        /// Updated by `set_target` and `set_level`.
+        std::atomic<log_level> level_{log_level::WARN};
     };
 } // namespace log4cpp
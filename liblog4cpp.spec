@@ -1,5 +1,5 @@
 # Must match the first line of ../VERSION (build-rpm.sh overwrites this when building).
-%define _version 4.1.3
+%define _version 5.0.0
 
 Name:           liblog4cpp
 Version:        %{_version}
@@ -15,6 +15,8 @@ Source0:        %{name}-%{version}.tar.gz
 # Build-time dependencies
 BuildRequires:  cmake
 BuildRequires:  gcc-c++
+BuildRequires:  zlib-devel
+BuildRequires:  libzstd-devel
 
 %description
 A log4j-style C++ logging library.
@@ -71,6 +73,8 @@ export LDFLAGS=""
 %{_libdir}/cmake/log4cpp/
 
 %changelog
+* Sat Oct 17 2026 Developer <developer@log4cpp.org> - 5.0.0-1
+- ABI break: logger has a new virtual for the typed format API, logger_manager has new members. SONAME is now liblog4cpp.so.5.
 * Mon May 15 2026 Developer <developer@log4cpp.org> - 4.1.3-1
 - Explicitly require C++17 in CMake to avoid compilation issues on strict compilers.
 - Fix static analysis warnings (clang-tidy) for safer singleton and regex initialization.
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include "appender/log_appender.hpp"
+#include "appender/socket_appender.hpp"
+#include "config/appender.hpp"
+
+namespace log4cpp::appender {
+    /**
+     * @brief A socket appender over several endpoints, one socket_appender each.
+     *
+     * Each endpoint has its own connection, send queue, I/O thread and reconnection backoff. A record goes to the
+     * endpoint the balance policy picks, or to the next connected one if that one is down. When none is connected it
+     * goes to the picked one, which spills or drops it. With a spill file each endpoint spills to
+     * "<spill-file>.<index>".
+     */
+    class balanced_socket_appender: public log_appender {
+    public:
+        explicit balanced_socket_appender(const config::socket_appender &cfg);
+
+        balanced_socket_appender(const balanced_socket_appender &other) = delete;
+
+        balanced_socket_appender(balanced_socket_appender &&other) = delete;
+
+        balanced_socket_appender &operator=(const balanced_socket_appender &other) = delete;
+
+        balanced_socket_appender &operator=(balanced_socket_appender &&other) = delete;
+
+        /**
+         * @brief Round-robin, without a logger to hash
+         */
+        void log(const char *msg, size_t msg_len) override;
+
+        void log_keyed(uint32_t logger_key, const char *msg, size_t msg_len) override;
+
+        ~balanced_socket_appender() override = default;
+
+    private:
+        /**
+         * @brief The first connected endpoint from index on, or the one at index if none is
+         */
+        socket_appender &pick(size_t index) const;
+
+        std::vector<std::unique_ptr<socket_appender>> endpoints;
+        config::balance_policy balance;
+        /* The round-robin position */
+        std::atomic<size_t> next{0};
+    };
+} // namespace log4cpp::appender
@@ -1,6 +1,16 @@
 #pragma once
 
+#include <condition_variable>
+#include <ctime>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "appender/file_archiver.hpp"
+#include "appender/file_syncer.hpp"
 #include "appender/log_appender.hpp"
+#include "appender/uring_writer.hpp"
 #include "common/log_lock.hpp"
 #include "config/appender.hpp"
 
@@ -18,11 +28,85 @@ namespace log4cpp::appender {
 
         void log(const char *msg, size_t msg_len) override;
 
+        void flush() override;
+
+        /**
+         * @brief Write out the buffer and fdatasync() the file. The lock is released before the sync, writers go on.
+         */
+        void sync() override;
+
         ~file_appender() override;
 
     private:
+        /**
+         * @brief Write straight to the file, retrying short writes.
+         */
+        void write_out(const char *msg, size_t msg_len) const;
+
+        /**
+         * @brief Write the buffer, then msg, with a single syscall where the platform has writev(). With io_uring msg
+         * is copied through the buffers instead.
+         */
+        void write_buffer_and(const char *msg, size_t msg_len);
+
+        /**
+         * @brief Hand the buffer to the kernel and empty it. With io_uring the write goes on in the background, until
+         * wait_written().
+         */
+        void write_buffer();
+
+        /**
+         * @brief Wait until every record handed to the kernel is written.
+         */
+        void wait_written();
+
+        /**
+         * @brief Flush the buffer every flush_interval_ms until the appender is destroyed.
+         */
+        void run_flusher();
+
+        /**
+         * @brief Roll the file over if writing msg_len more bytes would pass max_file_size, or an interval ended.
+         */
+        void roll_if_due(size_t msg_len);
+
+        /**
+         * @brief Rename the file aside, reopen file_path and hand the old file to the archiver.
+         */
+        void roll();
+
         /* The fd of the log file */
         int fd{-1};
         common::log_lock lock;
+        std::string file_path;
+        /* The bytes written to the current file, buffered ones included */
+        size_t file_size{0};
+        size_t max_file_size{0};
+        config::rolling_interval rolling{config::rolling_interval::NONE};
+        std::time_t next_rollover{0};
+        /* Archives rolled files, nullptr when the file does not roll */
+        std::unique_ptr<file_archiver> archiver;
+        /* Records not written yet, nullptr when unbuffered */
+        std::unique_ptr<char[]> buffer;
+        size_t buffer_size{0};
+        size_t buffer_used{0};
+#ifdef __linux__
+        /* The other buffers of the uring, buffer is swapped with the next one on every submit */
+        std::vector<std::unique_ptr<char[]>> spares;
+        size_t next_spare{0};
+        /* Submits full buffers in "io-uring" mode, nullptr otherwise or if the kernel has no io_uring */
+        std::unique_ptr<uring_writer> uring;
+#endif
+
+        unsigned int flush_interval_ms{0};
+        std::thread flusher;
+        std::mutex flusher_mtx;
+        std::condition_variable flusher_cv;
+        bool flusher_stop{false};
+
+        /* Any durability setting is on, a rolled file is synced before it is closed */
+        bool durable{false};
+        /* Syncs every "sync-interval-ms" or "sync-bytes", nullptr if neither is set */
+        std::unique_ptr<file_syncer> syncer;
     };
 } // namespace log4cpp::appender
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <condition_variable>
+#include <ctime>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "config/appender.hpp"
+
+namespace log4cpp::appender {
+    /**
+     * @brief The start of the local hour or day after t.
+     */
+    std::time_t next_rollover_time(std::time_t t, config::rolling_interval interval);
+
+    /**
+     * @brief Compresses rolled log files and keeps the backups of a file appender, on a background thread.
+     *
+     * The file appender renames the full file to a unique name returned by next_rolled_path() and hands it over with
+     * submit(), the logging path never waits for compression. The thread then compresses it, shifts
+     * file_path.1 .. file_path.N one index up, deleting the oldest, and renames it to file_path.1. All renames of
+     * backups happen on this one thread, in the order the files were rolled.
+     *
+     * Rolled names are claimed process-wide from next_rolled_path() until archived. A new archiver, after a hot reload
+     * rebuilt the appender on the same path, adopts only the leftovers no live archiver has claimed, and the archivers
+     * of one file rotate its backups one at a time.
+     */
+    class file_archiver {
+    public:
+        explicit file_archiver(const config::file_appender &cfg);
+
+        file_archiver(const file_archiver &other) = delete;
+
+        file_archiver(file_archiver &&other) = delete;
+
+        file_archiver &operator=(const file_archiver &other) = delete;
+
+        file_archiver &operator=(file_archiver &&other) = delete;
+
+        /**
+         * @brief Archives the files already submitted, then stops the thread.
+         */
+        ~file_archiver();
+
+        /**
+         * @brief A name to rename the full log file to, unique, next to the log file. Claimed until it is archived,
+         * or until cancel() if the file is not rolled after all.
+         */
+        [[nodiscard]] std::string next_rolled_path() const;
+
+        /**
+         * @brief Give up a name from next_rolled_path() the log file could not be renamed to.
+         */
+        static void cancel(const std::string &rolled_path);
+
+        /**
+         * @brief Queue a rolled file for compression and rotation into the backups.
+         * @param rolled_path The file, renamed by next_rolled_path().
+         * @param release Run on the archiver thread before the file is read, for writers that still finish the file
+         * after handing it over.
+         */
+        void submit(std::string rolled_path, std::function<void()> release = nullptr);
+
+        /**
+         * @brief The name of backup index, file_path.index followed by the extension of the compression.
+         */
+        static std::string backup_path(const std::string &file_path, unsigned int index, config::compression compress);
+
+    private:
+        void run();
+
+        void archive(const std::string &rolled_path) const;
+
+        std::string file_path;
+        unsigned int max_backup_index;
+        config::compression compress;
+
+        std::thread worker;
+        std::mutex mtx;
+        std::condition_variable cv;
+        class rolled_file {
+        public:
+            std::string path;
+            std::function<void()> release;
+        };
+
+        std::deque<rolled_file> pending;
+        bool stop{false};
+    };
+} // namespace log4cpp::appender
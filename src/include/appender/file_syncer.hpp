@@ -0,0 +1,69 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+namespace log4cpp::appender {
+    /**
+     * @brief Makes a log file durable from a background thread, every interval and every so many bytes.
+     *
+     * The logging path only counts its bytes with written(), an atomic add. Crossing the byte limit wakes the thread,
+     * no logging thread ever waits for the disk.
+     */
+    class file_syncer {
+    public:
+        /**
+         * @param interval Sync every interval milliseconds, 0 only on the byte limit.
+         * @param bytes Sync once this many bytes were written since the last sync, 0 only on the interval.
+         * @param sync_file Does the sync, called on the syncer thread.
+         */
+        file_syncer(unsigned int interval, size_t bytes, std::function<void()> sync_file);
+
+        file_syncer(const file_syncer &other) = delete;
+
+        file_syncer(file_syncer &&other) = delete;
+
+        file_syncer &operator=(const file_syncer &other) = delete;
+
+        file_syncer &operator=(file_syncer &&other) = delete;
+
+        /**
+         * @brief Stops the thread, without a last sync.
+         */
+        ~file_syncer();
+
+        /**
+         * @brief Count n bytes written to the file.
+         */
+        void written(size_t n) {
+            if (0 == this->sync_bytes) {
+                return;
+            }
+            const size_t before = this->unsynced.fetch_add(n, std::memory_order_relaxed);
+            // Only the record crossing the limit wakes the thread
+            if (before < this->sync_bytes && before + n >= this->sync_bytes) {
+                wake();
+            }
+        }
+
+    private:
+        void wake();
+
+        void run();
+
+        unsigned int interval_ms;
+        size_t sync_bytes;
+        std::function<void()> sync;
+        /* Bytes written since the last sync */
+        std::atomic<size_t> unsynced{0};
+
+        std::thread worker;
+        std::mutex mtx;
+        std::condition_variable cv;
+        bool woken{false};
+        bool stop{false};
+    };
+} // namespace log4cpp::appender
@@ -1,6 +1,10 @@
 #pragma once
 
 #include <cstddef>
+#include <cstdint>
+#include <optional>
+
+#include <log4cpp/log4cpp.hpp>
 
 namespace log4cpp::appender {
     class log_appender {
@@ -12,6 +16,42 @@ namespace log4cpp::appender {
          */
         virtual void log(const char *msg, size_t msg_len) = 0;
 
+        /**
+         * @brief Write log to appender on behalf of a logger. Appenders that spread records over several
+         * destinations by logger override it, the others write the record with log().
+         * @param logger_key: A hash of the logger name, the same for every record of the logger
+         * @param msg: log message
+         * @param msg_len: the length of message
+         */
+        virtual void log_keyed(uint32_t logger_key, const char *msg, size_t msg_len) {
+            (void)logger_key;
+            log(msg, msg_len);
+        }
+
+        /**
+         * @brief Write out the records the appender still buffers. Called after ERROR and FATAL records.
+         */
+        virtual void flush() {
+        }
+
+        /**
+         * @brief Make the records written so far durable, the fdatasync() of a file. Called after the records
+         * sync_due() selects.
+         */
+        virtual void sync() {
+        }
+
+        /**
+         * @brief Whether a record at this level must be followed by sync()
+         */
+        [[nodiscard]] bool sync_due(log_level level) const {
+            return sync_level.has_value() && level <= sync_level.value();
+        }
+
         virtual ~log_appender() = default;
+
+    protected:
+        /* Records at this level or more severe are followed by sync(), none by default */
+        std::optional<log_level> sync_level;
     };
 } // namespace log4cpp::appender
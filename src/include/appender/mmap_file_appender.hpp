@@ -0,0 +1,80 @@
+#pragma once
+
+#ifndef _WIN32
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "appender/file_archiver.hpp"
+#include "appender/file_syncer.hpp"
+#include "appender/log_appender.hpp"
+#include "config/appender.hpp"
+
+namespace log4cpp::appender {
+    class mapped_file;
+
+    /**
+     * @brief A file appender that copies records into a shared mapping of the file, without a lock or a syscall.
+     *
+     * The file is extended with posix_fallocate() and mapped in chunks. A writer reserves its bytes with one
+     * fetch_add on the write offset and copies the record in, threads write concurrently, and the page cache writes
+     * the pages back. While open, the file is longer than its content, padded with zeros up to the end of the last
+     * chunk. It is truncated to its real length when it is closed or rolled over; if the process dies first, the next
+     * appender to open the file writes over the padding.
+     *
+     * The file rolls over like the file_appender does, by size (approximately, records reserved concurrently with the
+     * check may pass max-file-size) or by time.
+     */
+    class mmap_file_appender: public log_appender {
+    public:
+        explicit mmap_file_appender(const config::file_appender &cfg);
+
+        mmap_file_appender(const mmap_file_appender &other) = delete;
+
+        mmap_file_appender(mmap_file_appender &&other) = delete;
+
+        mmap_file_appender &operator=(const mmap_file_appender &other) = delete;
+
+        mmap_file_appender &operator=(mmap_file_appender &&other) = delete;
+
+        void log(const char *msg, size_t msg_len) override;
+
+        /**
+         * @brief fdatasync() the file, the kernel writes back the pages dirtied through the mapping.
+         */
+        void sync() override;
+
+        ~mmap_file_appender() override;
+
+    private:
+        /**
+         * @brief Whether writing msg_len more bytes to file should roll it over first.
+         */
+        [[nodiscard]] bool roll_due(const mapped_file *file, size_t msg_len) const;
+
+        /**
+         * @brief Rename file aside, publish a new mapping of file_path, and let the archiver close the old one once
+         * no writer uses it any more.
+         */
+        void roll(mapped_file *file);
+
+        std::string file_path;
+        size_t max_file_size{0};
+        config::rolling_interval rolling{config::rolling_interval::NONE};
+
+        /* The file written to, read inside an RCU read-side section */
+        std::atomic<mapped_file *> current{nullptr};
+        /* Serializes roll() */
+        std::mutex roll_mtx;
+        /* Archives rolled files, nullptr when the file does not roll */
+        std::unique_ptr<file_archiver> archiver;
+        /* Any durability setting is on, a rolled file is synced before it is closed */
+        bool durable{false};
+        /* Syncs every "sync-interval-ms" or "sync-bytes", nullptr if neither is set */
+        std::unique_ptr<file_syncer> syncer;
+    };
+} // namespace log4cpp::appender
+
+#endif
@@ -5,13 +5,27 @@
 #include <mutex>
 #include <optional>
 #include <thread>
+#include <vector>
 
 #include "appender/log_appender.hpp"
+#include "appender/spill_file.hpp"
 #include "common/log_net.hpp"
 #include "config/appender.hpp"
 
 namespace log4cpp::appender {
+    /* How long the destructor lets the I/O thread send the records still queued */
     constexpr std::chrono::seconds send_timeout = std::chrono::seconds(1);
+    /* How long the I/O thread waits at most for a slow peer to take more bytes before it looks for a stop */
+    constexpr std::chrono::milliseconds SEND_POLL_INTERVAL{100};
+    constexpr size_t UDP_PAYLOAD_MAX = config::SOCKET_DATAGRAM_SIZE_MAX;
+    /* The datagrams handed to one sendmmsg(), a batch this long is flushed before its flush interval ends */
+    constexpr size_t UDP_BATCH_MAX = 64;
+    /* Spilled records are replayed in slices of replay_rate / 10 bytes, one slice every interval */
+    constexpr std::chrono::milliseconds REPLAY_INTERVAL{100};
+    /* How often the I/O thread tries again to open a spill file another appender holds */
+    constexpr std::chrono::seconds SPILL_OPEN_RETRY{1};
+    /* The longest frame header: 20 digits of a 64-bit length and a space */
+    constexpr size_t FRAME_HEADER_MAX = 24;
 
     enum class connection_fsm_state : uint8_t { DISCONNECTED, IN_PROGRESS, ESTABLISHED };
 
@@ -23,6 +37,21 @@ namespace log4cpp::appender {
         connection_fsm_state state = connection_fsm_state::DISCONNECTED;
     };
 
+    /**
+     * @brief Sends records to a remote log server over TCP or UDP.
+     *
+     * Over TCP, log() only appends the record to a bounded send queue, a record that does not fit is dropped. The
+     * reconnect thread is also the I/O thread: it swaps the queue for an empty one and writes the whole batch with
+     * non-blocking send() calls, so a slow or stalled collector never blocks a logging thread. With framing, each
+     * record is queued behind its length header.
+     *
+     * Over UDP with a flush interval, records queue the same way, packed into datagrams of up to datagram_size bytes.
+     * The I/O thread flushes the batch with sendmmsg() once UDP_BATCH_MAX datagrams are queued or the interval ends.
+     *
+     * With a spill file, TCP records logged while the connection is down go to the file instead of being dropped.
+     * Once the connection is back the I/O thread replays them at replay_rate, and new records are spilled behind
+     * them until the file is empty, so the collector receives them in order.
+     */
     class socket_appender: public log_appender {
     public:
         explicit socket_appender(const config::socket_appender &cfg);
@@ -33,6 +62,11 @@ namespace log4cpp::appender {
         socket_appender &operator=(socket_appender &&other) = delete;
         void log(const char *msg, size_t msg_len) override;
 
+        /**
+         * @brief Whether records reach the peer now: the TCP connection is established, or the UDP socket is open
+         */
+        [[nodiscard]] bool connected() const;
+
     private:
         std::string host;
         unsigned short port{0};
@@ -41,13 +75,38 @@ namespace log4cpp::appender {
 
         std::shared_mutex connection_rw_lock;
         common::socket_fd sock_fd; // Socket file descriptor
-        connection_fsm_state connection_state;
+        /* Written under connection_rw_lock, read without it by log() */
+        std::atomic<connection_fsm_state> connection_state;
 
-        std::mutex reconnect_mutex;              // Mutex for reconnect condition variable
-        std::condition_variable reconnect_cv;    // Condition variable for reconnecting
+        std::mutex reconnect_mutex;              // Mutex for reconnect condition variable and the send queue
+        std::condition_variable reconnect_cv;    // Condition variable for reconnecting and queued records
+        /* TCP records waiting for the I/O thread, at most send_buffer_size bytes unless it holds one longer record */
+        std::vector<char> send_queue;
+        /* The batch the I/O thread is sending, swapped with send_queue while the logging threads fill that one */
+        std::vector<char> send_batch;
+        size_t send_buffer_size;
+        config::framing frame;
+        /* UDP batching, off when the interval is 0 */
+        std::chrono::milliseconds flush_interval;
+        size_t datagram_size;
+        /* The end offsets of the datagrams in send_queue and in send_batch */
+        std::vector<size_t> datagram_ends;
+        std::vector<size_t> batch_ends;
+        /* Guarded by reconnect_mutex, nullptr without a spill file or while another appender holds it */
+        std::unique_ptr<spill_file> spill;
+        std::string spill_path;
+        size_t spill_size;
+        size_t replay_rate;
+        /* When the I/O thread sends the next slice of spilled records */
+        std::chrono::steady_clock::time_point next_replay{};
+        /* The slice of spilled records at the end of send_batch, taken out of the spill file once sent */
+        size_t replay_bytes{0};
+        std::chrono::steady_clock::time_point next_spill_open{};
+        /* The spill file could not be opened, reported once */
+        bool spill_open_failed{false};
         std::atomic<bool> stop_reconnect{false}; // Flag to stop reconnect thread
         void reconnect_thread_routine();         // Reconnect thread function
-        std::thread reconnect_thread;            // Reconnect thread
+        std::thread reconnect_thread;            // Reconnect thread, the I/O thread of TCP and of batched UDP
         // Current delay for reconnection
         std::chrono::seconds reconnect_delay{0};
         // Initial delay for reconnection
@@ -60,7 +119,23 @@ namespace log4cpp::appender {
         void udp_init();
         void try_connect();
         void check_conn_status();
-        void wait_for_reconnect_or_stop();
+        /**
+         * @brief Wait for queued records or a stop, then send them, or replay a slice of the spilled records. Returns
+         * when the batch is out, the connection is lost, or the appender is stopping and the peer took nothing for
+         * send_timeout.
+         *
+         * With a spill file nothing is lost with the connection: the unsent records of the batch are kept for the next
+         * one, and spilled records leave the file only once sent.
+         */
+        void send_queued();
+        [[nodiscard]] bool wait_writable(std::chrono::milliseconds timeout) const;
+        void open_spill();
+        void queue_datagrams(const char *msg, size_t msg_len);
+        /**
+         * @brief Wait for a full batch, the flush interval or a stop, then send the queued datagrams.
+         */
+        void send_datagrams();
+        void udp_thread_routine();
         void schedule_backoff();
         void reset_backoff();
     };
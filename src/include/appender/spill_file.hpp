@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace log4cpp::appender {
+    class spill_header;
+
+    /**
+     * @brief A bounded queue of records in a memory-mapped file, where the socket appender keeps records while the
+     * connection is down.
+     *
+     * The file holds a small header (the capacity and the head and tail counters) and a ring of capacity bytes. Each
+     * record is stored behind its 4-byte length, so records are taken out whole. The header lives in the mapping too:
+     * records spilled by a process that exited are still there when the file is opened again, and are replayed then.
+     * Only the page cache keeps them across a crash, the file is not synced.
+     *
+     * Not thread-safe, the socket appender guards it with its queue mutex. The file is locked with flock(), a second
+     * spill_file on the same path fails to open until the first one is closed.
+     */
+    class spill_file {
+    public:
+        /**
+         * @brief Open or create path with a ring of capacity bytes.
+         * @return nullptr if the file can not be created or mapped, is locked by another spill_file, or on Windows
+         */
+        static std::unique_ptr<spill_file> open(const std::string &path, size_t capacity);
+
+        spill_file(const spill_file &other) = delete;
+
+        spill_file(spill_file &&other) = delete;
+
+        spill_file &operator=(const spill_file &other) = delete;
+
+        spill_file &operator=(spill_file &&other) = delete;
+
+        ~spill_file();
+
+        /**
+         * @brief Append one record made of prefix and data.
+         * @return false if there is no room for it, nothing was written then
+         */
+        bool push(const char *prefix, size_t prefix_len, const char *data, size_t len);
+
+        /**
+         * @brief Copy whole records to the end of out, oldest first, as long as they total at most max_bytes. The
+         * first record is copied even when it is longer. The records stay in the file until consume().
+         * @return The number of bytes appended to out
+         */
+        size_t peek(std::vector<char> &out, size_t max_bytes) const;
+
+        /**
+         * @brief Remove the oldest records, those that fit whole in bytes, once they have been sent.
+         */
+        void consume(size_t bytes);
+
+        /**
+         * @brief peek() and consume() what it copied.
+         */
+        size_t pop(std::vector<char> &out, size_t max_bytes);
+
+        [[nodiscard]] bool empty() const;
+
+        /**
+         * @brief The bytes in use, record headers included.
+         */
+        [[nodiscard]] size_t size() const;
+
+    private:
+        spill_file() = default;
+
+        void write_ring(uint64_t pos, const char *src, size_t len);
+
+        void read_ring(uint64_t pos, char *dst, size_t len) const;
+
+        int fd{-1};
+        void *map{nullptr};
+        size_t map_size{0};
+        /* The header at the start of the mapping, and the ring after it */
+        spill_header *hdr{nullptr};
+        char *ring{nullptr};
+        uint64_t capacity{0};
+    };
+} // namespace log4cpp::appender
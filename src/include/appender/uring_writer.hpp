@@ -0,0 +1,125 @@
+#pragma once
+
+#ifdef __linux__
+
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <vector>
+
+namespace log4cpp::appender {
+    /**
+     * @brief Writes buffers to a file through an io_uring, in the order they are handed over.
+     *
+     * write() queues the buffer and returns without waiting, the caller goes on filling another buffer. One write is
+     * in the kernel at a time, the file position of the next one is the end of the previous one; the next write is
+     * submitted when the completion of the previous one is reaped, by a later write() or wait(). wait() waits for the
+     * write of one buffer, or of all of them. The buffers are registered with the ring, the kernel does not map them
+     * again for every write.
+     *
+     * Talks to the kernel with the raw syscalls, liburing is not needed.
+     */
+    class uring_writer {
+    public:
+        /**
+         * @brief Set up a ring for writing from buffers[0 .. count - 1], each buffer_size bytes.
+         * @return nullptr if the kernel has no io_uring, forbids it (seccomp, io_uring_disabled), or lacks writes at
+         * the file position (before 5.6). The caller then writes with write().
+         */
+        static std::unique_ptr<uring_writer> create(char *const buffers[], size_t count, size_t buffer_size);
+
+        uring_writer(const uring_writer &other) = delete;
+
+        uring_writer(uring_writer &&other) = delete;
+
+        uring_writer &operator=(const uring_writer &other) = delete;
+
+        uring_writer &operator=(uring_writer &&other) = delete;
+
+        /**
+         * @brief Queue a write of buf to the position of fd behind the writes queued before, without waiting for it.
+         *
+         * buf lies in one of the buffers given to create(), whose previous write has completed, see wait(buf). It must
+         * stay untouched until then. A write the kernel does not take is done with write() when its turn comes.
+         * @return false if buf is not in one of the buffers, nothing was written then
+         */
+        bool write(int fd, const char *buf, size_t len);
+
+        /**
+         * @brief Wait for the write from the buffer holding buf and the ones queued before it. The rest of a short
+         * write is submitted again and waited for.
+         */
+        void wait(const char *buf);
+
+        /**
+         * @brief Wait for every queued write.
+         */
+        void wait();
+
+        ~uring_writer();
+
+    private:
+        uring_writer() = default;
+
+        class request {
+        public:
+            int fd{-1};
+            /* The rest to write, after a short write */
+            const char *buf{nullptr};
+            size_t len{0};
+            bool busy{false};
+        };
+
+        /**
+         * @brief The index of the buffer holding data, buffers.size() if none does.
+         */
+        [[nodiscard]] size_t buffer_of(const char *data) const;
+
+        /**
+         * @brief Queue a write SQE for the request of buffer index and enter the kernel.
+         */
+        bool submit(size_t index);
+
+        /**
+         * @brief Submit the request at the front of the queue, unless it is in flight already. Requests the kernel
+         * refuses are written with write().
+         */
+        void start();
+
+        /**
+         * @brief Handle one completion, waiting for it if block is set.
+         * @return false if there was none
+         */
+        bool reap(bool block);
+
+        int ring_fd{-1};
+        /* The SQ and CQ rings, one mapping when the kernel has IORING_FEAT_SINGLE_MMAP */
+        void *sq_ring{nullptr};
+        size_t sq_ring_size{0};
+        void *cq_ring{nullptr};
+        size_t cq_ring_size{0};
+        void *sqes{nullptr};
+        size_t sqes_size{0};
+
+        unsigned int *sq_tail{nullptr};
+        unsigned int sq_mask{0};
+        unsigned int *sq_array{nullptr};
+        unsigned int *cq_head{nullptr};
+        unsigned int *cq_tail{nullptr};
+        unsigned int cq_mask{0};
+        void *cqes{nullptr};
+
+        /* The registered buffers, to find the index of the one written */
+        std::vector<char *> buffers;
+        size_t buffer_size{0};
+        bool fixed{false};
+
+        /* The write of each buffer, the SQE user_data is its index */
+        std::vector<request> requests;
+        /* The buffers to write, in order, the front one is in flight if submitted is set */
+        std::deque<size_t> queued;
+        bool submitted{false};
+    };
+} // namespace log4cpp::appender
+
+#endif
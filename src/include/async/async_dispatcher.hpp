@@ -0,0 +1,279 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include <log4cpp/log4cpp.hpp>
+
+#include "appender/log_appender.hpp"
+#include "common/ring_buffer.hpp"
+#include "config/log4cpp.hpp"
+#include "pattern/log_pattern.hpp"
+
+namespace log4cpp::async {
+    /* The appenders of a logger, shared by the logger and the records it has queued. */
+    using appender_list = std::vector<std::shared_ptr<appender::log_appender>>;
+
+    /**
+     * @brief How a logger reacts to a full queue, and where it counts the records it loses.
+     */
+    class overflow_control {
+    public:
+        config::overflow_policy policy{config::overflow_policy::BLOCK};
+        /* DROP_BELOW_LEVEL keeps records at this level or more severe */
+        log_level level{log_level::WARN};
+        /* Incremented for every dropped record of the logger, may be nullptr */
+        std::atomic<uint64_t> *dropped{nullptr};
+    };
+
+    /* A deferred record holds at most this many arguments, calls with more are formatted by the caller */
+    constexpr size_t DEFERRED_ARGS_MAX = 16;
+
+    /* The dispatcher keeps up to this many buffers of lines too long for a queue cell for reuse */
+    constexpr size_t LARGE_BUFFER_POOL_MAX = 4;
+
+    /**
+     * @brief What the backend thread needs to format the deferred records of a logger. Immutable once shared.
+     */
+    class deferred_source {
+    public:
+        std::string name;
+        pattern::log_pattern pattern;
+        /* The longest line the backend formats for the logger */
+        size_t max_line_size{config::MAX_LINE_SIZE_DEFAULT};
+    };
+
+    enum class submit_result : uint8_t {
+        // The record is in the queue
+        QUEUED,
+        // The overflow policy discarded the record
+        DROPPED,
+        // The dispatcher is shut down, the caller should write the record itself
+        REJECTED
+    };
+
+    /**
+     * @brief A log line waiting in the queue.
+     *
+     * Records live in the ring cells and are reused. Usually the text is formatted in place by the producer. A line
+     * longer than text is formatted into large instead, a buffer from the dispatcher's pool. A deferred record
+     * (source set) instead holds the raw arguments of a typed format API call in text, and the backend thread formats
+     * the line.
+     */
+    class async_record {
+    public:
+        log_level level{log_level::INFO};
+        /* The length of the line, or of the stored arguments of a deferred record */
+        size_t len{0};
+        /* Where the line goes, holding it keeps the appenders alive until the backend has written it */
+        std::shared_ptr<const appender_list> appenders;
+        /* The drop counter of the logger, in case DROP_OLDEST evicts the record */
+        std::atomic<uint64_t> *dropped{nullptr};
+        /* The hash of the logger name, see log_appender::log_keyed() */
+        uint32_t logger_key{0};
+        /* The logger of a deferred record, nullptr if text is the formatted line */
+        std::shared_ptr<const deferred_source> source;
+        /* The format string of a deferred record, a string literal */
+        std::string_view fmt;
+        size_t arg_count{0};
+        /* The time and thread of a deferred record's log call */
+        pattern::line_origin origin;
+        alignas(format::format_arg) char text[LOG_LINE_MAX]{};
+        /* The line if it is too long for text, empty otherwise. Moved out by the backend, so the cell does not keep
+         * the memory */
+        std::vector<char> large;
+
+        /**
+         * @brief Copy the arguments of a typed format API call into text, strings included.
+         * @param args: The arguments, args.fmt must be a string literal
+         * @return false if they do not fit, the caller formats the line itself then
+         */
+        bool store_args(const format::format_args &args);
+
+        /**
+         * @brief Rebuild the arguments stored by store_args()
+         * @param out: Receives arg_count arguments, strings point into text
+         * @return The format string and arguments
+         */
+        format::format_args load_args(format::format_arg *out) const;
+    };
+
+    /**
+     * @class async_dispatcher
+     * @brief The asynchronous logging pipeline: a bounded lock-free queue and the backend thread draining it.
+     *
+     * Producers (the threads calling the logger) format the line directly into a queue cell and return, the
+     * backend thread copies it out, frees the cell and writes it to the appenders. With deferred formatting,
+     * producers store the raw arguments of typed format API calls and the backend thread formats them. When the
+     * queue is full the logger's overflow_control decides whether the producer waits for a free cell or a record is
+     * dropped. After shutdown() records are no longer accepted and the caller writes them synchronously.
+     */
+    class async_dispatcher {
+    public:
+        explicit async_dispatcher(const config::async_mode &cfg);
+
+        async_dispatcher(const async_dispatcher &other) = delete;
+
+        async_dispatcher(async_dispatcher &&other) = delete;
+
+        async_dispatcher &operator=(const async_dispatcher &other) = delete;
+
+        async_dispatcher &operator=(async_dispatcher &&other) = delete;
+
+        ~async_dispatcher();
+
+        [[nodiscard]] const config::async_mode &get_config() const {
+            return cfg_;
+        }
+
+        /**
+         * @brief Queue a log line for the backend thread
+         * @param level: The log level of the line
+         * @param overflow: What to do if the queue is full
+         * @param appenders: The appenders to write the line to
+         * @param format: Called as format(char *buf, size_t len) -> size_t to render the line into the queue cell,
+         * not called if the line is dropped or rejected
+         */
+        template<typename Formatter>
+        submit_result submit(log_level level, const overflow_control &overflow,
+                             const std::shared_ptr<const appender_list> &appenders, Formatter &&format) {
+            return submit_record(level, overflow, appenders, [&format](async_record &record) {
+                record.len = format(record.text, sizeof(record.text));
+            });
+        }
+
+        /**
+         * @brief Queue a record for the backend thread
+         * @param level: The log level of the record
+         * @param overflow: What to do if the queue is full
+         * @param appenders: The appenders to write the line to
+         * @param fill: Called as fill(async_record &) to set len and text (or large, or the deferred fields) of the
+         * record in its queue cell, not called if the record is dropped or rejected
+         */
+        template<typename Filler>
+        submit_result submit_record(log_level level, const overflow_control &overflow,
+                                    const std::shared_ptr<const appender_list> &appenders, Filler &&fill) {
+            producers_.fetch_add(1, std::memory_order_seq_cst);
+            if (stopping_.load(std::memory_order_seq_cst)) {
+                producers_.fetch_sub(1, std::memory_order_release);
+                return submit_result::REJECTED;
+            }
+            const bool expendable =
+                config::overflow_policy::DROP_BELOW_LEVEL == overflow.policy && level > overflow.level;
+            typename common::ring_buffer<async_record>::slot slot;
+            if (!expendable || ring_.size() < high_water_) {
+                slot = ring_.claim_push();
+            }
+            while (!slot) {
+                if (expendable || config::overflow_policy::DROP_NEWEST == overflow.policy) {
+                    count_drop(overflow.dropped);
+                    producers_.fetch_sub(1, std::memory_order_release);
+                    return submit_result::DROPPED;
+                }
+                if (config::overflow_policy::DROP_OLDEST == overflow.policy) {
+                    discard_oldest();
+                }
+                else {
+                    // Full: the backend is busy writing, sleep until it frees a cell
+                    wake_backend();
+                    wait_for_room();
+                }
+                slot = ring_.claim_push();
+            }
+            async_record &record = *slot.data;
+            record.level = level;
+            record.appenders = appenders;
+            record.dropped = overflow.dropped;
+            record.logger_key = 0;
+            fill(record);
+            ring_.publish(slot);
+            producers_.fetch_sub(1, std::memory_order_release);
+            wake_backend();
+            return submit_result::QUEUED;
+        }
+
+        /**
+         * @brief A buffer for a line too long for a queue cell, from the pool if there is one. It goes back to the
+         * pool once the backend has written the line.
+         */
+        std::vector<char> take_large_buffer();
+
+        /**
+         * @brief Stop accepting records, write everything already queued and join the backend thread.
+         *
+         * Safe to call more than once.
+         */
+        void shutdown();
+
+    private:
+        // Wake the backend thread if it is waiting for records.
+        void wake_backend() {
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (backend_idle_.load(std::memory_order_relaxed)) {
+                std::lock_guard<std::mutex> lock(idle_mtx_);
+                idle_cv_.notify_one();
+            }
+        }
+
+        // Sleep until the backend frees a cell, for a BLOCK producer facing a full queue.
+        void wait_for_room();
+
+        // Wake a producer waiting in wait_for_room(), after a cell has been freed.
+        void wake_producer() {
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (blocked_producers_.load(std::memory_order_relaxed) > 0) {
+                std::lock_guard<std::mutex> lock(room_mtx_);
+                room_cv_.notify_one();
+            }
+        }
+
+        static void count_drop(std::atomic<uint64_t> *dropped) {
+            if (dropped != nullptr) {
+                dropped->fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+
+        // Remove the oldest queued record without writing it (DROP_OLDEST).
+        void discard_oldest();
+
+        // Keep a buffer from take_large_buffer() for reuse, unless the pool is full or the buffer is oversized.
+        void return_large_buffer(std::vector<char> buffer);
+
+        // The backend thread main loop.
+        void run();
+
+        // Write the oldest queued record to its appenders, false if there is none.
+        bool dispatch_one();
+
+        config::async_mode cfg_;
+        common::ring_buffer<async_record> ring_;
+        /* DROP_BELOW_LEVEL starts dropping expendable records at this queue length, 3/4 of the capacity */
+        size_t high_water_;
+        /* Producers inside submit(), the backend only exits once it has seen none after stopping_ */
+        std::atomic<size_t> producers_{0};
+        std::atomic<bool> stopping_{false};
+        std::atomic<bool> backend_idle_{false};
+        std::mutex idle_mtx_;
+        std::condition_variable idle_cv_;
+        /* BLOCK producers sleeping on a full queue, woken by the backend as it frees cells */
+        std::atomic<size_t> blocked_producers_{0};
+        std::mutex room_mtx_;
+        std::condition_variable room_cv_;
+        std::mutex shutdown_mtx_;
+        /* The record being written, copied out of the ring by the backend thread */
+        async_record current_;
+        /* The line of a deferred record, formatted by the backend thread, grows to hold the longest line */
+        std::vector<char> line_ = std::vector<char>(LOG_LINE_MAX);
+        /* Buffers of long lines for reuse, taken by producers and returned by the backend */
+        std::mutex large_mtx_;
+        std::vector<std::vector<char>> large_pool_;
+        std::thread backend_;
+    };
+} // namespace log4cpp::async
@@ -0,0 +1,221 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdarg>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <utility>
+#include <vector>
+
+namespace log4cpp::common {
+    /**
+     * @brief An append-only writer used to execute a compiled pattern and the typed format API.
+     *
+     * Writing to a char array, output beyond its size is dropped. Writing to a vector, the vector grows to hold the
+     * whole line, up to a limit. The buffer is NUL-terminated by finish().
+     */
+    class line_writer {
+    public:
+        line_writer(char *buf, size_t size) : buf_(buf), cap_(size - 1), limit_(size - 1) {
+        }
+
+        /**
+         * @param buffer: Written from the start and resized as needed, must not be empty
+         * @param limit: The longest output, the rest is dropped
+         */
+        explicit line_writer(std::vector<char> &buffer, size_t limit = std::numeric_limits<size_t>::max()) :
+            buf_(buffer.data()), cap_(std::min(buffer.size() - 1, limit)), limit_(limit), growable_(&buffer) {
+        }
+
+        void append(const char *s, size_t n) {
+            if (n > cap_ - len_) {
+                n = make_room(n);
+            }
+            std::memcpy(buf_ + len_, s, n);
+            len_ += n;
+        }
+
+        void append(char c) {
+            if (len_ < cap_ || make_room(1) > 0) {
+                buf_[len_++] = c;
+            }
+        }
+
+        // printf-style, formatted straight into the buffer. args is not consumed, a pattern may print it twice.
+        void append_vprintf(const char *fmt, va_list args) {
+            va_list copy;
+            va_copy(copy, args);
+            const int n = vsnprintf(buf_ + len_, cap_ - len_ + 1, fmt, copy);
+            va_end(copy);
+            if (n <= 0) {
+                buf_[len_] = '\0';
+                return;
+            }
+            const auto need = static_cast<size_t>(n);
+            const size_t room = cap_ - len_;
+            if (need > room && make_room(need) > room) {
+                // Truncated, print again into the grown buffer
+                va_copy(copy, args);
+                vsnprintf(buf_ + len_, cap_ - len_ + 1, fmt, copy);
+                va_end(copy);
+            }
+            len_ += std::min(need, cap_ - len_);
+        }
+
+        // Zero-padded decimal, like printf("%0*lu")
+        void append_uint(unsigned long value, unsigned int min_digits) {
+            char digits[24];
+            size_t n = 0;
+            do {
+                digits[n++] = static_cast<char>('0' + value % 10);
+                value /= 10;
+            } while (value != 0);
+            for (size_t i = n; i < min_digits; ++i) {
+                append('0');
+            }
+            while (n > 0) {
+                append(digits[--n]);
+            }
+        }
+
+        // Zero-padded decimal, like printf("%0*d"), the sign counts towards the width
+        void append_int(long value, unsigned int min_digits) {
+            if (value < 0) {
+                append('-');
+                append_uint(0UL - static_cast<unsigned long>(value), min_digits > 0 ? min_digits - 1 : 0);
+            }
+            else {
+                append_uint(static_cast<unsigned long>(value), min_digits);
+            }
+        }
+
+        // `n` copies of `c`
+        void append(char c, size_t n) {
+            if (n > cap_ - len_) {
+                n = make_room(n);
+            }
+            std::memset(buf_ + len_, c, n);
+            len_ += n;
+        }
+
+        // Left-aligned, space-padded and truncated to width, like printf("%-*.*s")
+        void append_field(const char *s, size_t width) {
+            size_t n = strnlen(s, width);
+            append(s, n);
+            for (; n < width; ++n) {
+                append(' ');
+            }
+        }
+
+        size_t size() const {
+            return len_;
+        }
+
+        // Nothing more can be written
+        bool full() const {
+            return len_ == cap_ && cap_ >= limit_;
+        }
+
+        // Output was dropped for lack of room
+        bool truncated() const {
+            return truncated_;
+        }
+
+        size_t finish() {
+            buf_[len_] = '\0';
+            return len_;
+        }
+
+        // Ends the line with a newline, in place of the last character if the buffer is full. At least one
+        // character must fit.
+        size_t finish_line() {
+            if (len_ == cap_ && 0 == make_room(1)) {
+                --len_;
+            }
+            buf_[len_++] = '\n';
+            return finish();
+        }
+
+    private:
+        // Grows a vector buffer to take n more bytes, returns how many of them fit
+        size_t make_room(size_t n) {
+            if (nullptr != growable_ && cap_ < limit_) {
+                size_t cap = cap_;
+                while (cap - len_ < n && cap < limit_) {
+                    cap = cap > limit_ / 2 ? limit_ : cap * 2 + 1;
+                }
+                growable_->resize(cap + 1);
+                buf_ = growable_->data();
+                cap_ = cap;
+            }
+            if (n > cap_ - len_) {
+                truncated_ = true;
+                return cap_ - len_;
+            }
+            return n;
+        }
+
+        char *buf_;
+        size_t cap_;
+        size_t len_{0};
+        /* cap_ grows up to limit_, a vector buffer only */
+        size_t limit_;
+        std::vector<char> *growable_{nullptr};
+        bool truncated_{false};
+    };
+
+    /* A thread keeps a line buffer up to this size between lines, a larger one is freed */
+    constexpr size_t LINE_BUFFER_KEEP_MAX = 64 * 1024;
+
+    /**
+     * @brief Lends the calling thread its line buffer, so formatting a line does not allocate.
+     *
+     * The buffer is handed back when the loan ends. A nested loan on the same thread, from an appender that logs,
+     * gets a buffer of its own.
+     */
+    class thread_line_buffer {
+    public:
+        explicit thread_line_buffer(size_t initial_size) : buffer_(std::move(cached())) {
+            if (buffer_.size() < initial_size) {
+                buffer_.resize(initial_size);
+            }
+        }
+
+        ~thread_line_buffer() {
+            if (buffer_.size() <= LINE_BUFFER_KEEP_MAX) {
+                cached() = std::move(buffer_);
+            }
+        }
+
+        thread_line_buffer(const thread_line_buffer &other) = delete;
+
+        thread_line_buffer(thread_line_buffer &&other) = delete;
+
+        thread_line_buffer &operator=(const thread_line_buffer &other) = delete;
+
+        thread_line_buffer &operator=(thread_line_buffer &&other) = delete;
+
+        std::vector<char> &get() {
+            return buffer_;
+        }
+
+    private:
+        static std::vector<char> &cached() {
+            thread_local std::vector<char> buffer;
+            return buffer;
+        }
+
+        std::vector<char> buffer_;
+    };
+} // namespace log4cpp::common
+
+namespace log4cpp::format {
+    class format_args;
+
+    /**
+     * @brief Formats type-erased arguments into a writer, for a message that is part of a longer line.
+     */
+    void vformat_to(common::line_writer &writer, const format_args &args);
+} // namespace log4cpp::format
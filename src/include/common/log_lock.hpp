@@ -2,26 +2,36 @@
 
 #ifdef _MSC_VER
 #include <synchapi.h>
+#elif defined(__linux__)
+#include <atomic>
 #else
 #include <pthread.h>
 #endif
 
 namespace log4cpp::common {
+    /**
+     * @brief The lock of the console and file appenders: spins briefly, then sleeps in the kernel.
+     *
+     * The holder may be blocked in write() for as long as the disk or the terminal takes. Waiters spin for a bounded
+     * number of rounds, a few microseconds at most, enough when the holder only copies a record into a buffer, then
+     * park on a futex (Linux) or in the kernel wait of a critical section (Windows) until unlock() wakes one of them.
+     * Other platforms use a pthread_mutex_t. No waiter burns a core for the length of a syscall.
+     */
     class log_lock final {
     public:
         log_lock() {
 #ifdef _MSC_VER
             (void)InitializeCriticalSectionAndSpinCount(&_m_lock, 0x00000400);
-#else
-            pthread_spin_init(&_m_lock, PTHREAD_PROCESS_PRIVATE);
+#elif !defined(__linux__)
+            pthread_mutex_init(&_m_lock, nullptr);
 #endif
         }
 
         ~log_lock() {
 #ifdef _MSC_VER
             DeleteCriticalSection(&_m_lock);
-#else
-            pthread_spin_destroy(&_m_lock);
+#elif !defined(__linux__)
+            pthread_mutex_destroy(&_m_lock);
 #endif
         }
 
@@ -36,24 +46,48 @@ namespace log4cpp::common {
         void lock() {
 #ifdef _MSC_VER
             EnterCriticalSection(&_m_lock);
+#elif defined(__linux__)
+            int expected = UNLOCKED;
+            if (!_m_state.compare_exchange_strong(expected, LOCKED, std::memory_order_acquire,
+                                                  std::memory_order_relaxed)) {
+                lock_contended();
+            }
 #else
-            pthread_spin_lock(&_m_lock);
+            pthread_mutex_lock(&_m_lock);
 #endif
         }
 
         void unlock() {
 #ifdef _MSC_VER
             LeaveCriticalSection(&_m_lock);
+#elif defined(__linux__)
+            if (_m_state.exchange(UNLOCKED, std::memory_order_release) == CONTENDED) {
+                wake_one();
+            }
 #else
-            pthread_spin_unlock(&_m_lock);
+            pthread_mutex_unlock(&_m_lock);
 #endif
         }
 
     private:
 #ifdef _MSC_VER
         CRITICAL_SECTION _m_lock{};
+#elif defined(__linux__)
+        static constexpr int UNLOCKED = 0;
+        static constexpr int LOCKED = 1;
+        // Locked, and a thread may sleep on the futex: unlock() must wake it
+        static constexpr int CONTENDED = 2;
+
+        /**
+         * @brief Spin a bounded number of rounds, then sleep on the futex until the lock is free.
+         */
+        void lock_contended();
+
+        void wake_one();
+
+        std::atomic<int> _m_state{UNLOCKED};
 #else
-        pthread_spinlock_t _m_lock{};
+        pthread_mutex_t _m_lock{};
 #endif
     };
 } // namespace log4cpp::common
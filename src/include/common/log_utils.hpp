@@ -1,11 +1,33 @@
 #pragma once
 
 #include <cstddef>
+#include <ctime>
 #include <string>
 
 #include "log4cpp/log4cpp.hpp"
 
 namespace log4cpp::common {
+    /* The longest thread name, with the NUL, pthread_setname_np and prctl(PR_SET_NAME) take no more */
+    constexpr size_t THREAD_NAME_BUF_LEN = 16;
+
+    /**
+     * @brief The name and ID of a thread, as the thread name and ID placeholders show them.
+     */
+    class thread_identity {
+    public:
+        unsigned long id{0};
+        /* Empty if the thread has no name */
+        char name[THREAD_NAME_BUF_LEN]{};
+    };
+
+    /**
+     * @brief The name and ID of the calling thread, read from the system on the first call and cached per thread.
+     *
+     * set_thread_name() drops the cached name. A name set behind the library's back (pthread_setname_np, prctl) is
+     * not seen until then.
+     */
+    const thread_identity &current_thread_identity();
+
     /**
      * format a string
      * @param buf: the buffer to store the formatted string
@@ -54,6 +76,14 @@ namespace log4cpp::common {
      */
     void get_time_now(tm &now_tm, unsigned short &ms);
 
+    /**
+     * Convert a calendar time to local time. The result of the last conversion is cached per thread,
+     * so repeated calls within the same second do not call localtime_r (which takes the tz lock)
+     * @param t: seconds since epoch
+     * @param local_tm: local time of t
+     */
+    void get_local_time(std::time_t t, tm &local_tm);
+
     /**
      * std::string convert to lowercase
      * @param s: input string
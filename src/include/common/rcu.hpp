@@ -0,0 +1,43 @@
+#pragma once
+
+namespace log4cpp::common::rcu {
+    /**
+     * @brief Enter a read-side critical section. Sections nest.
+     *
+     * Inside a section, objects reached through a pointer published by a writer stay valid until read_unlock(), even
+     * if the writer replaces the pointer meanwhile. Entering and leaving only write the calling thread's own state,
+     * the cost is one full fence and no shared cache line traffic.
+     */
+    void read_lock();
+
+    /**
+     * @brief Leave a read-side critical section.
+     */
+    void read_unlock();
+
+    /**
+     * @brief Wait until every read-side critical section that might still see an old pointer has ended.
+     *
+     * Writers publish the new pointer first, then call synchronize(), then free the old object. Must not be called
+     * inside a read-side critical section, it would wait for itself.
+     */
+    void synchronize();
+
+    /**
+     * @brief RAII read-side critical section.
+     */
+    class read_guard {
+    public:
+        read_guard() {
+            read_lock();
+        }
+
+        ~read_guard() {
+            read_unlock();
+        }
+
+        read_guard(const read_guard &other) = delete;
+
+        read_guard &operator=(const read_guard &other) = delete;
+    };
+} // namespace log4cpp::common::rcu
@@ -0,0 +1,147 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+
+namespace log4cpp::common {
+    /**
+     * @class ring_buffer
+     * @brief A bounded lock-free multi-producer/multi-consumer ring (D. Vyukov's sequence-per-cell design).
+     *
+     * Both ends work in two steps so the payload can be produced or consumed in place, without a copy:
+     * claim_push() reserves a cell, the caller fills slot::data and calls publish(); claim_pop() reserves the
+     * oldest published cell, the caller reads slot::data and calls release(). A claimed but unpublished cell
+     * holds back consumers until it is published, so keep the work between the two calls short.
+     *
+     * @tparam T The cell payload, default-constructed once and reused for the lifetime of the ring.
+     */
+    template<typename T>
+    class ring_buffer {
+        struct cell {
+            std::atomic<size_t> sequence;
+            T data;
+        };
+
+    public:
+        class slot {
+        public:
+            T *data{nullptr};
+
+            explicit operator bool() const {
+                return data != nullptr;
+            }
+
+        private:
+            cell *cell_{nullptr};
+            size_t pos_{0};
+
+            friend class ring_buffer;
+        };
+
+        /**
+         * @param capacity: The number of cells, rounded up to a power of two (at least 2)
+         */
+        explicit ring_buffer(size_t capacity) {
+            size_t size = 2;
+            while (size < capacity) {
+                size <<= 1;
+            }
+            mask_ = size - 1;
+            cells_ = std::make_unique<cell[]>(size);
+            for (size_t i = 0; i < size; ++i) {
+                cells_[i].sequence.store(i, std::memory_order_relaxed);
+            }
+        }
+
+        ring_buffer(const ring_buffer &) = delete;
+
+        ring_buffer &operator=(const ring_buffer &) = delete;
+
+        [[nodiscard]] size_t capacity() const {
+            return mask_ + 1;
+        }
+
+        /**
+         * @brief The number of claimed cells, a snapshot that may be stale by the time it is used.
+         */
+        [[nodiscard]] size_t size() const {
+            const size_t head = dequeue_pos_.load(std::memory_order_relaxed);
+            const size_t tail = enqueue_pos_.load(std::memory_order_relaxed);
+            return tail > head ? tail - head : 0;
+        }
+
+        /**
+         * @brief Reserve the next free cell for writing.
+         * @return An empty slot if the ring is full
+         */
+        slot claim_push() {
+            slot s;
+            size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+            for (;;) {
+                cell *c = &cells_[pos & mask_];
+                const size_t seq = c->sequence.load(std::memory_order_acquire);
+                const auto diff = static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos);
+                if (0 == diff) {
+                    if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                        s.cell_ = c;
+                        s.pos_ = pos;
+                        s.data = &c->data;
+                        return s;
+                    }
+                }
+                else if (diff < 0) {
+                    return s;
+                }
+                else {
+                    pos = enqueue_pos_.load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+        // Make a cell reserved by claim_push() visible to consumers.
+        void publish(const slot &s) {
+            s.cell_->sequence.store(s.pos_ + 1, std::memory_order_release);
+        }
+
+        /**
+         * @brief Reserve the oldest published cell for reading.
+         * @return An empty slot if there is nothing to read
+         */
+        slot claim_pop() {
+            slot s;
+            size_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+            for (;;) {
+                cell *c = &cells_[pos & mask_];
+                const size_t seq = c->sequence.load(std::memory_order_acquire);
+                const auto diff = static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos + 1);
+                if (0 == diff) {
+                    if (dequeue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                        s.cell_ = c;
+                        s.pos_ = pos;
+                        s.data = &c->data;
+                        return s;
+                    }
+                }
+                else if (diff < 0) {
+                    return s;
+                }
+                else {
+                    pos = dequeue_pos_.load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+        // Hand a cell reserved by claim_pop() back to producers.
+        void release(const slot &s) {
+            s.cell_->sequence.store(s.pos_ + mask_ + 1, std::memory_order_release);
+        }
+
+    private:
+        std::unique_ptr<cell[]> cells_;
+        size_t mask_{0};
+        // Producers and consumers update different counters, keep them on different cache lines
+        alignas(64) std::atomic<size_t> enqueue_pos_{0};
+        alignas(64) std::atomic<size_t> dequeue_pos_{0};
+    };
+} // namespace log4cpp::common
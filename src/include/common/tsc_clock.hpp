@@ -0,0 +1,54 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+#define LOG4CPP_HAVE_TSC 1
+#endif
+
+namespace log4cpp::common::tsc_clock {
+    /**
+     * @brief Measure the rate of the CPU time stamp counter against the wall clock.
+     *
+     * The first call blocks for about 10 ms, later ones return at once. Without an invariant TSC (one that ticks at a
+     * constant rate in every P- and C-state, on every core) or off x86-64 the clock stays disabled, now() then reads
+     * std::chrono::system_clock.
+     * @return enabled()
+     */
+    bool calibrate();
+
+    /**
+     * @brief Whether calibrate() succeeded, ticks() may only be used then.
+     */
+    bool enabled();
+
+    /**
+     * @brief The raw time stamp counter, a few nanoseconds to read. Convert with to_time().
+     */
+    inline uint64_t ticks() {
+#ifdef LOG4CPP_HAVE_TSC
+        return __rdtsc();
+#else
+        return 0;
+#endif
+    }
+
+    /**
+     * @brief The wall clock time of a ticks() value.
+     *
+     * Extrapolates from the last calibration point. Once a second has passed since, the calling thread takes a new
+     * point against CLOCK_REALTIME, so the clock follows NTP adjustments and the rate estimate improves.
+     */
+    std::chrono::system_clock::time_point to_time(uint64_t tsc);
+
+    /**
+     * @brief The wall clock time, from the TSC if enabled(), from std::chrono::system_clock otherwise.
+     */
+    std::chrono::system_clock::time_point now();
+} // namespace log4cpp::common::tsc_clock
@@ -1,8 +1,16 @@
 #pragma once
 
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
 #include "common/json.hpp"
 #include "common/log_net.hpp"
 
+#include <log4cpp/log4cpp.hpp>
+
 namespace log4cpp::config {
     // =========================================================
     // console appender
@@ -29,12 +37,123 @@ namespace log4cpp::config {
     // file appender
     // =========================================================
 
+    constexpr unsigned int FILE_FLUSH_INTERVAL_MS_DEFAULT = 1000;
+    /* The write buffer of the io_uring mode when buffer-size is 0, it can not write records one by one */
+    constexpr size_t FILE_URING_BUFFER_SIZE_DEFAULT = 64 * 1024;
+    constexpr unsigned int FILE_MAX_BACKUP_INDEX_DEFAULT = 1;
+    constexpr unsigned int FILE_MAX_BACKUP_INDEX_MAX = 1000;
+
+    /**
+     * @brief Time based rollover of the log file, at the start of every local hour or day
+     */
+    enum class rolling_interval : uint8_t { NONE, HOURLY, DAILY };
+
+    class rolling_interval_attr {
+    public:
+        const char *name;
+        rolling_interval interval;
+    };
+
+    constexpr std::array<rolling_interval_attr, 3> ROLLING_INTERVAL_TABLE{
+        {{"none", rolling_interval::NONE}, {"hourly", rolling_interval::HOURLY}, {"daily", rolling_interval::DAILY}}};
+
+    void to_string(rolling_interval interval, std::string &str);
+
+    /**
+     * @brief Parse a rolling interval name (case-insensitive)
+     * @throw invalid_config_exception if the name is unknown
+     */
+    void from_string(const std::string &str, rolling_interval &interval);
+
+    /**
+     * @brief Compression of rolled log files
+     */
+    enum class compression : uint8_t { NONE, GZIP, ZSTD };
+
+    class compression_attr {
+    public:
+        const char *name;
+        compression compress;
+    };
+
+    constexpr std::array<compression_attr, 3> COMPRESSION_TABLE{
+        {{"none", compression::NONE}, {"gzip", compression::GZIP}, {"zstd", compression::ZSTD}}};
+
+    void to_string(compression compress, std::string &str);
+
+    /**
+     * @brief Parse a compression name (case-insensitive)
+     * @throw invalid_config_exception if the name is unknown, or the library was built without it
+     */
+    void from_string(const std::string &str, compression &compress);
+
+    /**
+     * @brief How the file appender writes: a write() per record or buffer, copies into a shared file mapping, or
+     * buffers submitted to io_uring
+     */
+    enum class write_mode : uint8_t { WRITE, MMAP, IO_URING };
+
+    class write_mode_attr {
+    public:
+        const char *name;
+        write_mode mode;
+    };
+
+    constexpr std::array<write_mode_attr, 3> WRITE_MODE_TABLE{
+        {{"write", write_mode::WRITE}, {"mmap", write_mode::MMAP}, {"io-uring", write_mode::IO_URING}}};
+
+    void to_string(write_mode mode, std::string &str);
+
+    /**
+     * @brief Parse a write mode name (case-insensitive)
+     * @throw invalid_config_exception if the name is unknown
+     */
+    void from_string(const std::string &str, write_mode &mode);
+
     class file_appender {
     public:
         std::string file_path;
+        /* The size of the write buffer in bytes, 0 writes every record with its own syscall */
+        size_t buffer_size{0};
+        /* The longest time a buffered record waits for its write, in milliseconds, 0 disables the timer */
+        unsigned int flush_interval_ms{FILE_FLUSH_INTERVAL_MS_DEFAULT};
+        /* Roll the file over before it grows past this size in bytes, 0 disables size based rollover */
+        size_t max_file_size{0};
+        /* The number of rolled files kept, file_path.1 being the newest */
+        unsigned int max_backup_index{FILE_MAX_BACKUP_INDEX_DEFAULT};
+        rolling_interval rolling{rolling_interval::NONE};
+        /* The compression of rolled files, done by a background thread */
+        compression compress{compression::NONE};
+        /* MMAP ignores buffer_size and flush_interval_ms, records go straight into the page cache. IO_URING always
+         * buffers, FILE_URING_BUFFER_SIZE_DEFAULT if buffer_size is 0 */
+        write_mode mode{write_mode::WRITE};
+        /* fdatasync() right after every record at this level or more severe, by the logging thread */
+        std::optional<log_level> sync_level;
+        /* fdatasync() every sync_interval_ms from a background thread, 0 disables it */
+        unsigned int sync_interval_ms{0};
+        /* fdatasync() from the background thread once this many bytes were written since the last one, 0 disables */
+        size_t sync_bytes{0};
+
+        /**
+         * @brief Whether any durability setting is on
+         */
+        [[nodiscard]] bool syncs() const {
+            return sync_level.has_value() || sync_interval_ms > 0 || sync_bytes > 0;
+        }
+
+        /**
+         * @brief Whether the file rolls over at all
+         */
+        [[nodiscard]] bool rolls() const {
+            return max_file_size > 0 || rolling != rolling_interval::NONE;
+        }
 
         friend bool operator==(const file_appender &lhs, const file_appender &rhs) {
-            return lhs.file_path == rhs.file_path;
+            return lhs.file_path == rhs.file_path && lhs.buffer_size == rhs.buffer_size &&
+                   lhs.flush_interval_ms == rhs.flush_interval_ms && lhs.max_file_size == rhs.max_file_size &&
+                   lhs.max_backup_index == rhs.max_backup_index && lhs.rolling == rhs.rolling &&
+                   lhs.compress == rhs.compress && lhs.mode == rhs.mode && lhs.sync_level == rhs.sync_level &&
+                   lhs.sync_interval_ms == rhs.sync_interval_ms && lhs.sync_bytes == rhs.sync_bytes;
         }
         friend bool operator!=(const file_appender &lhs, const file_appender &rhs) {
             return !(lhs == rhs);
@@ -45,20 +164,118 @@ namespace log4cpp::config {
 
     void from_json(const ::log4cpp::json_value &j, file_appender &config);
 
+    /**
+     * @brief Parse a size in bytes, a number or a string with an optional KB, MB or GB suffix ("100MB")
+     * @param key: The dotted name of the field for error messages, e.g. "file.max-file-size"
+     */
+    size_t parse_size(const ::log4cpp::json_value &j, const char *key);
+
     // =========================================================
     // socket appender
     // =========================================================
 
+    /**
+     * @brief How TCP records are delimited on the stream: by their newline, by a 4-byte big-endian length, or by
+     * RFC 6587 octet counting ("<length> <record>"). The framed modes send the record without its newline.
+     */
+    enum class framing : uint8_t { NONE, LENGTH_PREFIX, OCTET_COUNTING };
+
+    class framing_attr {
+    public:
+        const char *name;
+        framing frame;
+    };
+
+    constexpr std::array<framing_attr, 3> FRAMING_TABLE{{{"none", framing::NONE},
+                                                         {"length-prefix", framing::LENGTH_PREFIX},
+                                                         {"octet-counting", framing::OCTET_COUNTING}}};
+
+    void to_string(framing frame, std::string &str);
+
+    /**
+     * @brief Parse a framing name (case-insensitive)
+     * @throw invalid_config_exception if the name is unknown
+     */
+    void from_string(const std::string &str, framing &frame);
+
+    /**
+     * @brief How a socket appender with several endpoints picks the one a record goes to: the next one in turn, or
+     * by a hash of the logger name so each logger sticks to one collector. A record for an endpoint whose TCP
+     * connection is down goes to the next connected one.
+     */
+    enum class balance_policy : uint8_t { ROUND_ROBIN, HASH_BY_LOGGER };
+
+    class balance_policy_attr {
+    public:
+        const char *name;
+        balance_policy policy;
+    };
+
+    constexpr std::array<balance_policy_attr, 2> BALANCE_POLICY_TABLE{
+        {{"round-robin", balance_policy::ROUND_ROBIN}, {"hash-by-logger", balance_policy::HASH_BY_LOGGER}}};
+
+    void to_string(balance_policy policy, std::string &str);
+
+    /**
+     * @brief Parse a balance policy name (case-insensitive)
+     * @throw invalid_config_exception if the name is unknown
+     */
+    void from_string(const std::string &str, balance_policy &policy);
+
+    class socket_endpoint {
+    public:
+        std::string host;
+        unsigned short port{0};
+
+        friend bool operator==(const socket_endpoint &lhs, const socket_endpoint &rhs) {
+            return lhs.host == rhs.host && lhs.port == rhs.port;
+        }
+        friend bool operator!=(const socket_endpoint &lhs, const socket_endpoint &rhs) {
+            return !(lhs == rhs);
+        }
+    };
+
+    /* The bytes of records waiting for the network by default */
+    constexpr size_t SOCKET_SEND_BUFFER_SIZE_DEFAULT = 1024 * 1024;
+    /* The bounds of the spill file and of the replay rate by default */
+    constexpr size_t SOCKET_SPILL_SIZE_DEFAULT = 64 * 1024 * 1024;
+    constexpr size_t SOCKET_REPLAY_RATE_DEFAULT = 1024 * 1024;
+    /* The largest UDP payload over IPv4, 65535 - 8 (UDP header) - 20 (IP header) */
+    constexpr size_t SOCKET_DATAGRAM_SIZE_MAX = 65507;
+
     class socket_appender {
     public:
         enum class protocol : uint8_t { TCP, UDP };
+        /* The first endpoint */
         std::string host;
         unsigned short port{0};
+        /* All endpoints, host and port being the first, when there are several. Empty for a single one. */
+        std::vector<socket_endpoint> endpoints;
+        balance_policy balance{balance_policy::ROUND_ROBIN};
         protocol proto{protocol::TCP};
         common::prefer_stack prefer{common::prefer_stack::AUTO};
+        /* TCP and batched UDP records queue here for the I/O thread, a record that does not fit is dropped */
+        size_t send_buffer_size{SOCKET_SEND_BUFFER_SIZE_DEFAULT};
+        /* TCP only, a datagram is one record already */
+        framing frame{framing::NONE};
+        /* UDP only: the longest time a record waits in the batch, 0 sends every record from the logging thread */
+        unsigned int flush_interval_ms{0};
+        /* UDP only: pack short records into datagrams of up to this many bytes, 0 sends one record per datagram */
+        size_t datagram_size{0};
+        /* TCP only: keep records in this file while the connection is down, empty disables it */
+        std::string spill_file;
+        /* The bytes the spill file holds at most, further records are dropped */
+        size_t spill_size{SOCKET_SPILL_SIZE_DEFAULT};
+        /* The bytes per second spilled records are sent at once the connection is back */
+        size_t replay_rate{SOCKET_REPLAY_RATE_DEFAULT};
 
         friend bool operator==(const socket_appender &lhs, const socket_appender &rhs) {
-            return lhs.host == rhs.host && lhs.port == rhs.port && lhs.proto == rhs.proto && lhs.prefer == rhs.prefer;
+            return lhs.host == rhs.host && lhs.port == rhs.port && lhs.endpoints == rhs.endpoints &&
+                   lhs.balance == rhs.balance && lhs.proto == rhs.proto && lhs.prefer == rhs.prefer &&
+                   lhs.send_buffer_size == rhs.send_buffer_size && lhs.frame == rhs.frame &&
+                   lhs.flush_interval_ms == rhs.flush_interval_ms && lhs.datagram_size == rhs.datagram_size &&
+                   lhs.spill_file == rhs.spill_file && lhs.spill_size == rhs.spill_size &&
+                   lhs.replay_rate == rhs.replay_rate;
         }
         friend bool operator!=(const socket_appender &lhs, const socket_appender &rhs) {
             return !(lhs == rhs);
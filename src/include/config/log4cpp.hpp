@@ -1,6 +1,7 @@
 #pragma once
 
 #include <array>
+#include <map>
 #include <optional>
 #include <unordered_map>
 
@@ -26,16 +27,24 @@ namespace log4cpp::config {
 
     unsigned char appender_name_to_flag(const std::vector<std::string> &arr);
 
+    /**
+     * @brief Whether name is one of the APPENDER_TABLE names, not a named appender
+     */
+    bool is_builtin_appender(const std::string &name);
+
     class log_appender {
     public:
         std::optional<console_appender> console;
         std::optional<file_appender> file;
         std::optional<socket_appender> socket;
+        /* Named file appenders, "<name>": {"type": "file", ...}, each with its own file, fd and buffer */
+        std::map<std::string, file_appender> named_files;
 
         [[nodiscard]] bool empty() const;
 
         friend bool operator==(const log_appender &lhs, const log_appender &rhs) {
-            return lhs.console == rhs.console && lhs.file == rhs.file && lhs.socket == rhs.socket;
+            return lhs.console == rhs.console && lhs.file == rhs.file && lhs.socket == rhs.socket
+                   && lhs.named_files == rhs.named_files;
         }
 
         friend bool operator!=(const log_appender &lhs, const log_appender &rhs) {
@@ -47,14 +56,80 @@ namespace log4cpp::config {
 
     void from_json(const ::log4cpp::json_value &j, log_appender &config);
 
+    // =========================================================
+    // async mode
+    // =========================================================
+    constexpr size_t ASYNC_QUEUE_SIZE_DEFAULT = 4096;
+
+    class async_mode {
+    public:
+        /* The number of records the queue holds, rounded up to a power of two */
+        size_t queue_size{ASYNC_QUEUE_SIZE_DEFAULT};
+        /* The overflow policy of loggers that do not set their own */
+        config::overflow_policy overflow_policy{config::overflow_policy::BLOCK};
+        /* The overflow level of loggers that do not set their own */
+        log_level overflow_level{log_level::WARN};
+        /* Queue the arguments of the typed format API and let the backend thread format the line */
+        bool deferred_format{false};
+
+        friend bool operator==(const async_mode &lhs, const async_mode &rhs) {
+            return lhs.queue_size == rhs.queue_size && lhs.overflow_policy == rhs.overflow_policy
+                   && lhs.overflow_level == rhs.overflow_level && lhs.deferred_format == rhs.deferred_format;
+        }
+
+        friend bool operator!=(const async_mode &lhs, const async_mode &rhs) {
+            return !(lhs == rhs);
+        }
+    };
+
+    void to_json(::log4cpp::json_value &j, const async_mode &config);
+
+    void from_json(const ::log4cpp::json_value &j, async_mode &config);
+
+    // =========================================================
+    // clock enum + table
+    // =========================================================
+    /**
+     * @brief Where log lines take their timestamp: std::chrono::system_clock, or the CPU time stamp counter
+     * calibrated against it
+     */
+    enum class clock_source : uint8_t { SYSTEM, TSC };
+
+    class clock_attr {
+    public:
+        const char *name;
+        clock_source clock;
+    };
+
+    constexpr std::array<clock_attr, 2> CLOCK_TABLE{{{"system", clock_source::SYSTEM}, {"tsc", clock_source::TSC}}};
+
+    void to_string(clock_source clock, std::string &str);
+
+    /**
+     * @brief Parse a clock name (case-insensitive)
+     * @throw invalid_config_exception if the name is unknown
+     */
+    void from_string(const std::string &str, clock_source &clock);
+
+    // =========================================================
+    // log4cpp
+    // =========================================================
+    /* The longest line by default, the rest of a longer one is dropped */
+    constexpr size_t MAX_LINE_SIZE_DEFAULT = 1024 * 1024;
+
     class log4cpp {
     public:
         std::optional<std::string> log_pattern;          // log_pattern
+        std::optional<async_mode> async;                 // async, synchronous logging if absent
         log_appender appenders{};                        // appenders
         std::unordered_map<std::string, logger> loggers; // loggers
+        /* Lines up to LOG_LINE_MAX take the fixed-size path, longer ones a growable buffer up to this size */
+        size_t max_line_size{MAX_LINE_SIZE_DEFAULT}; // max-line-size
+        clock_source clock{clock_source::SYSTEM};    // clock
 
         friend bool operator==(const log4cpp &lhs, const log4cpp &rhs) {
-            return lhs.log_pattern == rhs.log_pattern && lhs.appenders == rhs.appenders && lhs.loggers == rhs.loggers;
+            return lhs.log_pattern == rhs.log_pattern && lhs.async == rhs.async && lhs.appenders == rhs.appenders
+                   && lhs.loggers == rhs.loggers && lhs.max_line_size == rhs.max_line_size && lhs.clock == rhs.clock;
         }
 
         friend bool operator!=(const log4cpp &lhs, const log4cpp &rhs) {
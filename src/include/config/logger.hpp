@@ -1,13 +1,50 @@
 #pragma once
 
+#include <array>
 #include <optional>
 #include <string>
+#include <vector>
 
 #include "common/json.hpp"
 
 #include <log4cpp/log4cpp.hpp>
 
 namespace log4cpp::config {
+    /**
+     * @enum overflow_policy
+     * @brief What a logger does with a record when the async queue is full.
+     */
+    enum class overflow_policy : uint8_t {
+        // Wait until the backend thread frees a cell
+        BLOCK,
+        // Discard the record being logged
+        DROP_NEWEST,
+        // Discard the oldest queued record to make room
+        DROP_OLDEST,
+        // Discard records less severe than the overflow level once the queue is 3/4 full, block for the others
+        DROP_BELOW_LEVEL
+    };
+
+    class overflow_policy_attr {
+    public:
+        const char *name;
+        overflow_policy policy;
+    };
+
+    constexpr std::array<overflow_policy_attr, 4> OVERFLOW_POLICY_TABLE{{{"block", overflow_policy::BLOCK},
+                                                                         {"drop-newest", overflow_policy::DROP_NEWEST},
+                                                                         {"drop-oldest", overflow_policy::DROP_OLDEST},
+                                                                         {"drop-below-level",
+                                                                          overflow_policy::DROP_BELOW_LEVEL}}};
+
+    void to_string(overflow_policy policy, std::string &str);
+
+    /**
+     * @brief Parse an overflow policy name (case-insensitive)
+     * @throw invalid_config_exception if the name is unknown
+     */
+    void from_string(const std::string &str, overflow_policy &policy);
+
     class logger {
     public:
         /* Logger name */
@@ -16,9 +53,17 @@ namespace log4cpp::config {
         std::optional<log_level> level;
         /* appender flag */
         unsigned char appender{};
+        /* Async queue overflow policy, inherits "root" then "async" if absent */
+        std::optional<config::overflow_policy> overflow_policy;
+        /* Records less severe than this are dropped first by DROP_BELOW_LEVEL */
+        std::optional<log_level> overflow_level;
+        /* The named appenders the logger writes to as well, see log_appender::named_files */
+        std::vector<std::string> named_appenders;
 
         friend bool operator==(const logger &lhs, const logger &rhs) {
-            return lhs.name == rhs.name && lhs.level == rhs.level && lhs.appender == rhs.appender;
+            return lhs.name == rhs.name && lhs.level == rhs.level && lhs.appender == rhs.appender
+                   && lhs.named_appenders == rhs.named_appenders && lhs.overflow_policy == rhs.overflow_policy
+                   && lhs.overflow_level == rhs.overflow_level;
         }
 
         friend bool operator!=(const logger &lhs, const logger &rhs) {
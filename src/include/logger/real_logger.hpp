@@ -1,18 +1,20 @@
 #pragma once
 
 #include <memory>
-#include <set>
 #include <string>
+#include <vector>
 
 #include <log4cpp/log4cpp.hpp>
 #include <log4cpp/logger.hpp>
 
+#include "async/async_dispatcher.hpp"
 #include "pattern/log_pattern.hpp"
 
 namespace log4cpp::appender {
     class log_appender;
 }
 
+
 namespace log4cpp {
     class real_logger: public logger {
     public:
@@ -34,9 +36,7 @@ namespace log4cpp {
             return name_;
         }
 
-        void set_name(const std::string &name) override {
-            this->name_ = name;
-        }
+        void set_name(const std::string &name) override;
 
         [[nodiscard]] log_level get_level() const override {
             return level_;
@@ -48,8 +48,40 @@ namespace log4cpp {
 
         void add_appender(const std::shared_ptr<appender::log_appender> &appender);
 
+        /**
+         * @brief Hand formatted lines to an asynchronous dispatcher instead of writing them on the calling thread.
+         * @param dispatcher: The dispatcher, nullptr for synchronous logging
+         * @param overflow: What to do when the dispatcher queue is full
+         */
+        void set_dispatcher(const std::shared_ptr<async::async_dispatcher> &dispatcher,
+                            const async::overflow_control &overflow = {});
+
+        /**
+         * @brief Set the longest line. Lines up to LOG_LINE_MAX are formatted into a fixed-size buffer, longer ones
+         * into a growable one, up to max_line_size bytes.
+         * @param max_line_size: The longest line, including the newline
+         */
+        void set_max_line_size(size_t max_line_size);
+
+        /**
+         * @brief Set the clock the timestamps are read from.
+         * @param clock: config::clock_source::TSC for the calibrated time stamp counter, SYSTEM for system_clock
+         */
+        void set_clock(config::clock_source clock);
+
+        // The typed format API templates of the base class
+        using logger::log;
+        using logger::fatal;
+        using logger::error;
+        using logger::warn;
+        using logger::info;
+        using logger::debug;
+        using logger::trace;
+
         void log(log_level _level, const char *__restrict fmt, va_list args) const override;
 
+        void log(log_level _level, const format::format_args &args) const override;
+
         void fatal(const char *__restrict fmt, ...) const override;
 
         void error(const char *__restrict fmt, ...) const override;
@@ -69,14 +101,34 @@ namespace log4cpp {
         friend class log4cpp_config;
 
     private:
+        /**
+         * @brief Write one line to the appenders, or queue it for the async dispatcher.
+         * @param _level: The log level of the line, already checked against the logger level
+         * @param render: Called as render(common::line_writer &) -> size_t to format the line
+         * @param defer: Called as defer(async::async_record &) -> bool in async mode to queue the line unformatted,
+         * render() formats it into the record if this returns false
+         */
+        template<typename Render, typename Defer>
+        void write_line(log_level _level, Render &&render, Defer &&defer) const;
+
         /* The logger name. */
         std::string name_;
+        /* The hash of the name, appenders spreading records over several destinations route by it. */
+        uint32_t logger_key_{0};
         /* The log level. */
         log_level level_;
         mutable std::shared_mutex appenders_mtx;
-        /* The log appenders. */
-        std::set<std::shared_ptr<appender::log_appender>> appenders;
+        /* The log appenders, copied on write so queued async records can share the list. */
+        std::shared_ptr<const async::appender_list> appenders;
         /* The log pattern formatter. */
         pattern::log_pattern pattern_;
+        /* The async dispatcher, nullptr in synchronous mode. */
+        std::shared_ptr<async::async_dispatcher> dispatcher_;
+        /* The overflow policy of this logger in async mode. */
+        async::overflow_control overflow_;
+        /* The name and pattern for the backend thread, nullptr unless the dispatcher defers formatting. */
+        std::shared_ptr<const async::deferred_source> deferred_;
+        /* The longest line, the rest of a longer one is dropped. */
+        size_t max_line_size_{config::MAX_LINE_SIZE_DEFAULT};
     };
 } // namespace log4cpp
@@ -1,11 +1,15 @@
 #pragma once
 
 #include <array>
+#include <chrono>
 #include <cstddef>
 #include <string>
+#include <vector>
 
 #include <log4cpp/log4cpp.hpp>
 
+#include "common/line_writer.hpp"
+
 namespace log4cpp::pattern {
     constexpr unsigned int LOGGER_NAME_DEFAULT_LEN = 6;
     constexpr unsigned int LOGGER_NAME_MAX_LEN = 64;
@@ -16,18 +20,94 @@ namespace log4cpp::pattern {
     constexpr std::array<const char *, 12> MONTH_ABBR_NAME = {"Jan", "Feb", "Mar", "Apr", "May", "Jun",
                                                               "Jul", "Aug", "Sep", "Oct", "Nov", "Dec"};
 
+    /**
+     * @enum segment_type
+     * @brief The kind of a compiled pattern segment. Everything except LITERAL is a placeholder.
+     */
+    enum class segment_type : uint8_t {
+        LITERAL,
+        SHORT_YEAR,
+        FULL_YEAR,
+        SHORT_MONTH,
+        FULL_MONTH,
+        ABBR_MONTH,
+        SHORT_DAY,
+        FULL_DAY,
+        SHORT_12HOUR,
+        FULL_12HOUR,
+        SHORT_24HOUR,
+        FULL_24HOUR,
+        SHORT_MINUTES,
+        FULL_MINUTES,
+        SHORT_SECOND,
+        FULL_SECOND,
+        MILLISECOND,
+        // " AM"/" PM" suffix, inserted after the last time segment when a 12-hour placeholder is used.
+        MERIDIEM,
+        LOGGER_NAME,
+        THREAD_NAME,
+        THREAD_ID,
+        LOG_LEVEL,
+        LOG_MESSAGE
+    };
+
+    /**
+     * @brief One step of a compiled log pattern.
+     *
+     * For LITERAL segments `text` is the literal to copy. For placeholders `text` is the placeholder as written in
+     * the pattern (e.g. "${8TN}") and `width` is the resolved field width, if the placeholder has one.
+     */
+    struct pattern_segment {
+        segment_type type{segment_type::LITERAL};
+        unsigned int width{0};
+        std::string text;
+    };
+
+    /**
+     * @brief Compile a pattern string into a flat list of segments.
+     *
+     * Adjacent literals are merged, unknown placeholders are kept as literals.
+     * @param pattern: The pattern string, e.g. "${yyyy}-${MM}-${dd} [${L}] -- ${msg}"
+     * @return The compiled segments in output order
+     */
+    std::vector<pattern_segment> compile_pattern(const std::string &pattern);
+
     void format_day(char *buf, size_t len, const std::string &pattern, const tm &now_tm);
 
     void format_time(char *buf, size_t len, const std::string &pattern, const tm &now_tm, unsigned short ms);
 
     void format_daytime(char *buf, size_t len, const std::string &pattern, const tm &now_tm, unsigned short ms);
 
+    /**
+     * @brief When and on which thread a log line was produced, captured by the logging thread for a line that is
+     * rendered later by another thread.
+     */
+    class line_origin {
+    public:
+        std::chrono::system_clock::time_point time;
+        // The time stamp counter at the log call, converted to time by the formatting thread. 0 if time is set.
+        uint64_t tsc{0};
+        unsigned long thread_id{0};
+        // Empty if the thread has no name
+        char thread_name[THREAD_NAME_MAX_LEN]{};
+        // false if the pattern has no thread placeholder, thread_id and thread_name are not set then
+        bool thread_resolved{false};
+    };
+
     class log_pattern {
     public:
         explicit log_pattern(const std::string &pattern = DEFAULT_LOG_PATTERN);
 
         void set_pattern(const std::string &pattern);
 
+        /**
+         * Take timestamps from the calibrated time stamp counter (common::tsc_clock) instead of
+         * std::chrono::system_clock. Calibrates the clock on first use, it stays on system_clock if there is no
+         * invariant TSC.
+         * @param enable: true for the TSC clock
+         */
+        void set_tsc_clock(bool enable);
+
         /**
          * Format the log message
          * @param buf: The buffer to store the formatted message
@@ -54,17 +134,99 @@ namespace log4cpp::pattern {
         size_t format(char *__restrict buf, size_t buf_len, const char *name, log_level level, const char *fmt,
                       ...) const;
 
+        /**
+         * Format the log message of the typed format API
+         * @param buf: The buffer to store the formatted message
+         * @param buf_len: The length of the buffer
+         * @param name: The logger name
+         * @param level: The log level
+         * @param args: The format string and the arguments
+         * @return The length of the formatted message
+         */
+        size_t format(char *__restrict buf, size_t buf_len, const char *name, log_level level,
+                      const format::format_args &args) const;
+
+        /**
+         * Format the log message of the typed format API on behalf of another thread
+         * @param buf: The buffer to store the formatted message
+         * @param buf_len: The length of the buffer
+         * @param name: The logger name
+         * @param level: The log level
+         * @param origin: The time and thread of the log call, from capture_origin()
+         * @param args: The format string and the arguments
+         * @return The length of the formatted message
+         */
+        size_t format(char *__restrict buf, size_t buf_len, const char *name, log_level level,
+                      const line_origin &origin, const format::format_args &args) const;
+
+        /**
+         * Format the log message into a writer, the message is rendered in place
+         * @param writer: Receives the line, a vector-backed writer grows to hold all of it
+         * @param name: The logger name
+         * @param level: The log level
+         * @param fmt: The format string
+         * @param args: The arguments
+         * @return The length of the formatted message
+         */
+        size_t format(common::line_writer &writer, const char *name, log_level level, const char *fmt,
+                      va_list args) const;
+
+        /**
+         * Format the log message of the typed format API into a writer, the message is rendered in place
+         * @param writer: Receives the line, a vector-backed writer grows to hold all of it
+         * @param name: The logger name
+         * @param level: The log level
+         * @param args: The format string and the arguments
+         * @return The length of the formatted message
+         */
+        size_t format(common::line_writer &writer, const char *name, log_level level,
+                      const format::format_args &args) const;
+
+        /**
+         * Format the log message of the typed format API into a writer on behalf of another thread
+         * @param writer: Receives the line, a vector-backed writer grows to hold all of it
+         * @param name: The logger name
+         * @param level: The log level
+         * @param origin: The time and thread of the log call, from capture_origin()
+         * @param args: The format string and the arguments
+         * @return The length of the formatted message
+         */
+        size_t format(common::line_writer &writer, const char *name, log_level level, const line_origin &origin,
+                      const format::format_args &args) const;
+
+        /**
+         * Capture what the pattern needs from the calling thread: the time, and the thread name and ID if the
+         * pattern shows them
+         * @param origin: Receives the time and thread
+         */
+        void capture_origin(line_origin &origin) const;
+
     private:
         // The pattern to format the log message
         std::string _pattern;
+        // The pattern compiled by set_pattern(), executed left to right by format_with_pattern()
+        std::vector<pattern_segment> _segments;
+        // [_stamp_begin, _stamp_end) of _segments is the first run of date/time segments. It only changes once per
+        // second, so it is rendered once and reused by every line the same thread logs within that second
+        size_t _stamp_begin{0};
+        size_t _stamp_end{0};
+        // Identifies the text of that run, patterns with the same run share the per-thread cached rendering
+        unsigned long _stamp_id{0};
+        // The pattern has a thread name or thread ID placeholder
+        bool _uses_thread{false};
+        // Timestamps come from common::tsc_clock
+        bool _tsc_clock{false};
         /**
          * Format the log message
-         * @param buf: The buffer to store the formatted message
-         * @param len: The length of the buffer
+         * @param writer: Receives the line, at least one character must fit
          * @param name: The logger name
          * @param level: The log level
-         * @param msg: The log message
+         * @param message: Called as message(writer) to render the message where ${msg} is
+         * @param origin: The time and thread of the log call, nullptr to take them from the calling thread
+         * @return The length of the formatted message, including the trailing newline
          */
-        void format_with_pattern(char *buf, size_t len, const char *name, log_level level, const char *msg) const;
+        template<typename Message>
+        size_t format_with_pattern(common::line_writer &writer, const char *name, log_level level,
+                                   const Message &message, const line_origin *origin = nullptr) const;
     };
 } // namespace log4cpp::pattern
@@ -0,0 +1,42 @@
+#include <string>
+
+#include "appender/balanced_socket_appender.hpp"
+
+namespace log4cpp::appender {
+    balanced_socket_appender::balanced_socket_appender(const config::socket_appender &cfg) : balance(cfg.balance) {
+        for (size_t i = 0; i < cfg.endpoints.size(); ++i) {
+            config::socket_appender endpoint_cfg = cfg;
+            endpoint_cfg.host = cfg.endpoints[i].host;
+            endpoint_cfg.port = cfg.endpoints[i].port;
+            endpoint_cfg.endpoints.clear();
+            if (!cfg.spill_file.empty()) {
+                endpoint_cfg.spill_file = cfg.spill_file + "." + std::to_string(i);
+            }
+            this->endpoints.push_back(std::make_unique<socket_appender>(endpoint_cfg));
+        }
+    }
+
+    socket_appender &balanced_socket_appender::pick(size_t index) const {
+        const size_t count = this->endpoints.size();
+        for (size_t i = 0; i < count; ++i) {
+            socket_appender &endpoint = *this->endpoints[(index + i) % count];
+            if (endpoint.connected()) {
+                return endpoint;
+            }
+        }
+        return *this->endpoints[index % count];
+    }
+
+    void balanced_socket_appender::log(const char *msg, size_t msg_len) {
+        pick(this->next.fetch_add(1, std::memory_order_relaxed)).log(msg, msg_len);
+    }
+
+    void balanced_socket_appender::log_keyed(uint32_t logger_key, const char *msg, size_t msg_len) {
+        if (config::balance_policy::HASH_BY_LOGGER == this->balance) {
+            pick(logger_key).log(msg, msg_len);
+        }
+        else {
+            log(msg, msg_len);
+        }
+    }
+} // namespace log4cpp::appender
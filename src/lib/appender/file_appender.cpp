@@ -1,4 +1,7 @@
+#include <algorithm>
+#include <cstdio>
 #include <cstring>
+#include <ctime>
 #include <fcntl.h>
 #include <filesystem>
 #include <stdexcept>
@@ -10,6 +13,7 @@
 #ifdef _WIN32
 #include <direct.h>
 #include <io.h>
+#include <sys/stat.h>
 #endif
 
 #ifdef __MINGW32__
@@ -21,15 +25,54 @@
 #ifdef __linux__
 
 #include <sys/stat.h>
+#include <sys/uio.h>
 #include <unistd.h>
 
 #endif
 
+#include <chrono>
 #include <mutex>
 
 #include "appender/file_appender.hpp"
+#include "common/log_utils.hpp"
 
 namespace log4cpp::appender {
+#ifdef __linux__
+    /* The buffers of the io_uring mode: one is filled while the others may be in flight */
+    constexpr size_t URING_BUFFERS = 4;
+#endif
+
+    /**
+     * @brief Open the log file for appending, -1 with errno set on failure
+     */
+    int open_file(const std::string &path) {
+        int openFlags = O_RDWR | O_CREAT | O_APPEND;
+#ifdef _WIN32
+        int mode = _S_IREAD | _S_IWRITE;
+#endif
+
+#ifdef __linux__
+        openFlags |= O_CLOEXEC;
+        mode_t mode = S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP | S_IROTH;
+#endif
+#ifdef _MSC_VER
+        return _open(path.c_str(), openFlags, mode);
+#else
+        return open(path.c_str(), openFlags, mode);
+#endif
+    }
+
+    /**
+     * @brief Write the data of the file to the disk
+     */
+    void sync_file(int fd) {
+#ifdef _WIN32
+        (void)_commit(fd);
+#else
+        (void)fdatasync(fd);
+#endif
+    }
+
     file_appender::file_appender(const config::file_appender &cfg) {
         if (const auto pos = cfg.file_path.find_last_of('/'); pos != std::string::npos) {
             std::string path = cfg.file_path.substr(0, pos);
@@ -56,20 +99,8 @@ namespace log4cpp::appender {
 #endif
             }
         }
-        int openFlags = O_RDWR | O_CREAT | O_APPEND;
-#ifdef _WIN32
-        int mode = _S_IREAD | _S_IWRITE;
-#endif
-
-#ifdef __linux__
-        openFlags |= O_CLOEXEC;
-        mode_t mode = S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP | S_IROTH;
-#endif
-#ifdef _MSC_VER
-        this->fd = _open(cfg.file_path.c_str(), openFlags, mode);
-#else
-        this->fd = open(cfg.file_path.c_str(), openFlags, mode);
-#endif
+        this->file_path = cfg.file_path;
+        this->fd = open_file(cfg.file_path);
         if (this->fd == -1) {
             std::string what("Can not open log file '");
             what.append(cfg.file_path);
@@ -78,9 +109,68 @@ namespace log4cpp::appender {
             what.append("(" + std::to_string(errno) + ")");
             throw std::runtime_error(what);
         }
+        if (cfg.rolls()) {
+#ifdef _MSC_VER
+            struct _stat st {};
+            const bool has_stat = _fstat(this->fd, &st) == 0;
+#else
+            struct stat st {};
+            const bool has_stat = fstat(this->fd, &st) == 0;
+#endif
+            this->file_size = has_stat ? static_cast<size_t>(st.st_size) : 0;
+            this->max_file_size = cfg.max_file_size;
+            this->rolling = cfg.rolling;
+            if (config::rolling_interval::NONE != this->rolling) {
+                // A file left from an earlier hour or day rolls with the first record
+                const std::time_t since = has_stat && st.st_size > 0 ? st.st_mtime : std::time(nullptr);
+                this->next_rollover = next_rollover_time(since, this->rolling);
+            }
+            this->archiver = std::make_unique<file_archiver>(cfg);
+        }
+        size_t size = cfg.buffer_size;
+        if (config::write_mode::IO_URING == cfg.mode && 0 == size) {
+            size = config::FILE_URING_BUFFER_SIZE_DEFAULT;
+        }
+        if (size > 0) {
+            this->buffer = std::make_unique<char[]>(size);
+            this->buffer_size = size;
+            this->flush_interval_ms = cfg.flush_interval_ms;
+#ifdef __linux__
+            if (config::write_mode::IO_URING == cfg.mode) {
+                std::vector<char *> buffers{this->buffer.get()};
+                for (size_t i = 1; i < URING_BUFFERS; ++i) {
+                    this->spares.push_back(std::make_unique<char[]>(size));
+                    buffers.push_back(this->spares.back().get());
+                }
+                // Without io_uring the buffers are written with write(), as in the default mode
+                this->uring = uring_writer::create(buffers.data(), buffers.size(), size);
+                if (nullptr == this->uring) {
+                    this->spares.clear();
+                }
+            }
+#endif
+            if (this->flush_interval_ms > 0) {
+                this->flusher = std::thread(&file_appender::run_flusher, this);
+            }
+        }
+        this->sync_level = cfg.sync_level;
+        this->durable = cfg.syncs();
+        if (cfg.sync_interval_ms > 0 || cfg.sync_bytes > 0) {
+            this->syncer = std::make_unique<file_syncer>(cfg.sync_interval_ms, cfg.sync_bytes, [this] { sync(); });
+        }
     }
 
     file_appender::~file_appender() {
+        this->syncer.reset();
+        if (this->flusher.joinable()) {
+            {
+                std::lock_guard<std::mutex> stop_lock(this->flusher_mtx);
+                this->flusher_stop = true;
+            }
+            this->flusher_cv.notify_one();
+            this->flusher.join();
+        }
+        this->flush();
         if (this->fd != -1) {
 #ifdef _MSC_VER
             _close(this->fd);
@@ -90,15 +180,223 @@ namespace log4cpp::appender {
         }
     }
 
+    void file_appender::write_out(const char *msg, size_t msg_len) const {
+        while (msg_len > 0) {
+#ifdef _MSC_VER
+            const auto written = _write(this->fd, msg, static_cast<unsigned int>(msg_len));
+#else
+            const auto written = write(this->fd, msg, msg_len);
+#endif
+            if (written <= 0) {
+                if (written == -1 && errno == EINTR) {
+                    continue;
+                }
+                return;
+            }
+            msg += written;
+            msg_len -= static_cast<size_t>(written);
+        }
+    }
+
+    void file_appender::write_buffer() {
+        if (0 == this->buffer_used) {
+            return;
+        }
+#ifdef __linux__
+        if (nullptr != this->uring) {
+            if (this->uring->write(this->fd, this->buffer.get(), this->buffer_used)) {
+                std::swap(this->buffer, this->spares[this->next_spare]);
+                this->next_spare = (this->next_spare + 1) % this->spares.size();
+                // The buffer submitted longest ago is filled next, wait only if it is still being written
+                this->uring->wait(this->buffer.get());
+                this->buffer_used = 0;
+                return;
+            }
+            // Written with write() behind the buffers in flight
+            this->uring->wait();
+        }
+#endif
+        write_out(this->buffer.get(), this->buffer_used);
+        this->buffer_used = 0;
+    }
+
+    void file_appender::wait_written() {
+#ifdef __linux__
+        if (nullptr != this->uring) {
+            this->uring->wait();
+        }
+#endif
+    }
+
+    void file_appender::write_buffer_and(const char *msg, size_t msg_len) {
+#ifdef __linux__
+        if (nullptr != this->uring) {
+            // Copied through the buffers, the logging thread does not wait for the disk for a large record either
+            while (msg_len > 0) {
+                const size_t n = std::min(msg_len, this->buffer_size - this->buffer_used);
+                std::memcpy(this->buffer.get() + this->buffer_used, msg, n);
+                this->buffer_used += n;
+                msg += n;
+                msg_len -= n;
+                if (this->buffer_used == this->buffer_size) {
+                    write_buffer();
+                }
+            }
+            return;
+        }
+        if (this->buffer_used > 0) {
+            iovec iov[2] = {{this->buffer.get(), this->buffer_used}, {const_cast<char *>(msg), msg_len}};
+            const size_t total = this->buffer_used + msg_len;
+            this->buffer_used = 0;
+            ssize_t written;
+            do {
+                written = writev(this->fd, iov, 2);
+            } while (written == -1 && errno == EINTR);
+            if (written < 0 || static_cast<size_t>(written) == total) {
+                return;
+            }
+            // Short write, finish with plain writes
+            const auto done = static_cast<size_t>(written);
+            if (done < iov[0].iov_len) {
+                write_out(this->buffer.get() + done, iov[0].iov_len - done);
+                write_out(msg, msg_len);
+            }
+            else {
+                write_out(msg + (done - iov[0].iov_len), msg_len - (done - iov[0].iov_len));
+            }
+            return;
+        }
+#else
+        if (this->buffer_used > 0) {
+            write_out(this->buffer.get(), this->buffer_used);
+            this->buffer_used = 0;
+        }
+#endif
+        write_out(msg, msg_len);
+    }
+
     void file_appender::log(const char *msg, size_t msg_len) {
         std::scoped_lock fd_lock(this->lock);
+        if (nullptr != this->syncer) {
+            this->syncer->written(msg_len);
+        }
+        if (nullptr != this->archiver) {
+            roll_if_due(msg_len);
+            this->file_size += msg_len;
+        }
+        if (nullptr == this->buffer) {
+            write_out(msg, msg_len);
+            return;
+        }
+        if (this->buffer_used + msg_len > this->buffer_size) {
+            if (msg_len >= this->buffer_size) {
+                // Does not fit even in an empty buffer, write it behind the buffered records
+                write_buffer_and(msg, msg_len);
+                return;
+            }
+            write_buffer();
+        }
+        std::memcpy(this->buffer.get() + this->buffer_used, msg, msg_len);
+        this->buffer_used += msg_len;
+    }
+
+    void file_appender::flush() {
+        std::scoped_lock fd_lock(this->lock);
+        write_buffer();
+        wait_written();
+    }
+
+    void file_appender::sync() {
+        int sync_fd;
+        {
+            std::scoped_lock fd_lock(this->lock);
+            write_buffer();
+            wait_written();
+            // A duplicate stays valid if the file rolls over meanwhile
+#ifdef _MSC_VER
+            sync_fd = _dup(this->fd);
+#else
+            sync_fd = dup(this->fd);
+#endif
+        }
+        if (-1 == sync_fd) {
+            return;
+        }
+        sync_file(sync_fd);
+#ifdef _MSC_VER
+        _close(sync_fd);
+#else
+        close(sync_fd);
+#endif
+    }
+
+    void file_appender::roll_if_due(size_t msg_len) {
+        bool due = this->max_file_size > 0 && this->file_size > 0 && this->file_size + msg_len > this->max_file_size;
+        if (!due && config::rolling_interval::NONE != this->rolling) {
+            due = std::time(nullptr) >= this->next_rollover;
+        }
+        if (!due) {
+            return;
+        }
+        roll();
+        // After a failed roll the next attempt waits for another max_file_size bytes or interval as well
+        this->file_size = 0;
+        if (config::rolling_interval::NONE != this->rolling) {
+            this->next_rollover = next_rollover_time(std::time(nullptr), this->rolling);
+        }
+    }
+
+    void file_appender::roll() {
+        // Everything written so far belongs to the rolled file, the archiver reads it
+        write_buffer();
+        wait_written();
+        const std::string rolled = this->archiver->next_rolled_path();
+#ifdef _WIN32
+        // Windows can not rename an open file
+        if (this->durable) {
+            sync_file(this->fd);
+        }
 #ifdef _MSC_VER
-        (void)_write(this->fd, msg, static_cast<unsigned int>(msg_len));
+        _close(this->fd);
 #else
-#pragma GCC diagnostic push
-#pragma GCC diagnostic ignored "-Wunused-result"
-        (void)write(this->fd, msg, msg_len);
-#pragma GCC diagnostic pop
+        close(this->fd);
 #endif
+        const bool renamed = std::rename(this->file_path.c_str(), rolled.c_str()) == 0;
+        this->fd = open_file(this->file_path);
+        if (renamed) {
+            this->archiver->submit(rolled);
+        }
+        else {
+            file_archiver::cancel(rolled);
+        }
+#else
+        // Rename while the old fd stays open, every record lands in the old or in the new file
+        if (std::rename(this->file_path.c_str(), rolled.c_str()) != 0) {
+            file_archiver::cancel(rolled);
+            return;
+        }
+        const int new_fd = open_file(this->file_path);
+        if (-1 == new_fd) {
+            (void)std::rename(rolled.c_str(), this->file_path.c_str());
+            file_archiver::cancel(rolled);
+            return;
+        }
+        if (this->durable) {
+            // Rollover is rare, the writers can wait for this one
+            sync_file(this->fd);
+        }
+        close(this->fd);
+        this->fd = new_fd;
+        this->archiver->submit(rolled);
+#endif
+    }
+
+    void file_appender::run_flusher() {
+        set_thread_name("log4cpp_flush");
+        const auto interval = std::chrono::milliseconds(this->flush_interval_ms);
+        std::unique_lock<std::mutex> stop_lock(this->flusher_mtx);
+        while (!this->flusher_cv.wait_for(stop_lock, interval, [this] { return this->flusher_stop; })) {
+            this->flush();
+        }
     }
 } // namespace log4cpp::appender
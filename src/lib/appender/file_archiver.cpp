@@ -0,0 +1,309 @@
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <ctime>
+#include <cstdio>
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <set>
+#include <vector>
+
+#ifdef LOG4CPP_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+#ifdef LOG4CPP_HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+#include "appender/file_archiver.hpp"
+#include "common/log_utils.hpp"
+
+namespace log4cpp::appender {
+    namespace fs = std::filesystem;
+
+    constexpr const char *ROLLED_SUFFIX = ".rolling-";
+    constexpr size_t COMPRESS_CHUNK = 64 * 1024;
+    /* Every extension a backup may have, files compressed under an earlier configuration are rotated too */
+    constexpr std::array<const char *, 3> BACKUP_EXTENSIONS{"", ".gz", ".zst"};
+
+    class file_closer {
+    public:
+        void operator()(std::FILE *file) const {
+            (void)std::fclose(file);
+        }
+    };
+
+    using file_ptr = std::unique_ptr<std::FILE, file_closer>;
+
+    /**
+     * @brief The rolled files claimed by the archivers of this process, and a lock per log file for its backups.
+     */
+    class archive_registry {
+    public:
+        std::mutex mtx;
+        std::set<std::string> claimed;
+        std::map<std::string, std::mutex> rotate_locks;
+    };
+
+    archive_registry &archives() {
+        static archive_registry instance;
+        return instance;
+    }
+
+    /**
+     * @brief The same key for every spelling of a path
+     */
+    std::string registry_key(const std::string &path) {
+        std::error_code ec;
+        const fs::path absolute = fs::absolute(path, ec);
+        return (ec ? fs::path(path) : absolute).lexically_normal().string();
+    }
+
+    void claim_rolled(const std::string &rolled_path) {
+        archive_registry &reg = archives();
+        std::lock_guard<std::mutex> lock(reg.mtx);
+        reg.claimed.insert(registry_key(rolled_path));
+    }
+
+    const char *extension_of(config::compression compress) {
+        switch (compress) {
+            case config::compression::GZIP:
+                return ".gz";
+            case config::compression::ZSTD:
+                return ".zst";
+            default:
+                return "";
+        }
+    }
+
+#ifdef LOG4CPP_HAVE_ZLIB
+    bool gzip_file(const std::string &in_path, const std::string &out_path) {
+        const file_ptr in(std::fopen(in_path.c_str(), "rb"));
+        if (nullptr == in) {
+            return false;
+        }
+        gzFile out = gzopen(out_path.c_str(), "wb6");
+        if (nullptr == out) {
+            return false;
+        }
+        std::vector<char> chunk(COMPRESS_CHUNK);
+        bool ok = true;
+        size_t n;
+        while (ok && (n = std::fread(chunk.data(), 1, chunk.size(), in.get())) > 0) {
+            ok = gzwrite(out, chunk.data(), static_cast<unsigned int>(n)) == static_cast<int>(n);
+        }
+        ok = ok && 0 == std::ferror(in.get());
+        return gzclose(out) == Z_OK && ok;
+    }
+#endif
+
+#ifdef LOG4CPP_HAVE_ZSTD
+    bool zstd_file(const std::string &in_path, const std::string &out_path) {
+        const file_ptr in(std::fopen(in_path.c_str(), "rb"));
+        if (nullptr == in) {
+            return false;
+        }
+        const file_ptr out(std::fopen(out_path.c_str(), "wb"));
+        if (nullptr == out) {
+            return false;
+        }
+        const std::unique_ptr<ZSTD_CCtx, size_t (*)(ZSTD_CCtx *)> cctx(ZSTD_createCCtx(), ZSTD_freeCCtx);
+        if (nullptr == cctx) {
+            return false;
+        }
+        std::vector<char> in_chunk(ZSTD_CStreamInSize());
+        std::vector<char> out_chunk(ZSTD_CStreamOutSize());
+        for (;;) {
+            const size_t n = std::fread(in_chunk.data(), 1, in_chunk.size(), in.get());
+            if (std::ferror(in.get()) != 0) {
+                return false;
+            }
+            const bool last = n < in_chunk.size();
+            ZSTD_inBuffer input{in_chunk.data(), n, 0};
+            bool finished;
+            do {
+                ZSTD_outBuffer output{out_chunk.data(), out_chunk.size(), 0};
+                const size_t remaining =
+                    ZSTD_compressStream2(cctx.get(), &output, &input, last ? ZSTD_e_end : ZSTD_e_continue);
+                if (ZSTD_isError(remaining) != 0 ||
+                    std::fwrite(out_chunk.data(), 1, output.pos, out.get()) != output.pos) {
+                    return false;
+                }
+                finished = last ? 0 == remaining : input.pos == input.size;
+            } while (!finished);
+            if (last) {
+                return true;
+            }
+        }
+    }
+#endif
+
+    /**
+     * @brief Compress in_path to out_path, false if it failed or the compression is not built in
+     */
+    bool compress_file(const std::string &in_path, const std::string &out_path, config::compression compress) {
+        bool ok = false;
+#ifdef LOG4CPP_HAVE_ZLIB
+        if (config::compression::GZIP == compress) {
+            ok = gzip_file(in_path, out_path);
+        }
+#endif
+#ifdef LOG4CPP_HAVE_ZSTD
+        if (config::compression::ZSTD == compress) {
+            ok = zstd_file(in_path, out_path);
+        }
+#endif
+        if (!ok) {
+            std::error_code ec;
+            fs::remove(out_path, ec);
+        }
+        return ok;
+    }
+
+    std::time_t next_rollover_time(std::time_t t, config::rolling_interval interval) {
+        tm local{};
+        common::get_local_time(t, local);
+        local.tm_sec = 0;
+        local.tm_min = 0;
+        if (config::rolling_interval::DAILY == interval) {
+            local.tm_hour = 0;
+            local.tm_mday += 1;
+        }
+        else {
+            local.tm_hour += 1;
+        }
+        // mktime() normalizes the overflowed field and works out the DST offset of the result
+        local.tm_isdst = -1;
+        return std::mktime(&local);
+    }
+
+    file_archiver::file_archiver(const config::file_appender &cfg) :
+        file_path(cfg.file_path), max_backup_index(cfg.max_backup_index), compress(cfg.compress) {
+        // Files rolled but not archived before a crash go first, oldest first
+        const fs::path log_path(file_path);
+        const std::string prefix = log_path.filename().string() + ROLLED_SUFFIX;
+        std::vector<std::string> leftovers;
+        std::error_code ec;
+        const fs::path dir = log_path.has_parent_path() ? log_path.parent_path() : fs::path(".");
+        for (fs::directory_iterator it(dir, ec), end; !ec && it != end; it.increment(ec)) {
+            const std::string name = it->path().filename().string();
+            if (name.size() > prefix.size() && name.compare(0, prefix.size(), prefix) == 0 &&
+                name.find_first_not_of("0123456789", prefix.size()) == std::string::npos) {
+                leftovers.push_back(it->path().string());
+            }
+        }
+        std::sort(leftovers.begin(), leftovers.end());
+        {
+            // Files queued by a live archiver (the appender a hot reload replaced) are not leftovers, they may not
+            // even be finished yet
+            archive_registry &reg = archives();
+            std::lock_guard<std::mutex> lock(reg.mtx);
+            for (auto &leftover: leftovers) {
+                if (reg.claimed.insert(registry_key(leftover)).second) {
+                    pending.push_back(rolled_file{std::move(leftover), nullptr});
+                }
+            }
+        }
+        worker = std::thread(&file_archiver::run, this);
+    }
+
+    file_archiver::~file_archiver() {
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            stop = true;
+        }
+        cv.notify_one();
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+
+    std::string file_archiver::next_rolled_path() const {
+        const auto now = std::chrono::system_clock::now().time_since_epoch();
+        const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(now).count();
+        std::string rolled_path = file_path + ROLLED_SUFFIX + std::to_string(ns);
+        claim_rolled(rolled_path);
+        return rolled_path;
+    }
+
+    void file_archiver::cancel(const std::string &rolled_path) {
+        archive_registry &reg = archives();
+        std::lock_guard<std::mutex> lock(reg.mtx);
+        reg.claimed.erase(registry_key(rolled_path));
+    }
+
+    void file_archiver::submit(std::string rolled_path, std::function<void()> release) {
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            pending.push_back(rolled_file{std::move(rolled_path), std::move(release)});
+        }
+        cv.notify_one();
+    }
+
+    std::string file_archiver::backup_path(const std::string &file_path, unsigned int index,
+                                           config::compression compress) {
+        return file_path + "." + std::to_string(index) + extension_of(compress);
+    }
+
+    void file_archiver::run() {
+        set_thread_name("log4cpp_archive");
+        std::unique_lock<std::mutex> lock(mtx);
+        for (;;) {
+            cv.wait(lock, [this] { return stop || !pending.empty(); });
+            // Pending files are archived before stopping, so none is left under its temporary name
+            if (pending.empty()) {
+                break;
+            }
+            const rolled_file rolled = std::move(pending.front());
+            pending.pop_front();
+            lock.unlock();
+            if (rolled.release) {
+                rolled.release();
+            }
+            archive(rolled.path);
+            cancel(rolled.path);
+            lock.lock();
+        }
+    }
+
+    void file_archiver::archive(const std::string &rolled_path) const {
+        std::error_code ec;
+        if (0 == max_backup_index) {
+            fs::remove(rolled_path, ec);
+            return;
+        }
+        std::string archived = rolled_path;
+        const char *extension = "";
+        if (config::compression::NONE != compress) {
+            const std::string compressed = rolled_path + extension_of(compress);
+            if (compress_file(rolled_path, compressed, compress)) {
+                fs::remove(rolled_path, ec);
+                archived = compressed;
+                extension = extension_of(compress);
+            }
+        }
+        std::mutex *rotate_mtx;
+        {
+            archive_registry &reg = archives();
+            std::lock_guard<std::mutex> lock(reg.mtx);
+            rotate_mtx = &reg.rotate_locks[registry_key(file_path)];
+        }
+        // Another archiver of the same file (before a hot reload) may be rotating too
+        std::lock_guard<std::mutex> rotate_lock(*rotate_mtx);
+        // Make room for index 1: drop the oldest, then shift the others up by one
+        for (const char *ext: BACKUP_EXTENSIONS) {
+            fs::remove(file_path + "." + std::to_string(max_backup_index) + ext, ec);
+        }
+        for (unsigned int index = max_backup_index - 1; index > 0; --index) {
+            for (const char *ext: BACKUP_EXTENSIONS) {
+                const std::string from = file_path + "." + std::to_string(index) + ext;
+                if (fs::exists(from, ec)) {
+                    fs::rename(from, file_path + "." + std::to_string(index + 1) + ext, ec);
+                }
+            }
+        }
+        fs::rename(archived, file_path + ".1" + extension, ec);
+    }
+} // namespace log4cpp::appender
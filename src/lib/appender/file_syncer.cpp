@@ -0,0 +1,52 @@
+#include <chrono>
+#include <utility>
+
+#include "appender/file_syncer.hpp"
+#include "common/log_utils.hpp"
+
+namespace log4cpp::appender {
+    file_syncer::file_syncer(unsigned int interval, size_t bytes, std::function<void()> sync_file) :
+        interval_ms(interval), sync_bytes(bytes), sync(std::move(sync_file)) {
+        this->worker = std::thread(&file_syncer::run, this);
+    }
+
+    file_syncer::~file_syncer() {
+        {
+            std::lock_guard<std::mutex> lock(this->mtx);
+            this->stop = true;
+        }
+        this->cv.notify_one();
+        this->worker.join();
+    }
+
+    void file_syncer::wake() {
+        {
+            std::lock_guard<std::mutex> lock(this->mtx);
+            this->woken = true;
+        }
+        this->cv.notify_one();
+    }
+
+    void file_syncer::run() {
+        set_thread_name("log4cpp_sync");
+        std::unique_lock<std::mutex> lock(this->mtx);
+        while (!this->stop) {
+            const auto due = [this] { return this->stop || this->woken; };
+            if (this->interval_ms > 0) {
+                this->cv.wait_for(lock, std::chrono::milliseconds(this->interval_ms), due);
+            }
+            else {
+                this->cv.wait(lock, due);
+            }
+            if (this->stop) {
+                break;
+            }
+            this->woken = false;
+            lock.unlock();
+            // Bytes written during the sync count towards the next one
+            this->unsynced.store(0, std::memory_order_relaxed);
+            this->sync();
+            lock.lock();
+        }
+    }
+} // namespace log4cpp::appender
@@ -0,0 +1,438 @@
+#ifndef _WIN32
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <filesystem>
+#include <map>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+
+#include "appender/mmap_file_appender.hpp"
+#include "common/rcu.hpp"
+
+namespace log4cpp::appender {
+    /* The unit the file is extended and mapped in */
+    constexpr size_t MMAP_CHUNK_SIZE = 16 * 1024 * 1024;
+    /* Chunks mapped at the same time, writers may run this many chunks ahead of the slowest one */
+    constexpr size_t MMAP_CHUNK_SLOTS = 4;
+    constexpr uint64_t NO_CHUNK = UINT64_MAX;
+    /* Added to the offset to stop further reservations, far above any real file size */
+    constexpr uint64_t FROZEN = static_cast<uint64_t>(1) << 62;
+
+    /* The device and inode of a file */
+    using file_id = std::pair<dev_t, ino_t>;
+
+    class mapped_file;
+
+    /**
+     * @brief The mapped_files open in this process, the newest one for each file.
+     */
+    class open_file_registry {
+    public:
+        std::mutex mtx;
+        std::map<file_id, mapped_file *> files;
+    };
+
+    open_file_registry &open_files() {
+        static open_file_registry registry;
+        return registry;
+    }
+
+    /**
+     * @brief The length of the file without the zero padding a mapping left at its end, when the process died before
+     * closing it.
+     */
+    uint64_t content_length(int fd, uint64_t size) {
+        std::vector<char> block(64 * 1024);
+        while (size > 0) {
+            const auto n = static_cast<size_t>(std::min<uint64_t>(size, block.size()));
+            if (pread(fd, block.data(), n, static_cast<off_t>(size - n)) != static_cast<ssize_t>(n)) {
+                return size;
+            }
+            for (size_t i = n; i > 0; --i) {
+                if (block[i - 1] != '\0') {
+                    return size - n + i;
+                }
+            }
+            size -= n;
+        }
+        return 0;
+    }
+
+    /**
+     * @brief One open generation of the log file: its fd, its mapped chunks and its write offset.
+     */
+    class mapped_file {
+    public:
+        /**
+         * @brief Open path for appending, nullptr with errno set on failure.
+         *
+         * Writing starts after the last record: zero padding left by a process that died is skipped. If another
+         * appender of this process has the file open (a hot reload that keeps the path), that one is superseded:
+         * writing starts right after the bytes it reserved, and it forwards its later records here.
+         */
+        static mapped_file *open(const std::string &path) {
+            const int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC,
+                                  S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP | S_IROTH);
+            if (-1 == fd) {
+                return nullptr;
+            }
+            struct stat st {};
+            if (fstat(fd, &st) == -1) {
+                const int err = errno;
+                ::close(fd);
+                errno = err;
+                return nullptr;
+            }
+            const file_id id{st.st_dev, st.st_ino};
+            const auto size = static_cast<uint64_t>(st.st_size);
+            open_file_registry &registry = open_files();
+            std::lock_guard<std::mutex> lock(registry.mtx);
+            uint64_t length = FROZEN;
+            const auto it = registry.files.find(id);
+            if (it != registry.files.end()) {
+                mapped_file *previous = it->second;
+                previous->superseded.store(true, std::memory_order_release);
+                length = previous->freeze();
+            }
+            if (length >= FROZEN) {
+                length = content_length(fd, size);
+            }
+            auto *file = new mapped_file(fd, id, length, size);
+            registry.files[id] = file;
+            return file;
+        }
+
+        mapped_file(const mapped_file &other) = delete;
+
+        mapped_file &operator=(const mapped_file &other) = delete;
+
+        /**
+         * @brief Copy msg into the file, false if the file was frozen before the bytes were reserved.
+         */
+        bool write(const char *msg, size_t msg_len) {
+            const uint64_t off = offset.fetch_add(msg_len, std::memory_order_relaxed);
+            if (off >= FROZEN) {
+                return false;
+            }
+            // A record may straddle two chunks
+            size_t done = 0;
+            while (done < msg_len) {
+                const uint64_t pos = off + done;
+                const uint64_t index = pos / MMAP_CHUNK_SIZE;
+                const auto in_chunk = static_cast<size_t>(pos % MMAP_CHUNK_SIZE);
+                const size_t n = std::min(msg_len - done, MMAP_CHUNK_SIZE - in_chunk);
+                chunk_slot &slot = slots[index % MMAP_CHUNK_SLOTS];
+                char *map = slot.index.load(std::memory_order_acquire) == index ? slot.map : map_chunk(index);
+                if (nullptr == map) {
+                    // The file could not be extended or mapped, the record is lost
+                    return true;
+                }
+                std::memcpy(map + in_chunk, msg + done, n);
+                // The writer completing a chunk unmaps it, the slot is then free for a later chunk
+                if (slot.filled.fetch_add(n, std::memory_order_acq_rel) + n == MMAP_CHUNK_SIZE) {
+                    munmap(map, MMAP_CHUNK_SIZE);
+                    slot.index.store(NO_CHUNK, std::memory_order_release);
+                }
+                done += n;
+            }
+            return true;
+        }
+
+        /**
+         * @brief Write msg to the file that superseded this one, false if there is none any more or it is frozen.
+         */
+        bool forward(const char *msg, size_t msg_len) {
+            mapped_file *target;
+            {
+                open_file_registry &registry = open_files();
+                std::lock_guard<std::mutex> lock(registry.mtx);
+                const auto it = registry.files.find(id);
+                if (it == registry.files.end() || it->second == this) {
+                    return false;
+                }
+                // Pinned, the other file is not closed until the copy is done. The registry is not held while copying,
+                // a page fault would stall every appender opening or closing a file.
+                target = it->second;
+                target->forwarders.fetch_add(1, std::memory_order_relaxed);
+            }
+            const bool written = target->write(msg, msg_len);
+            target->forwarders.fetch_sub(1, std::memory_order_release);
+            return written;
+        }
+
+        /**
+         * @brief The bytes reserved so far, FROZEN or more once frozen
+         */
+        [[nodiscard]] uint64_t size() const {
+            return offset.load(std::memory_order_relaxed);
+        }
+
+        /**
+         * @brief Stop further reservations, write() returns false from now on.
+         * @return The length of the file: every byte below it is, or is being, written.
+         */
+        uint64_t freeze() {
+            return offset.fetch_add(FROZEN, std::memory_order_acq_rel);
+        }
+
+        /**
+         * @brief Write the content of the file to the disk.
+         */
+        void sync() const {
+            (void)fdatasync(fd);
+        }
+
+        /**
+         * @brief Unmap, cut the zero padding off, sync if asked to, and close. No writer may use the file any more.
+         */
+        void close(uint64_t length, bool sync_first) {
+            {
+                open_file_registry &registry = open_files();
+                std::lock_guard<std::mutex> lock(registry.mtx);
+                const auto it = registry.files.find(id);
+                if (it != registry.files.end() && it->second == this) {
+                    registry.files.erase(it);
+                }
+            }
+            // No forward() finds the file any more, wait for those that pinned it before
+            while (forwarders.load(std::memory_order_acquire) != 0) {
+                std::this_thread::yield();
+            }
+            for (auto &slot: slots) {
+                if (slot.index.load(std::memory_order_acquire) != NO_CHUNK) {
+                    munmap(slot.map, MMAP_CHUNK_SIZE);
+                    slot.index.store(NO_CHUNK, std::memory_order_relaxed);
+                }
+            }
+            // The file that superseded this one writes past length. If a file_appender extended the file meanwhile (a
+            // hot reload to the same path) its records are past our padding, keep them too.
+            struct stat st {};
+            if (!superseded.load(std::memory_order_acquire) && fstat(fd, &st) == 0 &&
+                static_cast<uint64_t>(st.st_size) == allocated) {
+                (void)ftruncate(fd, static_cast<off_t>(length));
+            }
+            if (sync_first) {
+                sync();
+            }
+            ::close(fd);
+            fd = -1;
+        }
+
+        /* Roll over when the current local hour or day ends, set before the file is published */
+        std::time_t next_rollover{0};
+        /* Set when rolling this file over failed, it is written on without rolling */
+        std::atomic<bool> roll_failed{false};
+        /* Set when another appender opened the file, records are forwarded to it from then on */
+        std::atomic<bool> superseded{false};
+
+    private:
+        class chunk_slot {
+        public:
+            /* The chunk mapped in this slot, NO_CHUNK if none */
+            std::atomic<uint64_t> index{NO_CHUNK};
+            char *map{nullptr};
+            /* Bytes of the chunk written, the chunk is unmapped when it reaches MMAP_CHUNK_SIZE */
+            std::atomic<size_t> filled{0};
+        };
+
+        /* Superseded appenders copying a record into this file, see forward() */
+        std::atomic<int> forwarders{0};
+
+        mapped_file(int file_fd, const file_id &file, uint64_t length, uint64_t size) :
+            fd(file_fd), id(file), start(length), allocated(size), offset(length) {
+        }
+
+        /**
+         * @brief Extend the file to hold chunk index and map it, nullptr on failure.
+         */
+        char *map_chunk(uint64_t index) {
+            std::unique_lock<std::mutex> lock(map_mtx);
+            chunk_slot &slot = slots[index % MMAP_CHUNK_SLOTS];
+            for (;;) {
+                const uint64_t mapped = slot.index.load(std::memory_order_acquire);
+                if (mapped == index) {
+                    return slot.map;
+                }
+                if (broken) {
+                    return nullptr;
+                }
+                if (NO_CHUNK == mapped) {
+                    break;
+                }
+                // A writer far behind still fills the chunk MMAP_CHUNK_SLOTS before this one
+                lock.unlock();
+                std::this_thread::yield();
+                lock.lock();
+            }
+            const uint64_t end = (index + 1) * MMAP_CHUNK_SIZE;
+            if (end > allocated) {
+                if (posix_fallocate(fd, static_cast<off_t>(allocated), static_cast<off_t>(end - allocated)) != 0) {
+                    broken = true;
+                    return nullptr;
+                }
+                allocated = end;
+            }
+            void *map = mmap(nullptr, MMAP_CHUNK_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd,
+                             static_cast<off_t>(index * MMAP_CHUNK_SIZE));
+            if (MAP_FAILED == map) {
+                broken = true;
+                return nullptr;
+            }
+            slot.map = static_cast<char *>(map);
+            // The first chunk already holds the content the file had when it was opened
+            const size_t filled = index == start / MMAP_CHUNK_SIZE ? static_cast<size_t>(start % MMAP_CHUNK_SIZE) : 0;
+            slot.filled.store(filled, std::memory_order_relaxed);
+            slot.index.store(index, std::memory_order_release);
+            return slot.map;
+        }
+
+        int fd;
+        const file_id id;
+        /* The length of the content when the file was opened, where writing starts */
+        const uint64_t start;
+        /* The length the file was extended to, guarded by map_mtx */
+        uint64_t allocated;
+        /* Set when extending or mapping failed, guarded by map_mtx */
+        bool broken{false};
+        std::mutex map_mtx;
+        chunk_slot slots[MMAP_CHUNK_SLOTS];
+        /* The next byte to reserve, on its own cache line as every writer updates it */
+        alignas(64) std::atomic<uint64_t> offset;
+    };
+
+    mmap_file_appender::mmap_file_appender(const config::file_appender &cfg) : file_path(cfg.file_path) {
+        const std::filesystem::path parent = std::filesystem::path(cfg.file_path).parent_path();
+        std::error_code ec;
+        if (!parent.empty() && !std::filesystem::exists(parent, ec) &&
+            !std::filesystem::create_directories(parent, ec)) {
+            std::string what("Can not create log directory '");
+            what.append(parent.string());
+            what.append("': ");
+            what.append(ec.message());
+            what.append("(" + std::to_string(ec.value()) + ")");
+            throw std::runtime_error(what);
+        }
+        mapped_file *file = mapped_file::open(cfg.file_path);
+        if (nullptr == file) {
+            std::string what("Can not open log file '");
+            what.append(cfg.file_path);
+            what.append("': ");
+            what.append(strerror(errno));
+            what.append("(" + std::to_string(errno) + ")");
+            throw std::runtime_error(what);
+        }
+        if (cfg.rolls()) {
+            this->max_file_size = cfg.max_file_size;
+            this->rolling = cfg.rolling;
+            if (config::rolling_interval::NONE != this->rolling) {
+                // A file left from an earlier hour or day rolls with the first record
+                struct stat st {};
+                const bool old = stat(cfg.file_path.c_str(), &st) == 0 && st.st_size > 0;
+                file->next_rollover = next_rollover_time(old ? st.st_mtime : std::time(nullptr), this->rolling);
+            }
+            this->archiver = std::make_unique<file_archiver>(cfg);
+        }
+        this->current.store(file, std::memory_order_release);
+        this->sync_level = cfg.sync_level;
+        this->durable = cfg.syncs();
+        if (cfg.sync_interval_ms > 0 || cfg.sync_bytes > 0) {
+            this->syncer = std::make_unique<file_syncer>(cfg.sync_interval_ms, cfg.sync_bytes, [this] { sync(); });
+        }
+    }
+
+    mmap_file_appender::~mmap_file_appender() {
+        this->syncer.reset();
+        // Rolled files are closed by the archiver, before it stops
+        this->archiver.reset();
+        mapped_file *file = this->current.load(std::memory_order_acquire);
+        file->close(file->size(), this->durable);
+        delete file;
+    }
+
+    bool mmap_file_appender::roll_due(const mapped_file *file, size_t msg_len) const {
+        if (file->roll_failed.load(std::memory_order_relaxed)) {
+            return false;
+        }
+        const uint64_t size = file->size();
+        if (this->max_file_size > 0 && size > 0 && size + msg_len > this->max_file_size) {
+            return true;
+        }
+        return config::rolling_interval::NONE != this->rolling && std::time(nullptr) >= file->next_rollover;
+    }
+
+    void mmap_file_appender::roll(mapped_file *file) {
+        std::lock_guard<std::mutex> lock(this->roll_mtx);
+        if (this->current.load(std::memory_order_relaxed) != file || file->superseded.load(std::memory_order_acquire)) {
+            // Rolled by another writer meanwhile, or the path belongs to another appender now
+            return;
+        }
+        const std::string rolled = this->archiver->next_rolled_path();
+        if (std::rename(this->file_path.c_str(), rolled.c_str()) != 0) {
+            file_archiver::cancel(rolled);
+            file->roll_failed.store(true, std::memory_order_relaxed);
+            return;
+        }
+        mapped_file *next = mapped_file::open(this->file_path);
+        if (nullptr == next) {
+            (void)std::rename(rolled.c_str(), this->file_path.c_str());
+            file_archiver::cancel(rolled);
+            file->roll_failed.store(true, std::memory_order_relaxed);
+            return;
+        }
+        if (config::rolling_interval::NONE != this->rolling) {
+            next->next_rollover = next_rollover_time(std::time(nullptr), this->rolling);
+        }
+        // Publish first, writers that find the old file frozen load the new one
+        this->current.store(next, std::memory_order_release);
+        const uint64_t length = file->freeze();
+        // Writers that reserved bytes before the freeze may still be copying, the archiver waits for them. This thread
+        // may be inside a read-side section itself (logger_proxy), it must not wait here.
+        this->archiver->submit(rolled, [file, length, sync = this->durable] {
+            common::rcu::synchronize();
+            file->close(length, sync);
+            delete file;
+        });
+    }
+
+    void mmap_file_appender::log(const char *msg, size_t msg_len) {
+        // Keeps the file loaded below alive until the record is copied, see roll()
+        common::rcu::read_guard guard;
+        for (;;) {
+            mapped_file *file = this->current.load(std::memory_order_acquire);
+            if (file->superseded.load(std::memory_order_acquire)) {
+                // A hot reload opened the file again, the new appender writes from now on
+                (void)file->forward(msg, msg_len);
+                break;
+            }
+            if (nullptr != this->archiver && roll_due(file, msg_len)) {
+                roll(file);
+                continue;
+            }
+            if (file->write(msg, msg_len)) {
+                break;
+            }
+        }
+        if (nullptr != this->syncer) {
+            this->syncer->written(msg_len);
+        }
+    }
+
+    void mmap_file_appender::sync() {
+        // The file is closed only after a grace period, see roll()
+        common::rcu::read_guard guard;
+        this->current.load(std::memory_order_acquire)->sync();
+    }
+} // namespace log4cpp::appender
+
+#endif
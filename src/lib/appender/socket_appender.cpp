@@ -15,6 +15,8 @@
 #include <sys/socket.h>
 #endif
 
+#include <algorithm>
+#include <cstdio>
 #include <atomic>
 #include <mutex>
 
@@ -88,22 +90,6 @@ namespace log4cpp::appender {
 #endif
     }
 
-    void set_send_timeout(common::socket_fd fd, std::chrono::seconds timeout) {
-#ifdef _WIN32
-        unsigned int tv = static_cast<unsigned int>(timeout.count()) * 1000;
-        if (setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, reinterpret_cast<const char *>(&tv), sizeof(tv)) == SOCKET_ERROR) {
-            common::log4c_debug(stderr, "setsockopt SO_SNDTIMEO failed: %d\n", WSAGetLastError());
-        }
-#else
-        timeval tv{};
-        tv.tv_sec = timeout.count();
-        tv.tv_usec = 0;
-        if (setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv)) < 0) {
-            common::log4c_debug(stderr, "setsockopt SO_SNDTIMEO failed: %s(%d)\n", strerror(errno), errno);
-        }
-#endif
-    }
-
     connect_result socket_appender::connect_to_server(const common::sock_addr &saddr) const {
         connect_result result{common::INVALID_FD, connection_fsm_state::DISCONNECTED};
         int family = saddr.addr.family == common::net_family::NET_IPv4 ? AF_INET : AF_INET6;
@@ -186,13 +172,21 @@ namespace log4cpp::appender {
 
     socket_appender::socket_appender(const config::socket_appender &cfg) :
         host(cfg.host), port(cfg.port), proto(cfg.proto), ip_stack(cfg.prefer), sock_fd(common::INVALID_FD),
-        connection_state(connection_fsm_state::DISCONNECTED) {
+        connection_state(connection_fsm_state::DISCONNECTED), send_buffer_size(cfg.send_buffer_size),
+        frame(cfg.frame), flush_interval(cfg.flush_interval_ms), datagram_size(cfg.datagram_size),
+        spill_path(cfg.spill_file), spill_size(cfg.spill_size), replay_rate(cfg.replay_rate) {
         // For TCP, start reconnect thread
         if (config::socket_appender::protocol::TCP == this->proto) {
+            if (!this->spill_path.empty()) {
+                open_spill();
+            }
             this->reconnect_thread = std::thread(&socket_appender::reconnect_thread_routine, this);
         }
         else {
             udp_init();
+            if (this->flush_interval.count() > 0) {
+                this->reconnect_thread = std::thread(&socket_appender::udp_thread_routine, this);
+            }
         }
     }
 
@@ -206,19 +200,26 @@ namespace log4cpp::appender {
                 common::log4c_debug(stdout, "[socket_appender] notify cv...\n");
 #endif
             }
-            {
-                std::unique_lock w_lock(this->connection_rw_lock);
-                if (common::INVALID_FD != this->sock_fd) {
-                    common::shutdown_socket(this->sock_fd);
-                    common::close_socket(this->sock_fd);
-                    this->connection_state = connection_fsm_state::DISCONNECTED;
-                }
-            }
+            // The thread sends what is still queued first, for send_timeout at most
             if (this->reconnect_thread.joinable()) {
                 this->reconnect_thread.join();
             }
+            if (common::INVALID_FD != this->sock_fd) {
+                common::shutdown_socket(this->sock_fd);
+                common::close_socket(this->sock_fd);
+                this->connection_state = connection_fsm_state::DISCONNECTED;
+            }
         }
         else {
+            {
+                std::scoped_lock lock(this->reconnect_mutex);
+                this->stop_reconnect.store(true);
+                reconnect_cv.notify_one();
+            }
+            // The thread sends the last batch first
+            if (this->reconnect_thread.joinable()) {
+                this->reconnect_thread.join();
+            }
             common::close_socket(this->sock_fd);
         }
     }
@@ -235,6 +236,61 @@ namespace log4cpp::appender {
         }
     }
 
+    // The header in front of a record of len bytes: a 4-byte big-endian length, or the decimal length and a space
+    size_t frame_header(config::framing frame, size_t len, char (&header)[FRAME_HEADER_MAX]) {
+        switch (frame) {
+            case config::framing::LENGTH_PREFIX:
+                header[0] = static_cast<char>(len >> 24 & 0xff);
+                header[1] = static_cast<char>(len >> 16 & 0xff);
+                header[2] = static_cast<char>(len >> 8 & 0xff);
+                header[3] = static_cast<char>(len & 0xff);
+                return 4;
+            case config::framing::OCTET_COUNTING:
+                return static_cast<size_t>(std::snprintf(header, sizeof(header), "%zu ", len));
+            case config::framing::NONE:
+                break;
+        }
+        return 0;
+    }
+
+    /**
+     * @brief The start of the record that byte pos of a batch of whole framed records belongs to, pos if a record
+     * starts there.
+     */
+    size_t record_start(config::framing frame, const char *data, size_t pos) {
+        if (config::framing::NONE == frame) {
+            for (size_t i = pos; i > 0; --i) {
+                if ('\n' == data[i - 1]) {
+                    return i;
+                }
+            }
+            return 0;
+        }
+        size_t start = 0;
+        while (start < pos) {
+            size_t len = 0;
+            size_t header_len = 0;
+            if (config::framing::LENGTH_PREFIX == frame) {
+                const auto *header = reinterpret_cast<const unsigned char *>(data + start);
+                len = static_cast<size_t>(header[0]) << 24 | static_cast<size_t>(header[1]) << 16 |
+                      static_cast<size_t>(header[2]) << 8 | static_cast<size_t>(header[3]);
+                header_len = 4;
+            }
+            else {
+                while (' ' != data[start + header_len]) {
+                    len = len * 10 + static_cast<size_t>(data[start + header_len] - '0');
+                    ++header_len;
+                }
+                ++header_len;
+            }
+            if (start + header_len + len > pos) {
+                return start;
+            }
+            start += header_len + len;
+        }
+        return start;
+    }
+
     void socket_appender::reset_backoff() {
         this->reconnect_delay = std::chrono::seconds{0};
     }
@@ -274,10 +330,6 @@ namespace log4cpp::appender {
             std::unique_lock w_lock(this->connection_rw_lock);
             this->sock_fd = result.fd;
             this->connection_state = result.state;
-            if (connection_fsm_state::ESTABLISHED == result.state) {
-                set_fd_nonblock(this->sock_fd, false);
-                set_send_timeout(this->sock_fd, send_timeout);
-            }
         }
     }
 
@@ -316,8 +368,7 @@ namespace log4cpp::appender {
         getsockopt(this->sock_fd, SOL_SOCKET, SO_ERROR, &err, &len);
 #endif
         if (0 == err) {
-            set_fd_nonblock(this->sock_fd, false);
-            set_send_timeout(this->sock_fd, send_timeout);
+            // The socket stays non-blocking, the I/O thread waits for it to be writable
             this->connection_state = connection_fsm_state::ESTABLISHED;
             reset_backoff();
 #ifdef _DEBUG
@@ -335,24 +386,208 @@ namespace log4cpp::appender {
         }
     }
 
-    void socket_appender::wait_for_reconnect_or_stop() {
-#ifdef _DEBUG
-        common::log4c_debug(
-            stdout,
-            "[socket_appender] connection is ESTABLISHED, waiting for a stop signal or the next reconnection...\n");
+    bool socket_appender::wait_writable(std::chrono::milliseconds timeout) const {
+        fd_set writefds;
+        FD_ZERO(&writefds);
+        FD_SET(this->sock_fd, &writefds);
+        timeval tv{};
+        tv.tv_sec = static_cast<long>(timeout.count() / 1000);
+        tv.tv_usec = static_cast<long>(timeout.count() % 1000 * 1000);
+#ifdef _WIN32
+        return select(0, nullptr, &writefds, nullptr, &tv) > 0;
+#else
+        return select(this->sock_fd + 1, nullptr, &writefds, nullptr, &tv) > 0;
+#endif
+    }
+
+    void socket_appender::send_queued() {
+        {
+            std::unique_lock lock(this->reconnect_mutex);
+            // A batch kept from a lost connection goes out first
+            const auto ready = [this] {
+                return this->stop_reconnect.load() || !this->send_queue.empty() || !this->send_batch.empty();
+            };
+            if (nullptr != this->spill && !this->spill->empty()) {
+                // Records queued before the connection was lost are older, they go first. Then one slice of the
+                // spilled records every REPLAY_INTERVAL, the collector gets replay_rate bytes per second at most.
+                if (!this->reconnect_cv.wait_until(lock, this->next_replay, ready)) {
+                    constexpr auto slices_per_second = static_cast<size_t>(std::chrono::seconds(1) / REPLAY_INTERVAL);
+                    const size_t slice = this->replay_rate / slices_per_second;
+                    this->replay_bytes = this->spill->peek(this->send_batch, slice);
+                    this->next_replay = std::chrono::steady_clock::now() + REPLAY_INTERVAL;
+                }
+            }
+            else {
+                this->reconnect_cv.wait(lock, ready);
+            }
+            // The logging threads go on filling the emptied batch buffer while this one is sent
+            if (this->send_batch.empty()) {
+                std::swap(this->send_queue, this->send_batch);
+            }
+        }
+#ifdef MSG_NOSIGNAL
+        constexpr int flags = MSG_NOSIGNAL; // A reset connection fails with EPIPE instead of raising SIGPIPE
+#else
+        constexpr int flags = 0;
 #endif
-        // If connection is normal, wait for notification
-        std::unique_lock lock(this->reconnect_mutex);
-        this->reconnect_cv.wait(lock, [this] {
-            return this->stop_reconnect.load() || connection_fsm_state::ESTABLISHED != this->connection_state;
-        });
+        const char *data = this->send_batch.data();
+        const size_t len = this->send_batch.size();
+        const auto deadline = std::chrono::steady_clock::now() + send_timeout;
+        size_t done = 0;
+        bool lost = false;
+        while (done < len) {
+            // One call takes many records, the socket buffer permitting
+            const ssize_t sent = send(this->sock_fd, data + done, static_cast<int>(len - done), flags);
+            if (sent >= 0) {
+                done += static_cast<size_t>(sent);
+                continue;
+            }
+#ifdef _WIN32
+            const int err = WSAGetLastError();
+            if (WSAEWOULDBLOCK == err || WSAEINTR == err) {
+#else
+            const int err = errno;
+            if (EAGAIN == err || EWOULDBLOCK == err || EINTR == err) {
+#endif
+                if (this->stop_reconnect.load() && std::chrono::steady_clock::now() >= deadline) {
+                    break;
+                }
+                (void)wait_writable(SEND_POLL_INTERVAL);
+                continue;
+            }
+            // Connection lost, the rest of the batch is dropped unless there is a spill file
+            lost = true;
+            std::unique_lock w_lock(this->connection_rw_lock);
+            common::close_socket(this->sock_fd);
+            this->sock_fd = common::INVALID_FD;
+            this->connection_state = connection_fsm_state::DISCONNECTED;
 #ifdef _DEBUG
-        std::string state_str;
-        to_string(this->connection_state, state_str);
-        common::log4c_debug(
-            stdout, "[socket_appender] condition variable is awakened...connection state {%s}, stop connection {%s}\n",
-            state_str.c_str(), this->stop_reconnect.load() ? "true" : "false");
+            common::log4c_debug(stdout, "[socket_appender] connection lost(%d)...\n", err);
+#endif
+            break;
+        }
+        // Whole records only: the one cut off is sent again whole, on the next connection
+        const size_t sent = done < len ? record_start(this->frame, data, done) : len;
+        const size_t queued = len - this->replay_bytes;
+        if (this->replay_bytes > 0) {
+            std::scoped_lock lock(this->reconnect_mutex);
+            if (sent > queued) {
+                this->spill->consume(sent - queued);
+            }
+            this->replay_bytes = 0;
+        }
+        if (lost && !this->spill_path.empty() && sent < queued) {
+            // Kept for the next connection. The unsent spilled records are still in the file, they are replayed again.
+            this->send_batch.resize(queued);
+            this->send_batch.erase(this->send_batch.begin(), this->send_batch.begin() + static_cast<ptrdiff_t>(sent));
+        }
+        else {
+            this->send_batch.clear();
+        }
+    }
+
+    void socket_appender::open_spill() {
+        std::unique_ptr<spill_file> file = spill_file::open(this->spill_path, this->spill_size);
+        this->next_spill_open = std::chrono::steady_clock::now() + SPILL_OPEN_RETRY;
+        if (nullptr == file) {
+            if (!this->spill_open_failed) {
+                common::log4c_debug(stderr, "[socket_appender] can not open spill file %s, will retry\n",
+                                    this->spill_path.c_str());
+                this->spill_open_failed = true;
+            }
+            return;
+        }
+        this->spill_open_failed = false;
+        std::scoped_lock lock(this->reconnect_mutex);
+        this->spill = std::move(file);
+    }
+
+    void socket_appender::queue_datagrams(const char *msg, size_t msg_len) {
+        std::scoped_lock lock(this->reconnect_mutex);
+        if (!this->send_queue.empty() && this->send_queue.size() + msg_len > this->send_buffer_size) {
+            return;
+        }
+        const size_t start = this->send_queue.size();
+        size_t open_len = 0;
+        if (!this->datagram_ends.empty()) {
+            const size_t count = this->datagram_ends.size();
+            open_len = this->datagram_ends.back() - (count > 1 ? this->datagram_ends[count - 2] : 0);
+        }
+        const size_t queued = this->datagram_ends.size();
+        this->send_queue.insert(this->send_queue.end(), msg, msg + msg_len);
+        if (!this->datagram_ends.empty() && open_len + msg_len <= this->datagram_size) {
+            // Packed behind the records of the last datagram, the receiver splits them at the newlines
+            this->datagram_ends.back() = this->send_queue.size();
+        }
+        else {
+            // A record longer than a datagram is sent in several
+            for (size_t done = 0; done < msg_len; done += UDP_PAYLOAD_MAX) {
+                this->datagram_ends.push_back(start + std::min(msg_len, done + UDP_PAYLOAD_MAX));
+            }
+        }
+        if (queued < UDP_BATCH_MAX && this->datagram_ends.size() >= UDP_BATCH_MAX) {
+            this->reconnect_cv.notify_one();
+        }
+    }
+
+    void socket_appender::send_datagrams() {
+        {
+            std::unique_lock lock(this->reconnect_mutex);
+            this->reconnect_cv.wait_for(lock, this->flush_interval, [this] {
+                return this->stop_reconnect.load() || this->datagram_ends.size() >= UDP_BATCH_MAX;
+            });
+            std::swap(this->send_queue, this->send_batch);
+            std::swap(this->datagram_ends, this->batch_ends);
+        }
+        const char *data = this->send_batch.data();
+        const size_t count = this->batch_ends.size();
+        const auto deadline = std::chrono::steady_clock::now() + send_timeout;
+        size_t next = 0;
+        while (next < count) {
+#ifdef __linux__
+            // One syscall for up to UDP_BATCH_MAX datagrams
+            mmsghdr msgs[UDP_BATCH_MAX]{};
+            iovec iov[UDP_BATCH_MAX];
+            const size_t n = std::min(count - next, UDP_BATCH_MAX);
+            for (size_t i = 0; i < n; ++i) {
+                const size_t begin = 0 == next + i ? 0 : this->batch_ends[next + i - 1];
+                iov[i].iov_base = const_cast<char *>(data + begin);
+                iov[i].iov_len = this->batch_ends[next + i] - begin;
+                msgs[i].msg_hdr.msg_iov = &iov[i];
+                msgs[i].msg_hdr.msg_iovlen = 1;
+            }
+            const int sent = sendmmsg(this->sock_fd, msgs, static_cast<unsigned int>(n), 0);
+            if (sent > 0) {
+                next += static_cast<size_t>(sent);
+                continue;
+            }
+            if (EAGAIN == errno || EWOULDBLOCK == errno || EINTR == errno) {
+                if (this->stop_reconnect.load() && std::chrono::steady_clock::now() >= deadline) {
+                    break;
+                }
+                (void)wait_writable(SEND_POLL_INTERVAL);
+                continue;
+            }
+            // Refused by the peer (an ICMP port unreachable) or another error: UDP is best effort, skip the datagram
+            ++next;
+#else
+            const size_t begin = 0 == next ? 0 : this->batch_ends[next - 1];
+            (void)send(this->sock_fd, data + begin, static_cast<int>(this->batch_ends[next] - begin), 0);
+            ++next;
 #endif
+        }
+        this->send_batch.clear();
+        this->batch_ends.clear();
+    }
+
+    void socket_appender::udp_thread_routine() {
+        set_thread_name("udp_flush_worker");
+        // The last round runs after the stop, it sends what the logging threads queued until then
+        bool stopping;
+        do {
+            stopping = this->stop_reconnect.load();
+            send_datagrams();
+        } while (!stopping);
     }
 
     void socket_appender::reconnect_thread_routine() {
@@ -361,6 +596,11 @@ namespace log4cpp::appender {
         common::log4c_debug(stdout, "[socket_appender] reconnect thread is running...\n");
 #endif
         while (!this->stop_reconnect.load()) {
+            // Held by the appender a hot reload replaced until that one is destroyed
+            if (!this->spill_path.empty() && nullptr == this->spill &&
+                std::chrono::steady_clock::now() >= this->next_spill_open) {
+                open_spill();
+            }
             connection_fsm_state current_state;
             {
                 std::shared_lock r_lock(this->connection_rw_lock);
@@ -384,7 +624,7 @@ namespace log4cpp::appender {
                     }
                     break;
                 case connection_fsm_state::ESTABLISHED:
-                    wait_for_reconnect_or_stop();
+                    send_queued();
                     break;
             }
         }
@@ -393,39 +633,60 @@ namespace log4cpp::appender {
 #endif
     }
 
+    bool socket_appender::connected() const {
+        if (config::socket_appender::protocol::TCP == this->proto) {
+            return connection_fsm_state::ESTABLISHED == this->connection_state.load(std::memory_order_relaxed);
+        }
+        return common::INVALID_FD != this->sock_fd;
+    }
+
     void socket_appender::log(const char *msg, size_t msg_len) {
         if (config::socket_appender::protocol::TCP == this->proto) {
-            std::shared_lock r_lock(this->connection_rw_lock);
-            if (connection_fsm_state::ESTABLISHED != this->connection_state) {
+            // The record is queued for the I/O thread, the logging thread never waits on the network
+            const bool established =
+                connection_fsm_state::ESTABLISHED == this->connection_state.load(std::memory_order_relaxed);
+            if (!established && this->spill_path.empty()) {
                 return;
             }
-            ssize_t sent = send(this->sock_fd, msg, msg_len, 0);
-            if (sent < 0) {
-                // Connection lost, notify reconnect thread
-                r_lock.unlock();
-                std::unique_lock w_lock(this->connection_rw_lock);
-                // NOLINTNEXTLINE (double check)
-                if (connection_fsm_state::ESTABLISHED == this->connection_state) {
-#ifdef _WIN32
-                    auto wsaerr = WSAGetLastError();
-                    if (WSAECONNRESET == wsaerr || WSAESHUTDOWN == wsaerr || WSAENOTCONN == wsaerr) {
-#else
-                    if (errno == EPIPE || errno == ECONNRESET) {
-#endif
-                        // Connection lost, mark as disconnected
-                        common::close_socket(this->sock_fd);
-                        this->sock_fd = common::INVALID_FD;
-                        this->connection_state = connection_fsm_state::DISCONNECTED;
-                        // Notify reconnect thread
-                        this->reconnect_cv.notify_one();
-                    }
-                    // For other errors, just ignore
+            char header[FRAME_HEADER_MAX];
+            size_t header_len = 0;
+            if (config::framing::NONE != this->frame) {
+                // The length delimits the record, its newline would only be one more byte to strip
+                if (msg_len > 0 && '\n' == msg[msg_len - 1]) {
+                    --msg_len;
                 }
+                header_len = frame_header(this->frame, msg_len, header);
+            }
+            std::scoped_lock lock(this->reconnect_mutex);
+            if (nullptr != this->spill && (!established || !this->spill->empty())) {
+                // Down, or spilled records are still being replayed: spill this one behind them. Dropped if full.
+                (void)this->spill->push(header, header_len, msg, msg_len);
+                return;
+            }
+            if (!established) {
+                return;
+            }
+            // Full: the collector is slower than the application, drop the record. A longer one goes out alone.
+            if (!this->send_queue.empty() && this->send_queue.size() + header_len + msg_len > this->send_buffer_size) {
+                return;
+            }
+            const bool wake = this->send_queue.empty();
+            this->send_queue.insert(this->send_queue.end(), header, header + header_len);
+            this->send_queue.insert(this->send_queue.end(), msg, msg + msg_len);
+            if (wake) {
+                this->reconnect_cv.notify_one();
+            }
+        }
+        else if (this->flush_interval.count() > 0) {
+            if (common::INVALID_FD != this->sock_fd) {
+                queue_datagrams(msg, msg_len);
             }
         }
         else {
-            // For UDP, just ignore the error
-            (void)send(this->sock_fd, msg, msg_len, 0);
+            // For UDP, just ignore the error. A record longer than a datagram is sent in several.
+            for (size_t done = 0; done < msg_len; done += UDP_PAYLOAD_MAX) {
+                (void)send(this->sock_fd, msg + done, std::min(msg_len - done, UDP_PAYLOAD_MAX), 0);
+            }
         }
     }
 } // namespace log4cpp::appender
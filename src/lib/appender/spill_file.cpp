@@ -0,0 +1,168 @@
+#include <algorithm>
+#include <cstring>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "appender/spill_file.hpp"
+
+namespace log4cpp::appender {
+    /* "L4CSPILL", tells a spill file from anything else at the path */
+    constexpr uint64_t SPILL_MAGIC = 0x4c4c49505343344cULL;
+    /* The ring starts one page into the file */
+    constexpr size_t SPILL_HEADER_SIZE = 4096;
+    /* The length stored in front of each record */
+    constexpr size_t SPILL_RECORD_HEADER = sizeof(uint32_t);
+
+    class spill_header {
+    public:
+        uint64_t magic;
+        uint64_t capacity;
+        /* Bytes ever popped and pushed, the ring offset is the counter modulo the capacity */
+        uint64_t head;
+        uint64_t tail;
+    };
+
+#ifndef _WIN32
+    std::unique_ptr<spill_file> spill_file::open(const std::string &path, size_t capacity) {
+        const int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+        if (-1 == fd) {
+            return nullptr;
+        }
+        std::unique_ptr<spill_file> file(new spill_file());
+        file->fd = fd;
+        // Another appender (the one a hot reload replaces) still owns the file
+        if (flock(fd, LOCK_EX | LOCK_NB) == -1) {
+            return nullptr;
+        }
+        const size_t map_size = SPILL_HEADER_SIZE + capacity;
+        struct stat st {};
+        if (fstat(fd, &st) == -1) {
+            return nullptr;
+        }
+        // A file of another size is not a spill file of this capacity, it is started afresh
+        const bool fresh = static_cast<size_t>(st.st_size) != map_size;
+        if (fresh && ftruncate(fd, static_cast<off_t>(map_size)) == -1) {
+            return nullptr;
+        }
+        void *map = mmap(nullptr, map_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (MAP_FAILED == map) {
+            return nullptr;
+        }
+        file->map = map;
+        file->map_size = map_size;
+        file->hdr = static_cast<spill_header *>(map);
+        file->ring = static_cast<char *>(map) + SPILL_HEADER_SIZE;
+        file->capacity = capacity;
+        spill_header *hdr = file->hdr;
+        if (fresh || SPILL_MAGIC != hdr->magic || capacity != hdr->capacity || hdr->head > hdr->tail ||
+            hdr->tail - hdr->head > capacity) {
+            hdr->magic = SPILL_MAGIC;
+            hdr->capacity = capacity;
+            hdr->head = 0;
+            hdr->tail = 0;
+        }
+        return file;
+    }
+
+    spill_file::~spill_file() {
+        if (nullptr != this->map) {
+            munmap(this->map, this->map_size);
+        }
+        if (-1 != this->fd) {
+            // Closing drops the lock
+            close(this->fd);
+        }
+    }
+#else
+    std::unique_ptr<spill_file> spill_file::open(const std::string &, size_t) {
+        return nullptr;
+    }
+
+    spill_file::~spill_file() = default;
+#endif
+
+    void spill_file::write_ring(uint64_t pos, const char *src, size_t len) {
+        const size_t offset = static_cast<size_t>(pos % this->capacity);
+        const size_t first = std::min(len, static_cast<size_t>(this->capacity) - offset);
+        std::memcpy(this->ring + offset, src, first);
+        std::memcpy(this->ring, src + first, len - first);
+    }
+
+    void spill_file::read_ring(uint64_t pos, char *dst, size_t len) const {
+        const size_t offset = static_cast<size_t>(pos % this->capacity);
+        const size_t first = std::min(len, static_cast<size_t>(this->capacity) - offset);
+        std::memcpy(dst, this->ring + offset, first);
+        std::memcpy(dst + first, this->ring, len - first);
+    }
+
+    bool spill_file::push(const char *prefix, size_t prefix_len, const char *data, size_t len) {
+        const size_t record_len = prefix_len + len;
+        if (record_len > UINT32_MAX || SPILL_RECORD_HEADER + record_len > this->capacity - size()) {
+            return false;
+        }
+        const auto length = static_cast<uint32_t>(record_len);
+        uint64_t tail = this->hdr->tail;
+        write_ring(tail, reinterpret_cast<const char *>(&length), SPILL_RECORD_HEADER);
+        tail += SPILL_RECORD_HEADER;
+        write_ring(tail, prefix, prefix_len);
+        tail += prefix_len;
+        write_ring(tail, data, len);
+        tail += len;
+        // Published after the bytes, a process that dies in between leaves the record out
+        this->hdr->tail = tail;
+        return true;
+    }
+
+    size_t spill_file::peek(std::vector<char> &out, size_t max_bytes) const {
+        size_t copied = 0;
+        uint64_t head = this->hdr->head;
+        while (head < this->hdr->tail) {
+            uint32_t length = 0;
+            read_ring(head, reinterpret_cast<char *>(&length), SPILL_RECORD_HEADER);
+            if (copied > 0 && copied + length > max_bytes) {
+                break;
+            }
+            const size_t at = out.size();
+            out.resize(at + length);
+            read_ring(head + SPILL_RECORD_HEADER, out.data() + at, length);
+            head += SPILL_RECORD_HEADER + length;
+            copied += length;
+        }
+        return copied;
+    }
+
+    void spill_file::consume(size_t bytes) {
+        uint64_t head = this->hdr->head;
+        while (head < this->hdr->tail) {
+            uint32_t length = 0;
+            read_ring(head, reinterpret_cast<char *>(&length), SPILL_RECORD_HEADER);
+            if (length > bytes) {
+                break;
+            }
+            head += SPILL_RECORD_HEADER + length;
+            bytes -= length;
+        }
+        // A record sent whole is never replayed again, even if the process dies right after
+        this->hdr->head = head;
+    }
+
+    size_t spill_file::pop(std::vector<char> &out, size_t max_bytes) {
+        const size_t popped = peek(out, max_bytes);
+        consume(popped);
+        return popped;
+    }
+
+    bool spill_file::empty() const {
+        return this->hdr->head == this->hdr->tail;
+    }
+
+    size_t spill_file::size() const {
+        return static_cast<size_t>(this->hdr->tail - this->hdr->head);
+    }
+} // namespace log4cpp::appender
@@ -0,0 +1,288 @@
+#ifdef __linux__
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#endif
+
+#include "appender/uring_writer.hpp"
+
+#if defined(__NR_io_uring_setup) && defined(IORING_FEAT_RW_CUR_POS)
+#define LOG4CPP_HAVE_IO_URING 1
+#endif
+
+namespace log4cpp::appender {
+#ifdef LOG4CPP_HAVE_IO_URING
+    /* One write and nothing else is ever in the kernel, the smallest ring does */
+    constexpr unsigned int URING_ENTRIES = 2;
+
+    int uring_setup(unsigned int entries, io_uring_params *params) {
+        return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+    }
+
+    int uring_enter(int fd, unsigned int to_submit, unsigned int min_complete, unsigned int flags) {
+        return static_cast<int>(syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, nullptr, 0));
+    }
+
+    int uring_register(int fd, unsigned int opcode, const void *arg, unsigned int nr_args) {
+        return static_cast<int>(syscall(__NR_io_uring_register, fd, opcode, arg, nr_args));
+    }
+
+    template<typename T>
+    T *ring_field(void *ring, unsigned int offset) {
+        return reinterpret_cast<T *>(static_cast<char *>(ring) + offset);
+    }
+
+    std::unique_ptr<uring_writer> uring_writer::create(char *const buffers[], size_t count, size_t buffer_size) {
+        io_uring_params params{};
+        const int fd = uring_setup(URING_ENTRIES, &params);
+        if (-1 == fd) {
+            return nullptr;
+        }
+        std::unique_ptr<uring_writer> writer(new uring_writer());
+        writer->ring_fd = fd;
+        if ((params.features & IORING_FEAT_RW_CUR_POS) == 0) {
+            // Writes would need an explicit offset, which O_APPEND and the rename on rollover make unknown
+            return nullptr;
+        }
+        writer->sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned int);
+        writer->cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        const bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+        if (single_mmap) {
+            writer->sq_ring_size = std::max(writer->sq_ring_size, writer->cq_ring_size);
+        }
+        void *sq = mmap(nullptr, writer->sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd,
+                        IORING_OFF_SQ_RING);
+        if (MAP_FAILED == sq) {
+            return nullptr;
+        }
+        writer->sq_ring = sq;
+        if (single_mmap) {
+            writer->cq_ring = sq;
+        }
+        else {
+            void *cq = mmap(nullptr, writer->cq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd,
+                            IORING_OFF_CQ_RING);
+            if (MAP_FAILED == cq) {
+                return nullptr;
+            }
+            writer->cq_ring = cq;
+        }
+        writer->sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+        void *sqes = mmap(nullptr, writer->sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd,
+                          IORING_OFF_SQES);
+        if (MAP_FAILED == sqes) {
+            return nullptr;
+        }
+        writer->sqes = sqes;
+        writer->sq_tail = ring_field<unsigned int>(sq, params.sq_off.tail);
+        writer->sq_mask = *ring_field<unsigned int>(sq, params.sq_off.ring_mask);
+        writer->sq_array = ring_field<unsigned int>(sq, params.sq_off.array);
+        writer->cq_head = ring_field<unsigned int>(writer->cq_ring, params.cq_off.head);
+        writer->cq_tail = ring_field<unsigned int>(writer->cq_ring, params.cq_off.tail);
+        writer->cq_mask = *ring_field<unsigned int>(writer->cq_ring, params.cq_off.ring_mask);
+        writer->cqes = ring_field<void>(writer->cq_ring, params.cq_off.cqes);
+
+        writer->buffers.assign(buffers, buffers + count);
+        writer->buffer_size = buffer_size;
+        writer->requests.resize(count);
+        std::vector<iovec> iov;
+        for (char *buffer: writer->buffers) {
+            iov.push_back({buffer, buffer_size});
+        }
+        // Registering pins the pages, it fails over RLIMIT_MEMLOCK on older kernels. Plain writes work all the same.
+        const auto nr = static_cast<unsigned int>(count);
+        writer->fixed = uring_register(fd, IORING_REGISTER_BUFFERS, iov.data(), nr) == 0;
+        return writer;
+    }
+
+    uring_writer::~uring_writer() {
+        wait();
+        if (nullptr != this->sqes) {
+            munmap(this->sqes, this->sqes_size);
+        }
+        if (nullptr != this->cq_ring && this->cq_ring != this->sq_ring) {
+            munmap(this->cq_ring, this->cq_ring_size);
+        }
+        if (nullptr != this->sq_ring) {
+            munmap(this->sq_ring, this->sq_ring_size);
+        }
+        if (-1 != this->ring_fd) {
+            close(this->ring_fd);
+        }
+    }
+
+    size_t uring_writer::buffer_of(const char *data) const {
+        for (size_t i = 0; i < this->buffers.size(); ++i) {
+            if (data >= this->buffers[i] && data < this->buffers[i] + this->buffer_size) {
+                return i;
+            }
+        }
+        return this->buffers.size();
+    }
+
+    bool uring_writer::write(int file_fd, const char *data, size_t data_len) {
+        const size_t index = buffer_of(data);
+        if (index == this->buffers.size()) {
+            return false;
+        }
+        request &req = this->requests[index];
+        req.fd = file_fd;
+        req.buf = data;
+        req.len = data_len;
+        req.busy = true;
+        this->queued.push_back(index);
+        // Completions that arrived meanwhile start the next write, the caller does not wait for any
+        while (reap(false)) {
+        }
+        start();
+        return true;
+    }
+
+    bool uring_writer::submit(size_t index) {
+        const request &req = this->requests[index];
+        // This thread is the only producer, the kernel only reads the tail
+        const unsigned int tail = *this->sq_tail;
+        const unsigned int slot = tail & this->sq_mask;
+        auto *sqe = static_cast<io_uring_sqe *>(this->sqes) + slot;
+        std::memset(sqe, 0, sizeof(*sqe));
+        sqe->opcode = IORING_OP_WRITE;
+        sqe->fd = req.fd;
+        // -1: at the file position, the end of the file as it is opened with O_APPEND
+        sqe->off = static_cast<uint64_t>(-1);
+        sqe->addr = reinterpret_cast<uint64_t>(req.buf);
+        sqe->len = static_cast<uint32_t>(req.len);
+        sqe->user_data = index;
+        if (this->fixed) {
+            sqe->opcode = IORING_OP_WRITE_FIXED;
+            sqe->buf_index = static_cast<uint16_t>(index);
+        }
+        this->sq_array[slot] = slot;
+        __atomic_store_n(this->sq_tail, tail + 1, __ATOMIC_RELEASE);
+        int ret;
+        do {
+            ret = uring_enter(this->ring_fd, 1, 0, 0);
+        } while (-1 == ret && EINTR == errno);
+        if (1 == ret) {
+            return true;
+        }
+        // Not consumed, take the SQE back
+        __atomic_store_n(this->sq_tail, tail, __ATOMIC_RELEASE);
+        return false;
+    }
+
+    void uring_writer::start() {
+        while (!this->submitted && !this->queued.empty()) {
+            const size_t index = this->queued.front();
+            if (submit(index)) {
+                this->submitted = true;
+                return;
+            }
+            // Written here, behind the writes before it
+            request &req = this->requests[index];
+            while (req.len > 0) {
+                const ssize_t written = ::write(req.fd, req.buf, req.len);
+                if (written <= 0) {
+                    if (-1 == written && EINTR == errno) {
+                        continue;
+                    }
+                    break;
+                }
+                req.buf += written;
+                req.len -= static_cast<size_t>(written);
+            }
+            req.busy = false;
+            this->queued.pop_front();
+        }
+    }
+
+    bool uring_writer::reap(bool block) {
+        if (!this->submitted) {
+            return false;
+        }
+        const unsigned int head = *this->cq_head;
+        if (head == __atomic_load_n(this->cq_tail, __ATOMIC_ACQUIRE)) {
+            if (!block) {
+                return false;
+            }
+            if (uring_enter(this->ring_fd, 0, 1, IORING_ENTER_GETEVENTS) == -1 && EINTR != errno) {
+                // The ring is unusable, the request in flight is lost, the others are written with write()
+                this->requests[this->queued.front()].busy = false;
+                this->queued.pop_front();
+                this->submitted = false;
+                start();
+            }
+            return true;
+        }
+        const int res = (static_cast<io_uring_cqe *>(this->cqes) + (head & this->cq_mask))->res;
+        __atomic_store_n(this->cq_head, head + 1, __ATOMIC_RELEASE);
+        const size_t index = this->queued.front();
+        request &req = this->requests[index];
+        this->submitted = false;
+        if (-EINTR == res || -EAGAIN == res) {
+            // Submitted again before the writes queued behind it
+            start();
+            return true;
+        }
+        if (res > 0 && static_cast<size_t>(res) < req.len) {
+            req.buf += res;
+            req.len -= static_cast<size_t>(res);
+            start();
+            return true;
+        }
+        req.busy = false;
+        this->queued.pop_front();
+        start();
+        return true;
+    }
+
+    void uring_writer::wait(const char *data) {
+        const size_t index = buffer_of(data);
+        while (index < this->requests.size() && this->requests[index].busy) {
+            (void)reap(true);
+        }
+    }
+
+    void uring_writer::wait() {
+        while (!this->queued.empty()) {
+            (void)reap(true);
+        }
+    }
+#else
+    std::unique_ptr<uring_writer> uring_writer::create(char *const[], size_t, size_t) {
+        return nullptr;
+    }
+
+    uring_writer::~uring_writer() = default;
+
+    bool uring_writer::write(int, const char *, size_t) {
+        return false;
+    }
+
+    bool uring_writer::submit(size_t) {
+        return false;
+    }
+
+    void uring_writer::start() {
+    }
+
+    bool uring_writer::reap(bool) {
+        return false;
+    }
+
+    void uring_writer::wait(const char *) {
+    }
+
+    void uring_writer::wait() {
+    }
+#endif
+} // namespace log4cpp::appender
+
+#endif
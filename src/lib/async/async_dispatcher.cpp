@@ -0,0 +1,214 @@
+#include <chrono>
+#include <cstring>
+
+#include "async/async_dispatcher.hpp"
+#include "common/log_utils.hpp"
+
+namespace log4cpp::async {
+    bool async_record::store_args(const format::format_args &args) {
+        if (args.count > DEFERRED_ARGS_MAX) {
+            return false;
+        }
+        // The argument array first, then the string bytes. Strings are stored as an offset into text, so the record
+        // can be copied out of the queue cell.
+        size_t used = args.count * sizeof(format::format_arg);
+        for (size_t i = 0; i < args.count; ++i) {
+            format::format_arg arg = args.args[i];
+            if ((format::arg_type::CSTRING == arg.type && nullptr != arg.value.s) ||
+                format::arg_type::STRING == arg.type) {
+                const char *str = arg.value.s;
+                const size_t room = sizeof(text) - used;
+                const size_t size = format::arg_type::STRING == arg.type ? arg.size : strnlen(str, room + 1);
+                if (size > room) {
+                    return false;
+                }
+                std::memcpy(text + used, str, size);
+                arg.type = format::arg_type::STRING;
+                arg.value.u = used;
+                arg.size = size;
+                used += size;
+            }
+            std::memcpy(text + i * sizeof(format::format_arg), &arg, sizeof(arg));
+        }
+        fmt = args.fmt;
+        arg_count = args.count;
+        len = used;
+        return true;
+    }
+
+    format::format_args async_record::load_args(format::format_arg *out) const {
+        for (size_t i = 0; i < arg_count; ++i) {
+            std::memcpy(&out[i], text + i * sizeof(format::format_arg), sizeof(format::format_arg));
+            if (format::arg_type::STRING == out[i].type) {
+                out[i].value.s = text + out[i].value.u;
+            }
+        }
+        return format::format_args{fmt, out, arg_count};
+    }
+
+    // Upper bound for a backend wait, in case a wakeup is missed
+    constexpr auto BACKEND_IDLE_TIMEOUT = std::chrono::milliseconds(100);
+    // Upper bound for a producer waiting for room, in case a wakeup is missed
+    constexpr auto PRODUCER_WAIT_TIMEOUT = std::chrono::milliseconds(10);
+
+    async_dispatcher::async_dispatcher(const config::async_mode &cfg) :
+        cfg_(cfg), ring_(cfg.queue_size), high_water_(ring_.capacity() - ring_.capacity() / 4) {
+        backend_ = std::thread(&async_dispatcher::run, this);
+    }
+
+    async_dispatcher::~async_dispatcher() {
+        shutdown();
+    }
+
+    void async_dispatcher::shutdown() {
+        std::lock_guard<std::mutex> lock(shutdown_mtx_);
+        stopping_.store(true, std::memory_order_seq_cst);
+        {
+            std::lock_guard<std::mutex> idle_lock(idle_mtx_);
+            idle_cv_.notify_one();
+        }
+        if (backend_.joinable()) {
+            backend_.join();
+        }
+    }
+
+    bool async_dispatcher::dispatch_one() {
+        const auto slot = ring_.claim_pop();
+        if (!slot) {
+            return false;
+        }
+        // Copy the record out and free the cell before the (slow) write, so a full queue always means
+        // capacity() records are waiting and DROP_OLDEST can make room by evicting the head
+        async_record &record = *slot.data;
+        current_.level = record.level;
+        current_.len = record.len;
+        current_.logger_key = record.logger_key;
+        if (record.large.empty()) {
+            std::memcpy(current_.text, record.text, record.len);
+        }
+        else {
+            std::swap(current_.large, record.large);
+        }
+        current_.appenders = std::move(record.appenders);
+        current_.source = std::move(record.source);
+        if (nullptr != current_.source) {
+            current_.fmt = record.fmt;
+            current_.arg_count = record.arg_count;
+            current_.origin = record.origin;
+        }
+        ring_.release(slot);
+        wake_producer();
+
+        const char *line = current_.large.empty() ? current_.text : current_.large.data();
+        size_t line_len = current_.len;
+        if (nullptr != current_.source) {
+            format::format_arg args[DEFERRED_ARGS_MAX];
+            common::line_writer writer(line_, current_.source->max_line_size);
+            line_len = current_.source->pattern.format(writer, current_.source->name.c_str(), current_.level,
+                                                       current_.origin, current_.load_args(args));
+            line = line_.data();
+        }
+        for (const auto &appender: *current_.appenders) {
+            appender->log_keyed(current_.logger_key, line, line_len);
+            if (current_.level <= log_level::ERROR) {
+                appender->flush();
+            }
+            if (appender->sync_due(current_.level)) {
+                appender->sync();
+            }
+        }
+        // Drop the references now, not when the next record arrives, so retired appenders are closed promptly
+        current_.appenders.reset();
+        current_.source.reset();
+        if (!current_.large.empty()) {
+            return_large_buffer(std::move(current_.large));
+        }
+        return true;
+    }
+
+    std::vector<char> async_dispatcher::take_large_buffer() {
+        {
+            std::lock_guard<std::mutex> lock(large_mtx_);
+            if (!large_pool_.empty()) {
+                std::vector<char> buffer = std::move(large_pool_.back());
+                large_pool_.pop_back();
+                return buffer;
+            }
+        }
+        return std::vector<char>(2 * LOG_LINE_MAX);
+    }
+
+    void async_dispatcher::return_large_buffer(std::vector<char> buffer) {
+        if (buffer.size() > common::LINE_BUFFER_KEEP_MAX) {
+            return;
+        }
+        std::lock_guard<std::mutex> lock(large_mtx_);
+        if (large_pool_.size() < LARGE_BUFFER_POOL_MAX) {
+            large_pool_.push_back(std::move(buffer));
+        }
+    }
+
+    void async_dispatcher::wait_for_room() {
+        std::unique_lock<std::mutex> lock(room_mtx_);
+        blocked_producers_.fetch_add(1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        // A cell the backend is still copying out of is not counted, it is freed right after: retry then
+        if (ring_.size() >= ring_.capacity()) {
+            room_cv_.wait_for(lock, PRODUCER_WAIT_TIMEOUT);
+        }
+        blocked_producers_.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    void async_dispatcher::discard_oldest() {
+        // The next push cell is only the head of the queue if every cell is queued. Otherwise the backend is still
+        // copying out of it, evicting the head would lose a record without making room.
+        if (ring_.size() < ring_.capacity()) {
+            std::this_thread::yield();
+            return;
+        }
+        const auto slot = ring_.claim_pop();
+        if (!slot) {
+            return;
+        }
+        count_drop(slot.data->dropped);
+        slot.data->appenders.reset();
+        slot.data->source.reset();
+        if (!slot.data->large.empty()) {
+            return_large_buffer(std::move(slot.data->large));
+        }
+        ring_.release(slot);
+    }
+
+    void async_dispatcher::run() {
+        set_thread_name("log4cpp_async");
+#ifdef _DEBUG
+        common::log4c_debug(stdout, "[async_dispatcher] backend started, queue size %zu\n", ring_.capacity());
+#endif
+        for (;;) {
+            if (dispatch_one()) {
+                continue;
+            }
+            // Once stopping_ is set new producers back off, when none is left inside submit() the queue is final
+            if (stopping_.load(std::memory_order_seq_cst) && 0 == producers_.load(std::memory_order_acquire)) {
+                while (dispatch_one()) {
+                }
+                break;
+            }
+            if (ring_.size() != 0) {
+                // A producer has claimed a cell but is still formatting into it
+                std::this_thread::yield();
+                continue;
+            }
+            std::unique_lock<std::mutex> lock(idle_mtx_);
+            backend_idle_.store(true, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (0 == ring_.size() && !stopping_.load(std::memory_order_relaxed)) {
+                idle_cv_.wait_for(lock, BACKEND_IDLE_TIMEOUT);
+            }
+            backend_idle_.store(false, std::memory_order_relaxed);
+        }
+#ifdef _DEBUG
+        common::log4c_debug(stdout, "[async_dispatcher] backend stopped\n");
+#endif
+    }
+} // namespace log4cpp::async
@@ -22,12 +22,12 @@
 namespace log4cpp {
     // Platform-specific implementations for thread name management.
     /**
-     * @brief Gets the name and ID of the current thread in a platform-independent way.
+     * @brief Reads the name and ID of the current thread from the system in a platform-independent way.
      * @param[out] thread_name Buffer to store the retrieved thread name.
      * @param len The size of the thread_name buffer.
      * @return The current thread's ID.
      */
-    unsigned long get_thread_name_id(char *thread_name, size_t len) {
+    unsigned long query_thread_name_id(char *thread_name, size_t len) {
         thread_name[0] = '\0';
 #ifdef _MSC_VER
         (void)len;
@@ -55,6 +55,43 @@ namespace log4cpp {
         return tid;
     }
 
+    namespace common {
+        /* The calling thread's identity, resolved is false until it has been read from the system */
+        class thread_identity_cache {
+        public:
+            thread_identity identity;
+            bool resolved{false};
+        };
+
+        thread_local thread_identity_cache tls_thread_identity;
+
+        const thread_identity &current_thread_identity() {
+            thread_identity_cache &cache = tls_thread_identity;
+            if (!cache.resolved) {
+                // pthread_getname_np reads /proc/self/task/<tid>/comm on Linux, once per thread and name is enough
+                cache.identity.id = query_thread_name_id(cache.identity.name, sizeof(cache.identity.name));
+                cache.resolved = true;
+            }
+            return cache.identity;
+        }
+    } // namespace common
+
+    /**
+     * @brief Gets the name and ID of the current thread, from the per-thread cache.
+     * @param[out] thread_name Buffer to store the retrieved thread name.
+     * @param len The size of the thread_name buffer.
+     * @return The current thread's ID.
+     */
+    unsigned long get_thread_name_id(char *thread_name, size_t len) {
+        const common::thread_identity &identity = common::current_thread_identity();
+        if (len > 0) {
+            const size_t n = std::min(strnlen(identity.name, sizeof(identity.name)), len - 1);
+            std::memcpy(thread_name, identity.name, n);
+            thread_name[n] = '\0';
+        }
+        return identity.id;
+    }
+
     /**
      * @brief Sets the name of the current thread in a platform-independent way.
      * @param name The desired name for the thread.
@@ -75,6 +112,8 @@ namespace log4cpp {
         common::log4c_scnprintf(buf, sizeof(buf), "%s", name);
         prctl(PR_SET_NAME, buf);
 #endif
+        // Read back on the next use, the system may have shortened or converted the name
+        common::tls_thread_identity.resolved = false;
     }
 } // namespace log4cpp
 
@@ -223,12 +262,30 @@ namespace log4cpp::common {
         const auto now = std::chrono::system_clock::now();
         const auto now_ms = std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch()) % 1000;
         const std::time_t now_time_t = std::chrono::system_clock::to_time_t(now);
+        get_local_time(now_time_t, now_tm);
+        ms = static_cast<unsigned short>(now_ms.count());
+    }
+
+    /**
+     * @brief Converts a calendar time to local time, reusing the previous result of this thread for the same second.
+     *
+     * @param t Seconds since epoch.
+     * @param[out] local_tm The output `tm` struct.
+     */
+    void get_local_time(std::time_t t, tm &local_tm) {
+        thread_local bool cached = false;
+        thread_local std::time_t cached_time = 0;
+        thread_local tm cached_tm{};
+        if (!cached || cached_time != t) {
 #ifdef _WIN32
-        localtime_s(&now_tm, &now_time_t);
+            localtime_s(&cached_tm, &t);
 #else
-        localtime_r(&now_time_t, &now_tm);
+            localtime_r(&t, &cached_tm);
 #endif
-        ms = static_cast<unsigned short>(now_ms.count());
+            cached_time = t;
+            cached = true;
+        }
+        local_tm = cached_tm;
     }
 
     /**
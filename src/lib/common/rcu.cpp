@@ -0,0 +1,103 @@
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+
+#include "common/rcu.hpp"
+
+namespace log4cpp::common::rcu {
+    /**
+     * @brief The read-side state of one thread, on its own cache line.
+     *
+     * Records are linked into a push-only list and reused by later threads, they are never freed.
+     */
+    class reader_record {
+    public:
+        /* The grace period the thread entered its outermost section in, 0 outside a section */
+        alignas(64) std::atomic<uint64_t> epoch{0};
+        /* Section nesting depth, only touched by the owning thread */
+        unsigned int nesting{0};
+        std::atomic<bool> in_use{false};
+        reader_record *next{nullptr};
+    };
+
+    std::atomic<reader_record *> reader_list{nullptr};
+    std::atomic<uint64_t> global_epoch{1};
+    // Serializes synchronize(), so grace periods do not interleave
+    std::mutex synchronize_mtx;
+
+    reader_record *acquire_record() {
+        for (reader_record *r = reader_list.load(std::memory_order_acquire); r != nullptr; r = r->next) {
+            bool expected = false;
+            if (!r->in_use.load(std::memory_order_relaxed) &&
+                r->in_use.compare_exchange_strong(expected, true, std::memory_order_acquire)) {
+                return r;
+            }
+        }
+        auto *r = new reader_record();
+        r->in_use.store(true, std::memory_order_relaxed);
+        r->next = reader_list.load(std::memory_order_relaxed);
+        while (!reader_list.compare_exchange_weak(r->next, r, std::memory_order_release, std::memory_order_relaxed)) {
+        }
+        return r;
+    }
+
+    thread_local reader_record *tls_reader = nullptr;
+    thread_local bool tls_reader_retired = false;
+
+    // Hands the record of an exiting thread to the next new thread.
+    class reader_releaser {
+    public:
+        ~reader_releaser() {
+            if (tls_reader != nullptr) {
+                tls_reader->in_use.store(false, std::memory_order_release);
+                tls_reader = nullptr;
+            }
+            tls_reader_retired = true;
+        }
+    };
+
+    reader_record *local_record() {
+        if (nullptr == tls_reader) {
+            tls_reader = acquire_record();
+            // A thread logging from a thread_local destructor after the releaser has run keeps its record
+            if (!tls_reader_retired) {
+                thread_local reader_releaser releaser;
+                (void)releaser;
+            }
+        }
+        return tls_reader;
+    }
+
+    void read_lock() {
+        reader_record *r = local_record();
+        if (0 == r->nesting++) {
+            r->epoch.store(global_epoch.load(std::memory_order_acquire), std::memory_order_relaxed);
+            // Order the epoch store before the loads of the section, pairs with the fence in synchronize()
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+        }
+    }
+
+    void read_unlock() {
+        reader_record *r = tls_reader;
+        if (0 == --r->nesting) {
+            r->epoch.store(0, std::memory_order_release);
+        }
+    }
+
+    void synchronize() {
+        std::lock_guard<std::mutex> lock(synchronize_mtx);
+        // Readers entering from now on see the epoch after the increment, and the pointer published before it
+        const uint64_t epoch = global_epoch.fetch_add(1, std::memory_order_seq_cst) + 1;
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        for (reader_record *r = reader_list.load(std::memory_order_acquire); r != nullptr; r = r->next) {
+            for (;;) {
+                const uint64_t reader_epoch = r->epoch.load(std::memory_order_acquire);
+                if (0 == reader_epoch || reader_epoch >= epoch) {
+                    break;
+                }
+                std::this_thread::yield();
+            }
+        }
+    }
+} // namespace log4cpp::common::rcu
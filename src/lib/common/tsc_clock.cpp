@@ -0,0 +1,198 @@
+#include <atomic>
+#include <cmath>
+#include <cstdlib>
+#include <mutex>
+#include <thread>
+
+#include "common/tsc_clock.hpp"
+
+#if defined(LOG4CPP_HAVE_TSC) && !defined(_MSC_VER)
+#include <cpuid.h>
+#endif
+
+namespace log4cpp::common::tsc_clock {
+    /* How long the ticks are counted for the first rate estimate */
+    constexpr auto CALIBRATION_WINDOW = std::chrono::milliseconds(10);
+    /* A wall clock further than this from the time extrapolated from the last point was stepped, or the rate is off */
+    constexpr int64_t STEP_ERROR_MAX_NS = 1000000;
+    /* Two windows whose rates differ by less than this agree, the rate is off rather than the clock stepped */
+    constexpr double RATE_DRIFT_MAX = 0.001;
+    /* A sample whose TSC reads are this close was not interrupted, about a microsecond */
+    constexpr uint64_t SAMPLE_TICKS_MAX = 2000;
+    constexpr int SAMPLE_TRIES = 5;
+
+    // Serializes calibrate() and the recalibrations, guards the anchor
+    std::mutex calibrate_mtx;
+    bool calibrated{false};
+    std::atomic<bool> tsc_enabled{false};
+    /* The rate is measured from this point, over a window that grows with every recalibration */
+    uint64_t anchor_tsc{0};
+    int64_t anchor_ns{0};
+    /* The rate measured between the last two points */
+    double window_rate{0};
+
+    /* The last calibration point and the rate, written under a sequence lock: odd while being written */
+    std::atomic<uint64_t> sequence{0};
+    std::atomic<uint64_t> base_tsc{0};
+    std::atomic<int64_t> base_ns{0};
+    std::atomic<double> ns_per_tick{0};
+    /* About a second worth of ticks, a new point is taken when a conversion is this far past the last one */
+    std::atomic<uint64_t> recalibrate_ticks{0};
+
+    int64_t realtime_ns() {
+        const auto since_epoch = std::chrono::system_clock::now().time_since_epoch();
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(since_epoch).count();
+    }
+
+    // A TSC value and the wall clock at the same moment, the TSC is read on both sides and averaged. A read interrupted
+    // in between is taken again, the tightest one is kept.
+    void sample(uint64_t &tsc, int64_t &ns) {
+        uint64_t spread = UINT64_MAX;
+        for (int i = 0; i < SAMPLE_TRIES && spread > SAMPLE_TICKS_MAX; ++i) {
+            const uint64_t before = ticks();
+            const int64_t now_ns = realtime_ns();
+            const uint64_t after = ticks();
+            if (after - before < spread) {
+                spread = after - before;
+                tsc = before + spread / 2;
+                ns = now_ns;
+            }
+        }
+    }
+
+    bool invariant_tsc() {
+#ifdef LOG4CPP_HAVE_TSC
+        // CPUID 0x80000007 EDX bit 8: the TSC runs at a constant rate in all ACPI P-, C- and T-states
+#ifdef _MSC_VER
+        int regs[4];
+        __cpuid(regs, 0x80000000);
+        if (static_cast<unsigned int>(regs[0]) < 0x80000007U) {
+            return false;
+        }
+        __cpuid(regs, 0x80000007);
+        return (static_cast<unsigned int>(regs[3]) & (1U << 8)) != 0;
+#else
+        unsigned int eax = 0;
+        unsigned int ebx = 0;
+        unsigned int ecx = 0;
+        unsigned int edx = 0;
+        if (0 == __get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx)) {
+            return false;
+        }
+        return (edx & (1U << 8)) != 0;
+#endif
+#else
+        return false;
+#endif
+    }
+
+    void publish(uint64_t tsc, int64_t ns, double rate) {
+        const uint64_t seq = sequence.load(std::memory_order_relaxed);
+        sequence.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        base_tsc.store(tsc, std::memory_order_relaxed);
+        base_ns.store(ns, std::memory_order_relaxed);
+        ns_per_tick.store(rate, std::memory_order_relaxed);
+        sequence.store(seq + 2, std::memory_order_release);
+    }
+
+    bool calibrate() {
+        std::lock_guard lock(calibrate_mtx);
+        if (calibrated) {
+            return tsc_enabled.load(std::memory_order_relaxed);
+        }
+        calibrated = true;
+        if (!invariant_tsc()) {
+            return false;
+        }
+        sample(anchor_tsc, anchor_ns);
+        std::this_thread::sleep_for(CALIBRATION_WINDOW);
+        uint64_t tsc = 0;
+        int64_t ns = 0;
+        sample(tsc, ns);
+        if (tsc <= anchor_tsc || ns <= anchor_ns) {
+            return false;
+        }
+        const double rate = static_cast<double>(ns - anchor_ns) / static_cast<double>(tsc - anchor_tsc);
+        window_rate = rate;
+        recalibrate_ticks.store(static_cast<uint64_t>(1e9 / rate), std::memory_order_relaxed);
+        publish(tsc, ns, rate);
+        tsc_enabled.store(true, std::memory_order_release);
+        return true;
+    }
+
+    bool enabled() {
+        return tsc_enabled.load(std::memory_order_acquire);
+    }
+
+    // Take a new calibration point, unless another thread is taking one
+    void recalibrate() {
+        std::unique_lock lock(calibrate_mtx, std::try_to_lock);
+        if (!lock.owns_lock() || !tsc_enabled.load(std::memory_order_relaxed)) {
+            return;
+        }
+        uint64_t tsc = 0;
+        int64_t ns = 0;
+        sample(tsc, ns);
+        if (tsc - base_tsc.load(std::memory_order_relaxed) < recalibrate_ticks.load(std::memory_order_relaxed)) {
+            // Another thread has just taken one
+            return;
+        }
+        const uint64_t point_tsc = base_tsc.load(std::memory_order_relaxed);
+        const int64_t point_ns = base_ns.load(std::memory_order_relaxed);
+        const double old_rate = ns_per_tick.load(std::memory_order_relaxed);
+        const double last_window_rate = window_rate;
+        window_rate = static_cast<double>(ns - point_ns) / static_cast<double>(tsc - point_tsc);
+        // How far the wall clock is from the time the clock would have shown, not how much the rate moved: a rate that
+        // was off from the start must not be taken for a steady one
+        const int64_t error =
+            ns - point_ns - static_cast<int64_t>(std::llround(static_cast<double>(tsc - point_tsc) * old_rate));
+        double rate = old_rate;
+        if (std::llabs(error) <= STEP_ERROR_MAX_NS) {
+            if (ns > anchor_ns) {
+                rate = static_cast<double>(ns - anchor_ns) / static_cast<double>(tsc - anchor_tsc);
+            }
+        }
+        else if (window_rate > 0 && std::fabs(window_rate / last_window_rate - 1) <= RATE_DRIFT_MAX) {
+            // The last two windows agree with each other but not with the rate: the rate was off, take theirs
+            rate = window_rate;
+            anchor_tsc = point_tsc;
+            anchor_ns = point_ns;
+        }
+        else {
+            // The wall clock jumped: follow it, but measure the rate afresh from here
+            anchor_tsc = tsc;
+            anchor_ns = ns;
+        }
+        publish(tsc, ns, rate);
+    }
+
+    std::chrono::system_clock::time_point to_time(uint64_t tsc) {
+        uint64_t seq = 0;
+        uint64_t point_tsc = 0;
+        int64_t point_ns = 0;
+        double rate = 0;
+        do {
+            seq = sequence.load(std::memory_order_acquire);
+            point_tsc = base_tsc.load(std::memory_order_relaxed);
+            point_ns = base_ns.load(std::memory_order_relaxed);
+            rate = ns_per_tick.load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+        } while ((seq & 1) != 0 || seq != sequence.load(std::memory_order_relaxed));
+        // Negative for a value read before the last calibration point, e.g. by a queued record
+        const auto delta = static_cast<int64_t>(tsc - point_tsc);
+        if (delta > 0 && static_cast<uint64_t>(delta) >= recalibrate_ticks.load(std::memory_order_relaxed)) {
+            recalibrate();
+        }
+        const int64_t ns = point_ns + static_cast<int64_t>(std::llround(static_cast<double>(delta) * rate));
+        return std::chrono::system_clock::time_point(
+            std::chrono::duration_cast<std::chrono::system_clock::duration>(std::chrono::nanoseconds(ns)));
+    }
+
+    std::chrono::system_clock::time_point now() {
+        if (enabled()) {
+            return to_time(ticks());
+        }
+        return std::chrono::system_clock::now();
+    }
+} // namespace log4cpp::common::tsc_clock
@@ -1,4 +1,8 @@
+#include <climits>
+#include <string>
+
 #include "config/appender.hpp"
+#include "exception/config_exception.hpp"
 
 #include <common/log_utils.hpp>
 
@@ -19,12 +23,243 @@ namespace log4cpp::config {
     // file appender
     // =========================================================
 
+    void to_string(rolling_interval interval, std::string &str) {
+        for (const auto &entry: ROLLING_INTERVAL_TABLE) {
+            if (entry.interval == interval) {
+                str = entry.name;
+                return;
+            }
+        }
+        str.clear();
+    }
+
+    void from_string(const std::string &str, rolling_interval &interval) {
+        const std::string name = common::to_lower(str);
+        for (const auto &entry: ROLLING_INTERVAL_TABLE) {
+            if (name == entry.name) {
+                interval = entry.interval;
+                return;
+            }
+        }
+        throw invalid_config_exception("unknown rolling interval: " + str);
+    }
+
+    void to_string(compression compress, std::string &str) {
+        for (const auto &entry: COMPRESSION_TABLE) {
+            if (entry.compress == compress) {
+                str = entry.name;
+                return;
+            }
+        }
+        str.clear();
+    }
+
+    void from_string(const std::string &str, compression &compress) {
+        const std::string name = common::to_lower(str);
+        for (const auto &entry: COMPRESSION_TABLE) {
+            if (name == entry.name) {
+                compress = entry.compress;
+#ifndef LOG4CPP_HAVE_ZLIB
+                if (compression::GZIP == compress) {
+                    throw invalid_config_exception("compression 'gzip' needs zlib, not built in");
+                }
+#endif
+#ifndef LOG4CPP_HAVE_ZSTD
+                if (compression::ZSTD == compress) {
+                    throw invalid_config_exception("compression 'zstd' needs libzstd, not built in");
+                }
+#endif
+                return;
+            }
+        }
+        throw invalid_config_exception("unknown compression: " + str);
+    }
+
+    void to_string(write_mode mode, std::string &str) {
+        for (const auto &entry: WRITE_MODE_TABLE) {
+            if (entry.mode == mode) {
+                str = entry.name;
+                return;
+            }
+        }
+        str.clear();
+    }
+
+    void from_string(const std::string &str, write_mode &mode) {
+        const std::string name = common::to_lower(str);
+        for (const auto &entry: WRITE_MODE_TABLE) {
+            if (name == entry.name) {
+                mode = entry.mode;
+                return;
+            }
+        }
+        throw invalid_config_exception("unknown write mode: " + str);
+    }
+
+    void to_string(framing frame, std::string &str) {
+        for (const auto &entry: FRAMING_TABLE) {
+            if (entry.frame == frame) {
+                str = entry.name;
+                return;
+            }
+        }
+        str.clear();
+    }
+
+    void from_string(const std::string &str, framing &frame) {
+        const std::string name = common::to_lower(str);
+        for (const auto &entry: FRAMING_TABLE) {
+            if (name == entry.name) {
+                frame = entry.frame;
+                return;
+            }
+        }
+        throw invalid_config_exception("unknown framing: " + str);
+    }
+
+    void to_string(balance_policy policy, std::string &str) {
+        for (const auto &entry: BALANCE_POLICY_TABLE) {
+            if (entry.policy == policy) {
+                str = entry.name;
+                return;
+            }
+        }
+        str.clear();
+    }
+
+    void from_string(const std::string &str, balance_policy &policy) {
+        const std::string name = common::to_lower(str);
+        for (const auto &entry: BALANCE_POLICY_TABLE) {
+            if (name == entry.name) {
+                policy = entry.policy;
+                return;
+            }
+        }
+        throw invalid_config_exception("unknown balance policy: " + str);
+    }
+
+    size_t parse_size(const json_value &j, const char *key) {
+        if (j.is_number()) {
+            const int64_t size = j.get<int64_t>();
+            if (size < 0) {
+                throw invalid_config_exception(std::string("'") + key + "' must not be negative");
+            }
+            return static_cast<size_t>(size);
+        }
+        const std::string str = common::to_upper(j.get<std::string>());
+        size_t digits = 0;
+        while (digits < str.size() && str[digits] >= '0' && str[digits] <= '9') {
+            ++digits;
+        }
+        const std::string unit = str.substr(digits);
+        size_t multiplier = 1;
+        if (unit == "KB" || unit == "K") {
+            multiplier = 1024;
+        }
+        else if (unit == "MB" || unit == "M") {
+            multiplier = 1024 * 1024;
+        }
+        else if (unit == "GB" || unit == "G") {
+            multiplier = 1024 * 1024 * 1024;
+        }
+        else if (!unit.empty() && unit != "B") {
+            digits = 0;
+        }
+        if (0 == digits || digits > 15) {
+            throw invalid_config_exception(std::string("invalid '") + key + "': " + str);
+        }
+        return static_cast<size_t>(std::stoull(str.substr(0, digits))) * multiplier;
+    }
+
     void to_json(json_value &j, const file_appender &config) {
-        j = json_value{{"file-path", config.file_path}};
+        std::string rolling_str;
+        to_string(config.rolling, rolling_str);
+        std::string compress_str;
+        to_string(config.compress, compress_str);
+        std::string mode_str;
+        to_string(config.mode, mode_str);
+        j = json_value{
+            {"file-path", config.file_path},
+            {"buffer-size", json_value(static_cast<uint64_t>(config.buffer_size))},
+            {"flush-interval-ms", json_value(static_cast<uint64_t>(config.flush_interval_ms))},
+            {"max-file-size", json_value(static_cast<uint64_t>(config.max_file_size))},
+            {"max-backup-index", json_value(static_cast<uint64_t>(config.max_backup_index))},
+            {"rolling-interval", rolling_str},
+            {"compression", compress_str},
+            {"write-mode", mode_str},
+            {"sync-interval-ms", json_value(static_cast<uint64_t>(config.sync_interval_ms))},
+            {"sync-bytes", json_value(static_cast<uint64_t>(config.sync_bytes))},
+        };
+        if (config.sync_level.has_value()) {
+            std::string str;
+            to_string(config.sync_level.value(), str);
+            j["sync-level"] = json_value(str);
+        }
     }
 
     void from_json(const json_value &j, file_appender &config) {
         j.at("file-path").get_to(config.file_path);
+        config.buffer_size = 0;
+        if (j.contains("buffer-size")) {
+            const int64_t buffer_size = j.at("buffer-size").get<int64_t>();
+            if (buffer_size < 0) {
+                throw invalid_config_exception("'file.buffer-size' must not be negative");
+            }
+            config.buffer_size = static_cast<size_t>(buffer_size);
+        }
+        config.flush_interval_ms = FILE_FLUSH_INTERVAL_MS_DEFAULT;
+        if (j.contains("flush-interval-ms")) {
+            const int64_t interval = j.at("flush-interval-ms").get<int64_t>();
+            if (interval < 0 || interval > UINT_MAX) {
+                throw invalid_config_exception("'file.flush-interval-ms' must be between 0 and " +
+                                               std::to_string(UINT_MAX));
+            }
+            config.flush_interval_ms = static_cast<unsigned int>(interval);
+        }
+        config.max_file_size = 0;
+        if (j.contains("max-file-size")) {
+            config.max_file_size = parse_size(j.at("max-file-size"), "file.max-file-size");
+        }
+        config.max_backup_index = FILE_MAX_BACKUP_INDEX_DEFAULT;
+        if (j.contains("max-backup-index")) {
+            const int64_t index = j.at("max-backup-index").get<int64_t>();
+            if (index < 0 || index > FILE_MAX_BACKUP_INDEX_MAX) {
+                throw invalid_config_exception("'file.max-backup-index' must be between 0 and " +
+                                               std::to_string(FILE_MAX_BACKUP_INDEX_MAX));
+            }
+            config.max_backup_index = static_cast<unsigned int>(index);
+        }
+        config.rolling = rolling_interval::NONE;
+        if (j.contains("rolling-interval")) {
+            from_string(j.at("rolling-interval").get<std::string>(), config.rolling);
+        }
+        config.compress = compression::NONE;
+        if (j.contains("compression")) {
+            from_string(j.at("compression").get<std::string>(), config.compress);
+        }
+        config.mode = write_mode::WRITE;
+        if (j.contains("write-mode")) {
+            from_string(j.at("write-mode").get<std::string>(), config.mode);
+        }
+        config.sync_level = std::nullopt;
+        if (j.contains("sync-level")) {
+            log_level level;
+            from_string(j.at("sync-level").get<std::string>(), level);
+            config.sync_level = level;
+        }
+        config.sync_interval_ms = 0;
+        if (j.contains("sync-interval-ms")) {
+            const int64_t interval = j.at("sync-interval-ms").get<int64_t>();
+            if (interval < 0 || interval > UINT_MAX) {
+                throw invalid_config_exception("'file.sync-interval-ms' must be between 0 and " +
+                                               std::to_string(UINT_MAX));
+            }
+            config.sync_interval_ms = static_cast<unsigned int>(interval);
+        }
+        config.sync_bytes = 0;
+        if (j.contains("sync-bytes")) {
+            config.sync_bytes = parse_size(j.at("sync-bytes"), "file.sync-bytes");
+        }
     }
 
     // =========================================================
@@ -34,17 +269,63 @@ namespace log4cpp::config {
     void to_json(json_value &j, const socket_appender &config) {
         std::string prefer_str;
         to_string(config.prefer, prefer_str);
+        std::string framing_str;
+        to_string(config.frame, framing_str);
         j = json_value{
             {"host", config.host},
             {"port", json_value(static_cast<uint64_t>(config.port))},
             {"protocol", std::string(config.proto == socket_appender::protocol::TCP ? "TCP" : "UDP")},
             {"prefer-stack", prefer_str},
+            {"send-buffer-size", json_value(static_cast<uint64_t>(config.send_buffer_size))},
+            {"framing", framing_str},
+            {"flush-interval-ms", json_value(static_cast<uint64_t>(config.flush_interval_ms))},
+            {"datagram-size", json_value(static_cast<uint64_t>(config.datagram_size))},
         };
+        if (config.endpoints.size() > 1) {
+            json_array endpoints;
+            for (const auto &endpoint: config.endpoints) {
+                endpoints.push_back(json_value{{"host", endpoint.host},
+                                               {"port", json_value(static_cast<uint64_t>(endpoint.port))}});
+            }
+            j["endpoints"] = json_value(std::move(endpoints));
+        }
+        std::string balance_str;
+        to_string(config.balance, balance_str);
+        j["balance"] = json_value(balance_str);
+        if (!config.spill_file.empty()) {
+            j["spill-file"] = json_value(config.spill_file);
+            j["spill-size"] = json_value(static_cast<uint64_t>(config.spill_size));
+            j["replay-rate"] = json_value(static_cast<uint64_t>(config.replay_rate));
+        }
     }
 
     void from_json(const json_value &j, socket_appender &config) {
-        j.at("host").get_to(config.host);
-        config.port = j.at("port").get<unsigned short>();
+        // Either "host" and "port", or "endpoints", a list of them
+        config.endpoints.clear();
+        if (j.contains("endpoints")) {
+            for (const auto &item: j.at("endpoints").get<json_array>()) {
+                socket_endpoint endpoint;
+                item.at("host").get_to(endpoint.host);
+                endpoint.port = item.at("port").get<unsigned short>();
+                config.endpoints.push_back(endpoint);
+            }
+            if (config.endpoints.empty()) {
+                throw invalid_config_exception("'socket.endpoints' must not be empty");
+            }
+            config.host = config.endpoints.front().host;
+            config.port = config.endpoints.front().port;
+            if (1 == config.endpoints.size()) {
+                config.endpoints.clear();
+            }
+        }
+        else {
+            j.at("host").get_to(config.host);
+            config.port = j.at("port").get<unsigned short>();
+        }
+        config.balance = balance_policy::ROUND_ROBIN;
+        if (j.contains("balance")) {
+            from_string(j.at("balance").get<std::string>(), config.balance);
+        }
         std::string proto_str;
         j.at("protocol").get_to(proto_str);
         proto_str = common::to_upper(proto_str);
@@ -61,5 +342,55 @@ namespace log4cpp::config {
         j.at("prefer-stack").get_to(prefer_str);
         // Convert to lowercase for comparison
         from_string(prefer_str, config.prefer);
+        config.send_buffer_size = SOCKET_SEND_BUFFER_SIZE_DEFAULT;
+        if (j.contains("send-buffer-size")) {
+            config.send_buffer_size = parse_size(j.at("send-buffer-size"), "socket.send-buffer-size");
+            if (config.send_buffer_size < LOG_LINE_MAX) {
+                throw invalid_config_exception("'socket.send-buffer-size' must be at least " +
+                                               std::to_string(LOG_LINE_MAX));
+            }
+        }
+        config.frame = framing::NONE;
+        if (j.contains("framing")) {
+            from_string(j.at("framing").get<std::string>(), config.frame);
+        }
+        config.flush_interval_ms = 0;
+        if (j.contains("flush-interval-ms")) {
+            const int64_t interval = j.at("flush-interval-ms").get<int64_t>();
+            if (interval < 0 || interval > UINT_MAX) {
+                throw invalid_config_exception("'socket.flush-interval-ms' must be between 0 and " +
+                                               std::to_string(UINT_MAX));
+            }
+            config.flush_interval_ms = static_cast<unsigned int>(interval);
+        }
+        config.datagram_size = 0;
+        if (j.contains("datagram-size")) {
+            config.datagram_size = parse_size(j.at("datagram-size"), "socket.datagram-size");
+            if (config.datagram_size > SOCKET_DATAGRAM_SIZE_MAX) {
+                throw invalid_config_exception("'socket.datagram-size' must be at most " +
+                                               std::to_string(SOCKET_DATAGRAM_SIZE_MAX));
+            }
+        }
+        config.spill_file.clear();
+        if (j.contains("spill-file")) {
+            j.at("spill-file").get_to(config.spill_file);
+#ifdef _WIN32
+            throw invalid_config_exception("'socket.spill-file' is not supported on Windows");
+#endif
+        }
+        config.spill_size = SOCKET_SPILL_SIZE_DEFAULT;
+        if (j.contains("spill-size")) {
+            config.spill_size = parse_size(j.at("spill-size"), "socket.spill-size");
+            if (config.spill_size < LOG_LINE_MAX) {
+                throw invalid_config_exception("'socket.spill-size' must be at least " + std::to_string(LOG_LINE_MAX));
+            }
+        }
+        config.replay_rate = SOCKET_REPLAY_RATE_DEFAULT;
+        if (j.contains("replay-rate")) {
+            config.replay_rate = parse_size(j.at("replay-rate"), "socket.replay-rate");
+            if (0 == config.replay_rate) {
+                throw invalid_config_exception("'socket.replay-rate' must not be 0");
+            }
+        }
     }
 } // namespace log4cpp::config
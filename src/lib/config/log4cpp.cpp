@@ -2,6 +2,9 @@
 #include <format>
 #endif
 
+#include <map>
+
+#include "common/log_utils.hpp"
 #include "config/appender.hpp"
 #include "config/log4cpp.hpp"
 #include "exception/config_exception.hpp"
@@ -12,7 +15,16 @@ namespace log4cpp::config {
     // =========================================================
 
     bool log_appender::empty() const {
-        return !(console.has_value() || file.has_value() || socket.has_value());
+        return !(console.has_value() || file.has_value() || socket.has_value()) && named_files.empty();
+    }
+
+    bool is_builtin_appender(const std::string &name) {
+        for (const auto &entry: APPENDER_TABLE) {
+            if (name == entry.name) {
+                return true;
+            }
+        }
+        return false;
     }
 
     std::vector<std::string> appender_flag_to_name(unsigned char flag) {
@@ -72,6 +84,12 @@ namespace log4cpp::config {
                     break;
             }
         }
+        for (const auto &[name, file_cfg]: config.named_files) {
+            json_value fj;
+            to_json(fj, file_cfg);
+            fj["type"] = json_value(std::string("file"));
+            j[name] = fj;
+        }
     }
 
     void from_json(const json_value &j, log_appender &config) {
@@ -102,6 +120,101 @@ namespace log4cpp::config {
                     break;
             }
         }
+        config.named_files.clear();
+        for (const auto &[name, value]: j.get<json_object>()) {
+            if (is_builtin_appender(name)) {
+                continue;
+            }
+            if (!value.is_object() || !value.contains("type")) {
+                throw invalid_config_exception("appender '" + name + "' has no 'type'");
+            }
+            const std::string type = value.at("type").get<std::string>();
+            if (type != "file") {
+                throw invalid_config_exception("appender '" + name + "' has type '" + type +
+                                               "', only 'file' appenders can be named");
+            }
+            file_appender fa;
+            from_json(value, fa);
+            config.named_files.emplace(name, fa);
+        }
+        // Two appenders writing one file would interleave their buffers and fight over rollover
+        std::map<std::string, std::string> paths;
+        if (config.file.has_value()) {
+            paths.emplace(config.file->file_path, "file");
+        }
+        for (const auto &[name, fa]: config.named_files) {
+            const auto [it, inserted] = paths.emplace(fa.file_path, name);
+            if (!inserted) {
+                // NOLINTNEXTLINE(performance-inefficient-string-concatenation)
+                throw invalid_config_exception("appenders '" + it->second + "' and '" + name +
+                                               "' write the same file '" + fa.file_path + "'");
+            }
+        }
+    }
+
+    // =========================================================
+    // async mode
+    // =========================================================
+
+    void to_json(json_value &j, const async_mode &config) {
+        std::string policy_str;
+        to_string(config.overflow_policy, policy_str);
+        std::string level_str;
+        to_string(config.overflow_level, level_str);
+        j = json_value{
+            {"queue-size", json_value(static_cast<uint64_t>(config.queue_size))},
+            {"overflow-policy", policy_str},
+            {"overflow-level", level_str},
+            {"deferred-format", json_value(config.deferred_format)},
+        };
+    }
+
+    void from_json(const json_value &j, async_mode &config) {
+        config.queue_size = ASYNC_QUEUE_SIZE_DEFAULT;
+        if (j.contains("queue-size")) {
+            const int64_t queue_size = j.at("queue-size").get<int64_t>();
+            if (queue_size <= 0) {
+                throw invalid_config_exception("'async.queue-size' must be greater than 0");
+            }
+            config.queue_size = static_cast<size_t>(queue_size);
+        }
+        config.overflow_policy = overflow_policy::BLOCK;
+        if (j.contains("overflow-policy")) {
+            from_string(j.at("overflow-policy").get<std::string>(), config.overflow_policy);
+        }
+        config.overflow_level = log_level::WARN;
+        if (j.contains("overflow-level")) {
+            from_string(j.at("overflow-level").get<std::string>(), config.overflow_level);
+        }
+        config.deferred_format = false;
+        if (j.contains("deferred-format")) {
+            config.deferred_format = j.at("deferred-format").get<bool>();
+        }
+    }
+
+    // =========================================================
+    // clock
+    // =========================================================
+
+    void to_string(clock_source clock, std::string &str) {
+        for (const auto &entry: CLOCK_TABLE) {
+            if (entry.clock == clock) {
+                str = entry.name;
+                return;
+            }
+        }
+        str.clear();
+    }
+
+    void from_string(const std::string &str, clock_source &clock) {
+        const std::string name = common::to_lower(str);
+        for (const auto &entry: CLOCK_TABLE) {
+            if (name == entry.name) {
+                clock = entry.clock;
+                return;
+            }
+        }
+        throw invalid_config_exception("unknown clock: " + str);
     }
 
     // =========================================================
@@ -122,6 +235,19 @@ namespace log4cpp::config {
         if (config.log_pattern.has_value()) {
             j["log-pattern"] = json_value(config.log_pattern.value());
         }
+        if (config.async.has_value()) {
+            json_value aj;
+            to_json(aj, config.async.value());
+            j["async"] = aj;
+        }
+        if (config.max_line_size != MAX_LINE_SIZE_DEFAULT) {
+            j["max-line-size"] = json_value(static_cast<uint64_t>(config.max_line_size));
+        }
+        if (config.clock != clock_source::SYSTEM) {
+            std::string clock_str;
+            to_string(config.clock, clock_str);
+            j["clock"] = json_value(clock_str);
+        }
     }
 
     void from_json(const json_value &j, log4cpp &config) {
@@ -145,6 +271,28 @@ namespace log4cpp::config {
         else {
             config.log_pattern = std::nullopt;
         }
+        /* "async" is optional */
+        if (j.contains("async")) {
+            async_mode async;
+            from_json(j.at("async"), async);
+            config.async = async;
+        }
+        else {
+            config.async = std::nullopt;
+        }
+        /* "max-line-size" is optional */
+        config.max_line_size = MAX_LINE_SIZE_DEFAULT;
+        if (j.contains("max-line-size")) {
+            config.max_line_size = parse_size(j.at("max-line-size"), "max-line-size");
+            if (config.max_line_size < LOG_LINE_MAX) {
+                throw invalid_config_exception("'max-line-size' must be at least " + std::to_string(LOG_LINE_MAX));
+            }
+        }
+        /* "clock" is optional */
+        config.clock = clock_source::SYSTEM;
+        if (j.contains("clock")) {
+            from_string(j.at("clock").get<std::string>(), config.clock);
+        }
         from_json(j.at("appenders"), config.appenders);
 
         // "appenders" must define at least one appender
@@ -174,12 +322,18 @@ namespace log4cpp::config {
         if (root_logger.level.has_value()) {
             root_logger.level = log_level::WARN;
         }
-        if (root_logger.appender == 0) {
+        if (root_logger.appender == 0 && root_logger.named_appenders.empty()) {
             throw invalid_config_exception("root logger must define at least one appender");
         }
 
         // validate that each logger references only defined appenders
         for (const auto &[name, log]: config.loggers) {
+            for (const auto &ref: log.named_appenders) {
+                if (config.appenders.named_files.count(ref) == 0) {
+                    // NOLINTNEXTLINE(performance-inefficient-string-concatenation)
+                    throw invalid_config_exception("logger '" + name + "' references undefined appender '" + ref + "'");
+                }
+            }
             // Skip the undefined appender
             if (0 == log.appender) {
                 continue;
@@ -5,7 +5,30 @@
 #include "config/logger.hpp"
 #include "exception/config_exception.hpp"
 
+#include "common/log_utils.hpp"
+
 namespace log4cpp::config {
+    void to_string(overflow_policy policy, std::string &str) {
+        for (const auto &entry: OVERFLOW_POLICY_TABLE) {
+            if (entry.policy == policy) {
+                str = entry.name;
+                return;
+            }
+        }
+        str.clear();
+    }
+
+    void from_string(const std::string &str, overflow_policy &policy) {
+        const std::string name = common::to_lower(str);
+        for (const auto &entry: OVERFLOW_POLICY_TABLE) {
+            if (name == entry.name) {
+                policy = entry.policy;
+                return;
+            }
+        }
+        throw invalid_config_exception("unknown overflow policy: " + str);
+    }
+
     void to_json(json_value &j, const logger &config) {
         std::vector<std::string> appenders;
         for (const auto &entry: APPENDER_TABLE) {
@@ -13,6 +36,7 @@ namespace log4cpp::config {
                 appenders.emplace_back(entry.name);
             }
         }
+        appenders.insert(appenders.end(), config.named_appenders.begin(), config.named_appenders.end());
         json_array arr;
         for (const auto &a: appenders) {
             arr.emplace_back(json_value(a));
@@ -23,6 +47,16 @@ namespace log4cpp::config {
             to_string(config.level.value(), str);
             j["level"] = json_value(str);
         }
+        if (config.overflow_policy.has_value()) {
+            std::string str;
+            to_string(config.overflow_policy.value(), str);
+            j["overflow-policy"] = json_value(str);
+        }
+        if (config.overflow_level.has_value()) {
+            std::string str;
+            to_string(config.overflow_level.value(), str);
+            j["overflow-level"] = json_value(str);
+        }
     }
 
     void from_json(const json_value &j, logger &config) {
@@ -46,11 +80,36 @@ namespace log4cpp::config {
 
         // Appender is optional
         if (j.contains("appenders")) {
-            std::vector<std::string> appenders = j.at("appenders").get<std::vector<std::string>>();
-            config.appender = appender_name_to_flag(appenders);
+            std::vector<std::string> builtin;
+            config.named_appenders.clear();
+            for (auto &appender_name: j.at("appenders").get<std::vector<std::string>>()) {
+                if (is_builtin_appender(appender_name)) {
+                    builtin.push_back(std::move(appender_name));
+                }
+                else {
+                    // Checked against the "appenders" section once the whole configuration is read
+                    config.named_appenders.push_back(std::move(appender_name));
+                }
+            }
+            config.appender = appender_name_to_flag(builtin);
         }
         else {
             config.appender = 0;
+            config.named_appenders.clear();
+        }
+
+        // Overflow policy and level are optional
+        config.overflow_policy = std::nullopt;
+        if (j.contains("overflow-policy")) {
+            overflow_policy policy;
+            from_string(j.at("overflow-policy").get<std::string>(), policy);
+            config.overflow_policy = policy;
+        }
+        config.overflow_level = std::nullopt;
+        if (j.contains("overflow-level")) {
+            log_level level;
+            from_string(j.at("overflow-level").get<std::string>(), level);
+            config.overflow_level = level;
         }
     }
 } // namespace log4cpp::config
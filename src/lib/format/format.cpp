@@ -0,0 +1,218 @@
+#include <algorithm>
+#include <charconv>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+#include <log4cpp/format.hpp>
+
+#include "common/line_writer.hpp"
+
+namespace log4cpp::format {
+    // Large enough for any double in fixed notation with FORMAT_PRECISION_MAX digits (DBL_MAX has 309 integer digits)
+    constexpr size_t NUMBER_BUF_LEN = 400;
+
+    // Writes prefix + body padded to the width of the spec. The prefix (sign, "0x") stays in front of zero padding.
+    void write_padded(common::line_writer &writer, const format_spec &spec, bool numeric, std::string_view prefix,
+                      std::string_view body) {
+        const size_t len = prefix.size() + body.size();
+        const size_t pad = spec.width > len ? spec.width - len : 0;
+        if (numeric && spec.zero_pad && 0 == spec.align) {
+            writer.append(prefix.data(), prefix.size());
+            writer.append('0', pad);
+            writer.append(body.data(), body.size());
+            return;
+        }
+        const char align = 0 != spec.align ? spec.align : (numeric ? '>' : '<');
+        if ('>' == align) {
+            writer.append(' ', pad);
+        }
+        writer.append(prefix.data(), prefix.size());
+        writer.append(body.data(), body.size());
+        if ('<' == align) {
+            writer.append(' ', pad);
+        }
+    }
+
+    unsigned long long abs_value(long long value) {
+        return value < 0 ? 0ULL - static_cast<unsigned long long>(value) : static_cast<unsigned long long>(value);
+    }
+
+    void write_integer(common::line_writer &writer, const format_spec &spec, bool negative,
+                       unsigned long long magnitude) {
+        int base = 10;
+        switch (spec.type) {
+            case 'x':
+            case 'X':
+                base = 16;
+                break;
+            case 'o':
+                base = 8;
+                break;
+            case 'b':
+                base = 2;
+                break;
+            default:
+                break;
+        }
+        // 64 binary digits
+        char digits[72];
+        const auto result = std::to_chars(digits, digits + sizeof(digits), magnitude, base);
+        const auto len = static_cast<size_t>(result.ptr - digits);
+        if ('X' == spec.type) {
+            for (size_t i = 0; i < len; ++i) {
+                if (digits[i] >= 'a' && digits[i] <= 'f') {
+                    digits[i] = static_cast<char>(digits[i] - 'a' + 'A');
+                }
+            }
+        }
+        write_padded(writer, spec, true, negative ? "-" : "", std::string_view(digits, len));
+    }
+
+    void write_double(common::line_writer &writer, const format_spec &spec, double value) {
+        char digits[NUMBER_BUF_LEN];
+        size_t len = 0;
+#if defined(__cpp_lib_to_chars)
+        std::to_chars_result result{};
+        if (0 == spec.type && spec.precision < 0) {
+            // Shortest representation that round-trips
+            result = std::to_chars(digits, digits + sizeof(digits), value);
+        }
+        else {
+            std::chars_format fmt = std::chars_format::general;
+            if ('f' == spec.type) {
+                fmt = std::chars_format::fixed;
+            }
+            else if ('e' == spec.type) {
+                fmt = std::chars_format::scientific;
+            }
+            const int precision = spec.precision < 0 ? 6 : spec.precision;
+            result = std::to_chars(digits, digits + sizeof(digits), value, fmt, precision);
+        }
+        if (result.ec != std::errc()) {
+            writer.append('?');
+            return;
+        }
+        len = static_cast<size_t>(result.ptr - digits);
+#else
+        // The standard library has no floating point to_chars, fall back to snprintf
+        const char conv = 0 == spec.type ? 'g' : spec.type;
+        const char printf_fmt[] = {'%', '.', '*', conv, '\0'};
+        const int precision = spec.precision >= 0 ? spec.precision : (0 == spec.type ? 17 : 6);
+        const int n = std::snprintf(digits, sizeof(digits), printf_fmt, precision, value);
+        if (n < 0) {
+            writer.append('?');
+            return;
+        }
+        len = std::min(static_cast<size_t>(n), sizeof(digits) - 1);
+#endif
+        const bool negative = len > 0 && '-' == digits[0];
+        const size_t skip = negative ? 1 : 0;
+        write_padded(writer, spec, true, negative ? "-" : "", std::string_view(digits + skip, len - skip));
+    }
+
+    void write_string(common::line_writer &writer, const format_spec &spec, std::string_view str) {
+        if (spec.precision >= 0 && str.size() > static_cast<size_t>(spec.precision)) {
+            str = str.substr(0, static_cast<size_t>(spec.precision));
+        }
+        write_padded(writer, spec, false, "", str);
+    }
+
+    void write_arg(common::line_writer &writer, const format_spec &spec, const format_arg &arg) {
+        switch (arg.type) {
+            case arg_type::BOOL:
+                if ('d' == spec.type) {
+                    write_integer(writer, spec, false, arg.value.i != 0 ? 1 : 0);
+                }
+                else {
+                    write_string(writer, spec, arg.value.i != 0 ? "true" : "false");
+                }
+                break;
+            case arg_type::CHAR:
+                if (0 == spec.type || 'c' == spec.type) {
+                    const char c = static_cast<char>(arg.value.i);
+                    write_string(writer, spec, std::string_view(&c, 1));
+                }
+                else {
+                    write_integer(writer, spec, arg.value.i < 0, abs_value(arg.value.i));
+                }
+                break;
+            case arg_type::INT:
+                write_integer(writer, spec, arg.value.i < 0, abs_value(arg.value.i));
+                break;
+            case arg_type::UINT:
+                write_integer(writer, spec, false, arg.value.u);
+                break;
+            case arg_type::DOUBLE:
+                write_double(writer, spec, arg.value.d);
+                break;
+            case arg_type::CSTRING:
+                if (nullptr == arg.value.s) {
+                    write_string(writer, spec, "(null)");
+                }
+                else if (spec.precision >= 0) {
+                    const size_t len = strnlen(arg.value.s, static_cast<size_t>(spec.precision));
+                    write_string(writer, spec, std::string_view(arg.value.s, len));
+                }
+                else {
+                    write_string(writer, spec, arg.value.s);
+                }
+                break;
+            case arg_type::STRING:
+                write_string(writer, spec, std::string_view(arg.value.s, arg.size));
+                break;
+            case arg_type::POINTER: {
+                char digits[24];
+                const auto result = std::to_chars(digits, digits + sizeof(digits),
+                                                  reinterpret_cast<uintptr_t>(arg.value.p), 16);
+                const auto len = static_cast<size_t>(result.ptr - digits);
+                write_padded(writer, spec, true, "0x", std::string_view(digits, len));
+                break;
+            }
+            default:
+                break;
+        }
+    }
+
+    void vformat_to(common::line_writer &writer, const format_args &args) {
+        const std::string_view fmt = args.fmt;
+        size_t index = 0;
+        size_t i = 0;
+        while (i < fmt.size() && !writer.full()) {
+            const char c = fmt[i];
+            if (('{' == c || '}' == c) && i + 1 < fmt.size() && fmt[i + 1] == c) {
+                writer.append(c);
+                i += 2;
+                continue;
+            }
+            if ('{' == c) {
+                const size_t close = fmt.find('}', i + 1);
+                if (close != std::string_view::npos && index < args.count) {
+                    const std::string_view field = fmt.substr(i + 1, close - i - 1);
+                    format_spec spec;
+                    if (field.empty() || (':' == field[0] && parse_spec(field.substr(1), spec))) {
+                        write_arg(writer, spec, args.args[index++]);
+                        i = close + 1;
+                        continue;
+                    }
+                }
+            }
+            // Copy the literal text up to the next brace
+            size_t next = fmt.find_first_of("{}", i + 1);
+            if (std::string_view::npos == next) {
+                next = fmt.size();
+            }
+            writer.append(fmt.data() + i, next - i);
+            i = next;
+        }
+    }
+
+    size_t vformat(char *buf, size_t len, const format_args &args) {
+        if (0 == len) {
+            return 0;
+        }
+        common::line_writer writer(buf, len);
+        vformat_to(writer, args);
+        return writer.finish();
+    }
+} // namespace log4cpp::format
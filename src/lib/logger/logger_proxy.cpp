@@ -4,147 +4,172 @@
 #include <log4cpp/log4cpp.hpp>
 #include <log4cpp/logger.hpp>
 
+#include "common/rcu.hpp"
+
 namespace log4cpp {
-    logger_proxy::logger_proxy(std::shared_ptr<logger> target_logger) : target_(std::move(target_logger)) {
-        if (!target_) {
+    logger_proxy::logger_proxy(std::shared_ptr<logger> target_logger) : owner_(std::move(target_logger)) {
+        if (!owner_) {
             throw std::invalid_argument("logger_proxy: target_ (delegated logger) must not be null");
         }
+        level_.store(owner_->get_level(), std::memory_order_relaxed);
+        target_.store(owner_.get(), std::memory_order_release);
     }
 
     [[nodiscard]] std::string logger_proxy::get_name() const {
-        std::shared_lock lock(mtx);
-        if (!target_) {
+        common::rcu::read_guard guard;
+        const logger *target = target_.load(std::memory_order_acquire);
+        if (nullptr == target) {
             return {};
         }
-        return target_->get_name();
+        return target->get_name();
     }
 
     void logger_proxy::set_name(const std::string &name) {
-        std::unique_lock lock(mtx);
-        if (!target_) {
+        std::lock_guard lock(mtx);
+        if (!owner_) {
             return;
         }
-        target_->set_name(name);
+        owner_->set_name(name);
     }
 
     [[nodiscard]] log_level logger_proxy::get_level() const {
-        std::shared_lock lock(mtx);
-        if (!target_) {
-            return {};
-        }
-        return target_->get_level();
+        return level_.load(std::memory_order_relaxed);
     }
 
     void logger_proxy::set_level(log_level level) {
-        std::unique_lock lock(mtx);
-        if (!target_) {
+        std::lock_guard lock(mtx);
+        if (!owner_) {
             return;
         }
-        target_->set_level(level);
+        owner_->set_level(level);
+        level_.store(level, std::memory_order_relaxed);
     }
 
     void logger_proxy::log(log_level _level, const char *__restrict fmt, va_list args) const {
-        std::shared_ptr<logger> logger_ptr;
-        {
-            std::shared_lock lock(mtx);
-            logger_ptr = target_;
+        if (_level > level_.load(std::memory_order_relaxed)) {
+            return;
         }
-        if (logger_ptr) {
-            logger_ptr->log(_level, fmt, args);
+        common::rcu::read_guard guard;
+        const logger *target = target_.load(std::memory_order_acquire);
+        if (nullptr != target) {
+            target->log(_level, fmt, args);
+        }
+    }
+
+    void logger_proxy::log(log_level _level, const format::format_args &args) const {
+        if (_level > level_.load(std::memory_order_relaxed)) {
+            return;
+        }
+        common::rcu::read_guard guard;
+        const logger *target = target_.load(std::memory_order_acquire);
+        if (nullptr != target) {
+            target->log(_level, args);
         }
     }
 
     void logger_proxy::fatal(const char *__restrict fmt, ...) const {
-        std::shared_ptr<logger> logger_ptr;
-        {
-            std::shared_lock lock(mtx);
-            logger_ptr = target_;
+        // A disabled level costs one relaxed load, no RCU section and no va_start
+        if (log_level::FATAL > level_.load(std::memory_order_relaxed)) {
+            return;
         }
-        if (logger_ptr) {
+        common::rcu::read_guard guard;
+        const logger *target = target_.load(std::memory_order_acquire);
+        if (nullptr != target) {
             va_list args;
             va_start(args, fmt);
-            logger_ptr->log(log_level::FATAL, fmt, args);
+            target->log(log_level::FATAL, fmt, args);
             va_end(args);
         }
     }
 
     void logger_proxy::error(const char *__restrict fmt, ...) const {
-        std::shared_ptr<logger> logger_ptr;
-        {
-            std::shared_lock lock(mtx);
-            logger_ptr = target_;
+        // A disabled level costs one relaxed load, no RCU section and no va_start
+        if (log_level::ERROR > level_.load(std::memory_order_relaxed)) {
+            return;
         }
-        if (logger_ptr) {
+        common::rcu::read_guard guard;
+        const logger *target = target_.load(std::memory_order_acquire);
+        if (nullptr != target) {
             va_list args;
             va_start(args, fmt);
-            logger_ptr->log(log_level::ERROR, fmt, args);
+            target->log(log_level::ERROR, fmt, args);
             va_end(args);
         }
     }
 
     void logger_proxy::warn(const char *__restrict fmt, ...) const {
-        std::shared_ptr<logger> logger_ptr;
-        {
-            std::shared_lock lock(mtx);
-            logger_ptr = target_;
+        // A disabled level costs one relaxed load, no RCU section and no va_start
+        if (log_level::WARN > level_.load(std::memory_order_relaxed)) {
+            return;
         }
-        if (logger_ptr) {
+        common::rcu::read_guard guard;
+        const logger *target = target_.load(std::memory_order_acquire);
+        if (nullptr != target) {
             va_list args;
             va_start(args, fmt);
-            logger_ptr->log(log_level::WARN, fmt, args);
+            target->log(log_level::WARN, fmt, args);
             va_end(args);
         }
     }
 
     void logger_proxy::info(const char *__restrict fmt, ...) const {
-        std::shared_ptr<logger> logger_ptr;
-        {
-            std::shared_lock lock(mtx);
-            logger_ptr = target_;
+        // A disabled level costs one relaxed load, no RCU section and no va_start
+        if (log_level::INFO > level_.load(std::memory_order_relaxed)) {
+            return;
         }
-        if (logger_ptr) {
+        common::rcu::read_guard guard;
+        const logger *target = target_.load(std::memory_order_acquire);
+        if (nullptr != target) {
             va_list args;
             va_start(args, fmt);
-            logger_ptr->log(log_level::INFO, fmt, args);
+            target->log(log_level::INFO, fmt, args);
             va_end(args);
         }
     }
 
     void logger_proxy::debug(const char *__restrict fmt, ...) const {
-        std::shared_ptr<logger> logger_ptr;
-        {
-            std::shared_lock lock(mtx);
-            logger_ptr = target_;
+        // A disabled level costs one relaxed load, no RCU section and no va_start
+        if (log_level::DEBUG > level_.load(std::memory_order_relaxed)) {
+            return;
         }
-        if (logger_ptr) {
+        common::rcu::read_guard guard;
+        const logger *target = target_.load(std::memory_order_acquire);
+        if (nullptr != target) {
             va_list args;
             va_start(args, fmt);
-            logger_ptr->log(log_level::DEBUG, fmt, args);
+            target->log(log_level::DEBUG, fmt, args);
             va_end(args);
         }
     }
 
     void logger_proxy::trace(const char *__restrict fmt, ...) const {
-        std::shared_ptr<logger> logger_ptr;
-        {
-            std::shared_lock lock(mtx);
-            logger_ptr = target_;
+        // A disabled level costs one relaxed load, no RCU section and no va_start
+        if (log_level::TRACE > level_.load(std::memory_order_relaxed)) {
+            return;
         }
-        if (logger_ptr) {
+        common::rcu::read_guard guard;
+        const logger *target = target_.load(std::memory_order_acquire);
+        if (nullptr != target) {
             va_list args;
             va_start(args, fmt);
-            logger_ptr->log(log_level::TRACE, fmt, args);
+            target->log(log_level::TRACE, fmt, args);
             va_end(args);
         }
     }
 
     std::shared_ptr<logger> logger_proxy::get_target() {
-        std::shared_lock lock(mtx);
-        return target_;
+        std::lock_guard lock(mtx);
+        return owner_;
     }
 
     void logger_proxy::set_target(std::shared_ptr<logger> target) {
-        std::unique_lock lock(mtx);
-        target_ = std::move(target);
+        std::lock_guard lock(mtx);
+        if (target) {
+            level_.store(target->get_level(), std::memory_order_relaxed);
+        }
+        target_.store(target.get(), std::memory_order_seq_cst);
+        std::swap(owner_, target);
+        // Calls that loaded the old pointer may still be running, release it only after they have returned
+        common::rcu::synchronize();
     }
 } // namespace log4cpp
@@ -1,6 +1,9 @@
+#include <algorithm>
 #include <cstdarg>
 
 #include "appender/log_appender.hpp"
+#include "async/async_dispatcher.hpp"
+#include "common/line_writer.hpp"
 #include "logger/real_logger.hpp"
 #include "pattern/log_pattern.hpp"
 
@@ -9,29 +12,144 @@ namespace log4cpp {
         this->level_ = log_level::WARN;
     }
 
+    uint32_t logger_key_of(const std::string &name) {
+        return static_cast<uint32_t>(std::hash<std::string>{}(name));
+    }
+
     real_logger::real_logger(const std::string &log_name, log_level _level) {
         this->name_ = log_name;
+        this->logger_key_ = logger_key_of(log_name);
         this->level_ = _level;
     }
 
     real_logger::real_logger(const std::string &log_name, log_level _level, const std::string &pattern) :
-        name_(log_name), level_(_level), pattern_(pattern) {
+        name_(log_name), logger_key_(logger_key_of(log_name)), level_(_level), pattern_(pattern) {
     }
 
     void real_logger::add_appender(const std::shared_ptr<appender::log_appender> &appender) {
         std::unique_lock lock(appenders_mtx);
-        this->appenders.insert(appender);
+        auto new_appenders =
+            this->appenders != nullptr ? std::make_shared<async::appender_list>(*this->appenders)
+                                       : std::make_shared<async::appender_list>();
+        if (std::find(new_appenders->begin(), new_appenders->end(), appender) == new_appenders->end()) {
+            new_appenders->push_back(appender);
+        }
+        this->appenders = std::move(new_appenders);
+    }
+
+    void real_logger::set_name(const std::string &name) {
+        this->name_ = name;
+        this->logger_key_ = logger_key_of(name);
+        if (nullptr != this->deferred_) {
+            this->deferred_ =
+                std::make_shared<async::deferred_source>(async::deferred_source{name_, pattern_, max_line_size_});
+        }
+    }
+
+    void real_logger::set_dispatcher(const std::shared_ptr<async::async_dispatcher> &dispatcher,
+                                     const async::overflow_control &overflow) {
+        this->dispatcher_ = dispatcher;
+        this->overflow_ = overflow;
+        this->deferred_.reset();
+        if (nullptr != dispatcher && dispatcher->get_config().deferred_format) {
+            this->deferred_ =
+                std::make_shared<async::deferred_source>(async::deferred_source{name_, pattern_, max_line_size_});
+        }
+    }
+
+    void real_logger::set_max_line_size(size_t max_line_size) {
+        this->max_line_size_ = max_line_size;
+        if (nullptr != this->deferred_) {
+            this->deferred_ =
+                std::make_shared<async::deferred_source>(async::deferred_source{name_, pattern_, max_line_size_});
+        }
+    }
+
+    void real_logger::set_clock(config::clock_source clock) {
+        this->pattern_.set_tsc_clock(config::clock_source::TSC == clock);
+        if (nullptr != this->deferred_) {
+            this->deferred_ =
+                std::make_shared<async::deferred_source>(async::deferred_source{name_, pattern_, max_line_size_});
+        }
+    }
+
+    template<typename Render, typename Defer>
+    void real_logger::write_line(log_level _level, Render &&render, Defer &&defer) const {
+        if (nullptr != this->dispatcher_) {
+            std::shared_ptr<const async::appender_list> targets;
+            {
+                std::shared_lock lock(appenders_mtx);
+                targets = this->appenders;
+            }
+            if (nullptr == targets || targets->empty()) {
+                return;
+            }
+            // Format straight into the queue, the backend thread does the write
+            const auto result =
+                this->dispatcher_->submit_record(_level, this->overflow_, targets, [&](async::async_record &record) {
+                    record.logger_key = this->logger_key_;
+                    if (defer(record)) {
+                        return;
+                    }
+                    common::line_writer writer(record.text, sizeof(record.text));
+                    record.len = render(writer);
+                    if (writer.truncated() && this->max_line_size_ >= sizeof(record.text)) {
+                        // Too long for the cell, render it again into a pooled buffer that the record takes along
+                        record.large = this->dispatcher_->take_large_buffer();
+                        common::line_writer large_writer(record.large, this->max_line_size_);
+                        record.len = render(large_writer);
+                    }
+                });
+            if (result != async::submit_result::REJECTED) {
+                return;
+            }
+        }
+        // The thread's own buffer, grown for a long line up to max_line_size_
+        common::thread_line_buffer buffer(LOG_LINE_MAX);
+        common::line_writer writer(buffer.get(), this->max_line_size_);
+        const size_t used_len = render(writer);
+        const char *line = buffer.get().data();
+        std::shared_lock lock(appenders_mtx);
+        if (nullptr == this->appenders) {
+            return;
+        }
+        for (auto &l: *this->appenders) {
+            l->log_keyed(this->logger_key_, line, used_len);
+            // Errors reach the file right away, a crash must not lose the records that explain it
+            if (_level <= log_level::ERROR) {
+                l->flush();
+            }
+            if (l->sync_due(_level)) {
+                l->sync();
+            }
+        }
     }
 
     void real_logger::log(log_level _level, const char *fmt, va_list args) const {
         if (this->level_ >= _level) {
-            char buffer[LOG_LINE_MAX];
-            buffer[0] = '\0';
-            const size_t used_len = pattern_.format(buffer, sizeof(buffer), this->name_.c_str(), _level, fmt, args);
-            std::shared_lock lock(appenders_mtx);
-            for (auto &l: this->appenders) {
-                l->log(buffer, used_len);
-            }
+            write_line(
+                _level,
+                [&](common::line_writer &writer) {
+                    return pattern_.format(writer, this->name_.c_str(), _level, fmt, args);
+                },
+                [](async::async_record &) { return false; });
+        }
+    }
+
+    void real_logger::log(log_level _level, const format::format_args &args) const {
+        if (this->level_ >= _level) {
+            write_line(
+                _level,
+                [&](common::line_writer &writer) { return pattern_.format(writer, this->name_.c_str(), _level, args); },
+                [&](async::async_record &record) {
+                    // Deferred formatting: queue the raw arguments, the backend thread formats the line
+                    if (nullptr == this->deferred_ || !record.store_args(args)) {
+                        return false;
+                    }
+                    record.source = this->deferred_;
+                    this->deferred_->pattern.capture_origin(record.origin);
+                    return true;
+                });
         }
     }
 
@@ -90,14 +208,18 @@ namespace log4cpp {
     }
 
     real_logger::real_logger(const real_logger &other) :
-        name_(other.name_), level_(other.level_), pattern_(other.pattern_) {
+        name_(other.name_), logger_key_(other.logger_key_), level_(other.level_), pattern_(other.pattern_),
+        dispatcher_(other.dispatcher_), overflow_(other.overflow_), deferred_(other.deferred_),
+        max_line_size_(other.max_line_size_) {
         std::shared_lock lock(other.appenders_mtx);
         this->appenders = other.appenders;
     }
 
     real_logger::real_logger(real_logger &&other) noexcept :
-        name_(std::move(other.name_)), level_(other.level_), appenders(std::move(other.appenders)),
-        pattern_(std::move(other.pattern_)) {
+        name_(std::move(other.name_)), logger_key_(other.logger_key_), level_(other.level_),
+        appenders(std::move(other.appenders)), pattern_(std::move(other.pattern_)),
+        dispatcher_(std::move(other.dispatcher_)), overflow_(other.overflow_), deferred_(std::move(other.deferred_)),
+        max_line_size_(other.max_line_size_) {
     }
 
     real_logger &real_logger::operator=(const real_logger &other) {
@@ -106,9 +228,14 @@ namespace log4cpp {
             real_logger temp(other);
             std::scoped_lock lock(appenders_mtx, temp.appenders_mtx);
             std::swap(name_, temp.name_);
+            std::swap(logger_key_, temp.logger_key_);
             std::swap(level_, temp.level_);
             std::swap(appenders, temp.appenders);
             std::swap(pattern_, temp.pattern_);
+            std::swap(dispatcher_, temp.dispatcher_);
+            std::swap(overflow_, temp.overflow_);
+            std::swap(deferred_, temp.deferred_);
+            std::swap(max_line_size_, temp.max_line_size_);
         }
         return *this;
     }
@@ -117,9 +244,14 @@ namespace log4cpp {
         if (this != &other) {
             std::unique_lock lock(appenders_mtx);
             this->name_ = std::move(other.name_);
+            this->logger_key_ = other.logger_key_;
             this->level_ = other.level_;
             this->appenders = std::move(other.appenders);
             this->pattern_ = std::move(other.pattern_);
+            this->dispatcher_ = std::move(other.dispatcher_);
+            this->overflow_ = other.overflow_;
+            this->deferred_ = std::move(other.deferred_);
+            this->max_line_size_ = other.max_line_size_;
         }
         return *this;
     }
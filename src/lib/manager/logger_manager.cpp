@@ -2,6 +2,7 @@
 #include <cstring>
 #include <filesystem>
 #include <fstream>
+#include <set>
 #include <utility>
 
 #ifndef _WIN32
@@ -15,7 +16,9 @@
 #include <log4cpp/logger.hpp>
 #include <logger/real_logger.hpp>
 
+#include "appender/balanced_socket_appender.hpp"
 #include "appender/console_appender.hpp"
+#include "async/async_dispatcher.hpp"
 #include "config/log4cpp.hpp"
 #include "pattern/log_pattern.hpp"
 
@@ -24,9 +27,12 @@
 #endif
 
 #include <appender/file_appender.hpp>
+#include <appender/mmap_file_appender.hpp>
 #include <appender/socket_appender.hpp>
 
 constexpr const char *DEFAULT_CONFIG_FILE_PATH = "./log4cpp.json";
+// The key of the unnamed file appender in logger_manager::file_appenders
+constexpr const char *FILE_APPENDER_NAME = "file";
 
 namespace log4cpp {
 
@@ -131,8 +137,8 @@ namespace log4cpp {
 #endif
         config_file_path = DEFAULT_CONFIG_FILE_PATH;
         console_appender_ptr = nullptr;
-        file_appender_ptr = nullptr;
         socket_appender_ptr = nullptr;
+        async_dispatcher_ptr = nullptr;
     }
 
     /// @brief Destructor, responsible for cleaning up resources like closing the eventfd and joining the event loop
@@ -152,6 +158,14 @@ namespace log4cpp {
             close(evt_fd);
         }
 #endif
+        // Write out queued records, loggers that outlive the manager fall back to synchronous logging
+        if (async_dispatcher_ptr != nullptr) {
+            async_dispatcher_ptr->shutdown();
+        }
+        // Loggers that outlive the manager may keep the file appenders, and their buffers, alive until after exit
+        for (const auto &[name, entry]: file_appenders) {
+            entry.appender->flush();
+        }
     }
 
     /**
@@ -191,7 +205,8 @@ namespace log4cpp {
 #else
         this->config->appenders.console = config::console_appender{"stdout"};
         const config::logger fallback_logger{FALLBACK_LOGGER_NAME, log_level::WARN,
-                                             static_cast<unsigned char>(config::APPENDER_TYPE::CONSOLE)};
+                                             static_cast<unsigned char>(config::APPENDER_TYPE::CONSOLE), std::nullopt,
+                                             std::nullopt, {}};
 #endif
         this->config->loggers.emplace(fallback_logger.name, fallback_logger);
     }
@@ -294,7 +309,10 @@ namespace log4cpp {
             if (old_cfg == *this->config) {
                 return;
             }
-            if (old_cfg.appenders != this->config->appenders) {
+            // Switching between sync and async (or resizing the queue, the line size or the clock) rebuilds every
+            // logger, like an appender change
+            if (old_cfg.appenders != this->config->appenders || old_cfg.async != this->config->async ||
+                old_cfg.max_line_size != this->config->max_line_size || old_cfg.clock != this->config->clock) {
                 appenders_changed = true;
             }
         }
@@ -385,10 +403,10 @@ namespace log4cpp {
                 if (appender_chg || cfg_chged) {
                     std::shared_ptr<logger> new_logger = nullptr;
                     if (new_log_cfg.find(logger_name) != new_log_cfg.end()) {
-                        new_logger = build_logger(new_log_cfg.at(logger_name));
+                        new_logger = build_logger(new_log_cfg.at(logger_name), logger_name);
                     }
                     else {
-                        new_logger = build_logger(new_fallback_logger);
+                        new_logger = build_logger(new_fallback_logger, logger_name);
                     }
                     proxy->set_target(new_logger);
                 }
@@ -416,6 +434,38 @@ namespace log4cpp {
         return this->config.get();
     }
 
+    uint64_t logger_manager::get_dropped_records() const {
+        std::lock_guard lock(drop_counters_mtx);
+        uint64_t total = 0;
+        for (const auto &[name, counter]: drop_counters) {
+            total += counter->load(std::memory_order_relaxed);
+        }
+        return total;
+    }
+
+    uint64_t logger_manager::get_dropped_records(const std::string &name) const {
+        std::lock_guard lock(drop_counters_mtx);
+        const auto it = drop_counters.find(name);
+        return drop_counters.end() == it ? 0 : it->second->load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Gets the drop counter of a logger, creating it on first use.
+     *
+     * Counters are owned by the manager and never removed, so the real loggers (and their queued records)
+     * can keep a plain pointer and the count survives hot reloads.
+     * @param name The name of the logger.
+     * @return A pointer to the counter, valid for the lifetime of the manager.
+     */
+    std::atomic<uint64_t> *logger_manager::get_drop_counter(const std::string &name) const {
+        std::lock_guard lock(drop_counters_mtx);
+        auto &counter = drop_counters[name];
+        if (nullptr == counter) {
+            counter = std::make_unique<std::atomic<uint64_t>>(0);
+        }
+        return counter.get();
+    }
+
     /**
      * @brief Gets or creates a logger instance (lazy initialization).
      *
@@ -465,18 +515,16 @@ namespace log4cpp {
             if (!log_cfg.level.has_value()) {
                 log_cfg.level = fallback_log_cfg.level;
             }
-            if (0 == log_cfg.appender) {
+            if (0 == log_cfg.appender && log_cfg.named_appenders.empty()) {
                 log_cfg.appender = fallback_log_cfg.appender;
+                log_cfg.named_appenders = fallback_log_cfg.named_appenders;
             }
         }
         else {
             log_cfg = fallback_log_cfg;
         }
 
-        auto new_logger = build_logger(log_cfg);
-
-        // Set the unique name for the new logger.
-        new_logger->set_name(name);
+        auto new_logger = build_logger(log_cfg, name);
 
         // Wrap the new logger in a proxy object
         const auto proxy = std::shared_ptr<logger_proxy>(new logger_proxy(new_logger), logger_deleter{name});
@@ -503,16 +551,18 @@ namespace log4cpp {
     void logger_manager::build_appender() {
         // Determine which appenders are actually required by iterating through all loggers.
         unsigned char required_appenders_mask = 0;
+        std::set<std::string> required_named;
         if (config && !config->loggers.empty()) {
             for (const auto &[name, log]: config->loggers) {
                 required_appenders_mask |= log.appender;
+                required_named.insert(log.named_appenders.begin(), log.named_appenders.end());
             }
         }
 
         const config::log_appender &appender_cfg = config->appenders;
         std::shared_ptr<appender::log_appender> new_console_appender = nullptr;
-        std::shared_ptr<appender::log_appender> new_file_appender = nullptr;
         std::shared_ptr<appender::log_appender> new_socket_appender = nullptr;
+        std::unordered_map<std::string, file_appender_entry> new_file_appenders;
 
         // Lazily create appenders only if they are defined AND required by a logger.
         if (((required_appenders_mask & static_cast<unsigned char>(config::APPENDER_TYPE::CONSOLE)) != 0)
@@ -521,35 +571,107 @@ namespace log4cpp {
         }
         if (((required_appenders_mask & static_cast<unsigned char>(config::APPENDER_TYPE::FILE)) != 0)
             && appender_cfg.file.has_value()) {
-            new_file_appender = std::make_shared<appender::file_appender>(appender_cfg.file.value());
+            new_file_appenders.emplace(FILE_APPENDER_NAME, build_file_appender(appender_cfg.file.value()));
+        }
+        for (const auto &[name, file_cfg]: appender_cfg.named_files) {
+            if (required_named.count(name) != 0) {
+                new_file_appenders.emplace(name, build_file_appender(file_cfg));
+            }
         }
         if (((required_appenders_mask & static_cast<unsigned char>(config::APPENDER_TYPE::SOCKET)) != 0)
             && appender_cfg.socket.has_value()) {
-            new_socket_appender = std::make_shared<appender::socket_appender>(appender_cfg.socket.value());
+            const config::socket_appender &socket_cfg = appender_cfg.socket.value();
+            if (socket_cfg.endpoints.size() > 1) {
+                new_socket_appender = std::make_shared<appender::balanced_socket_appender>(socket_cfg);
+            }
+            else {
+                new_socket_appender = std::make_shared<appender::socket_appender>(socket_cfg);
+            }
         }
 
-        std::unique_lock lock(appender_rw_lock);
-        this->console_appender_ptr = new_console_appender;
-        this->file_appender_ptr = new_file_appender;
-        this->socket_appender_ptr = new_socket_appender;
+        std::shared_ptr<async::async_dispatcher> old_dispatcher = nullptr;
+        {
+            std::unique_lock lock(appender_rw_lock);
+            this->console_appender_ptr = new_console_appender;
+            this->file_appenders = std::move(new_file_appenders);
+            this->socket_appender_ptr = new_socket_appender;
+            // Keep the running dispatcher unless the async settings changed
+            if (config->async.has_value()) {
+                if (nullptr == this->async_dispatcher_ptr
+                    || this->async_dispatcher_ptr->get_config() != config->async.value()) {
+                    old_dispatcher = this->async_dispatcher_ptr;
+                    this->async_dispatcher_ptr = std::make_shared<async::async_dispatcher>(config->async.value());
+                }
+            }
+            else {
+                old_dispatcher = this->async_dispatcher_ptr;
+                this->async_dispatcher_ptr = nullptr;
+            }
+        }
+        // Drain the replaced queue, loggers still holding it write synchronously until they are rebuilt
+        if (old_dispatcher != nullptr) {
+            old_dispatcher->shutdown();
+        }
+    }
+
+    logger_manager::file_appender_entry logger_manager::build_file_appender(const config::file_appender &cfg) const {
+        {
+            // Two appenders must not write the same file, an mmap one truncates it on close
+            std::shared_lock lock(appender_rw_lock);
+            for (const auto &[name, entry]: this->file_appenders) {
+                if (*entry.cfg == cfg) {
+                    return entry;
+                }
+            }
+        }
+        file_appender_entry entry;
+        entry.cfg = std::make_shared<const config::file_appender>(cfg);
+#ifndef _WIN32
+        if (config::write_mode::MMAP == cfg.mode) {
+            entry.appender = std::make_shared<appender::mmap_file_appender>(cfg);
+            return entry;
+        }
+#endif
+        entry.appender = std::make_shared<appender::file_appender>(cfg);
+        return entry;
     }
 
     /**
      * @brief Builds a concrete real_logger instance based on the given configuration.
      * @param log_cfg The configuration for this logger.
+     * @param name The name of the logger, which may differ from `log_cfg.name` if it uses the "root" config.
      * @return A shared pointer to the newly created real_logger.
      */
-    std::shared_ptr<logger> logger_manager::build_logger(const config::logger &log_cfg) const {
+    std::shared_ptr<logger> logger_manager::build_logger(const config::logger &log_cfg,
+                                                         const std::string &name) const {
         std::shared_ptr<appender::log_appender> temp_appenders[3];
 
         std::shared_lock appender_lock(appender_rw_lock);
         temp_appenders[0] = this->console_appender_ptr;
-        temp_appenders[1] = this->file_appender_ptr;
+        const auto file_it = this->file_appenders.find(FILE_APPENDER_NAME);
+        temp_appenders[1] = this->file_appenders.end() != file_it ? file_it->second.appender : nullptr;
         temp_appenders[2] = this->socket_appender_ptr;
 
         const std::string &pattern_str =
             config->log_pattern.has_value() ? config->log_pattern.value() : DEFAULT_LOG_PATTERN;
-        auto new_logger = std::make_shared<real_logger>(log_cfg.name, log_cfg.level.value(), pattern_str);
+        auto new_logger = std::make_shared<real_logger>(name, log_cfg.level.value(), pattern_str);
+        new_logger->set_max_line_size(config->max_line_size);
+        new_logger->set_clock(config->clock);
+        if (this->async_dispatcher_ptr != nullptr) {
+            // Overflow settings: the logger's own, then "root", then the "async" defaults
+            const config::async_mode &async_cfg = this->async_dispatcher_ptr->get_config();
+            const auto root_it = config->loggers.find(FALLBACK_LOGGER_NAME);
+            const config::logger *root_cfg = config->loggers.end() != root_it ? &root_it->second : nullptr;
+            async::overflow_control overflow;
+            overflow.policy = log_cfg.overflow_policy.value_or(
+                nullptr != root_cfg ? root_cfg->overflow_policy.value_or(async_cfg.overflow_policy)
+                                    : async_cfg.overflow_policy);
+            overflow.level = log_cfg.overflow_level.value_or(
+                nullptr != root_cfg ? root_cfg->overflow_level.value_or(async_cfg.overflow_level)
+                                    : async_cfg.overflow_level);
+            overflow.dropped = get_drop_counter(name);
+            new_logger->set_dispatcher(this->async_dispatcher_ptr, overflow);
+        }
         if ((log_cfg.appender & static_cast<unsigned char>(config::APPENDER_TYPE::CONSOLE)) != 0) {
             new_logger->add_appender(temp_appenders[0]);
         }
@@ -559,6 +681,12 @@ namespace log4cpp {
         if ((log_cfg.appender & static_cast<unsigned char>(config::APPENDER_TYPE::SOCKET)) != 0) {
             new_logger->add_appender(temp_appenders[2]);
         }
+        for (const auto &appender_name: log_cfg.named_appenders) {
+            const auto it = this->file_appenders.find(appender_name);
+            if (this->file_appenders.end() != it) {
+                new_logger->add_appender(it->second.appender);
+            }
+        }
         return new_logger;
     }
 } // namespace log4cpp
@@ -1,320 +1,518 @@
+#include <algorithm>
+#include <chrono>
 #include <cstdarg>
 #include <cstring>
 #include <log4cpp/log4cpp.hpp>
-#include <regex>
+#include <mutex>
 #include <string>
+#include <unordered_map>
 
+#include "common/line_writer.hpp"
 #include "common/log_utils.hpp"
+#include "common/tsc_clock.hpp"
 #include "pattern/log_pattern.hpp"
 
 namespace log4cpp::pattern {
-    log_pattern::log_pattern(const std::string &pattern) : _pattern(pattern) {
-    }
+    class placeholder_attr {
+    public:
+        const char *name;
+        segment_type type;
+    };
 
-    void log_pattern::set_pattern(const std::string &pattern) {
-        _pattern = pattern;
-    }
+    // Placeholders without a width, matched against the text between "${" and "}".
+    constexpr std::array<placeholder_attr, 18> PLACEHOLDER_TABLE{{
+        // A two-digit representation of a year, e.g., 99 or 03.
+        {"yy", segment_type::SHORT_YEAR},
+        // A full numeric representation of a year (at least 4 digits), with a '-' for BCE years. e.g., 1999, -0055.
+        {"yyyy", segment_type::FULL_YEAR},
+        // Numeric representation of a month, without leading zeros (1-12).
+        {"M", segment_type::SHORT_MONTH},
+        // Numeric representation of a month, with leading zeros (01-12).
+        {"MM", segment_type::FULL_MONTH},
+        // A short textual representation of a month (Jan-Dec).
+        {"MMM", segment_type::ABBR_MONTH},
+        // Day of the month without leading zeros (1-31).
+        {"d", segment_type::SHORT_DAY},
+        // Day of the month, 2 digits with leading zeros (01-31).
+        {"dd", segment_type::FULL_DAY},
+        // 12-hour format of an hour without leading zeros (0-12), with uppercase AM/PM.
+        {"h", segment_type::SHORT_12HOUR},
+        // 12-hour format of an hour with leading zeros (00-12), with uppercase AM/PM, e.g., 01 AM.
+        {"hh", segment_type::FULL_12HOUR},
+        // 24-hour format of an hour without leading zeros, e.g., 1, 23.
+        {"H", segment_type::SHORT_24HOUR},
+        // 24-hour format of an hour with leading zeros, e.g., 01, 23.
+        {"HH", segment_type::FULL_24HOUR},
+        // Minutes without leading zeros (1-59).
+        {"m", segment_type::SHORT_MINUTES},
+        // Minutes with leading zeros (01-59).
+        {"mm", segment_type::FULL_MINUTES},
+        // Seconds without leading zeros (1-59).
+        {"s", segment_type::SHORT_SECOND},
+        // Seconds with leading zeros (01-59).
+        {"ss", segment_type::FULL_SECOND},
+        // Milliseconds with leading zeros (001-999).
+        {"ms", segment_type::MILLISECOND},
+        // Log level, e.g., FATAL, ERROR, INFO.
+        {"L", segment_type::LOG_LEVEL},
+        // The log message body.
+        {"msg", segment_type::LOG_MESSAGE},
+    }};
 
-    // Regex to match the logger name pattern, e.g., ${8NM}. Default width is 8, max is 64.
-    const std::regex &get_logger_name_regex() {
-        static const std::regex regex(R"(\$\{(\d{1,2})?NM\})");
-        return regex;
-    }
-    // A two-digit representation of a year, e.g., 99 or 03.
-    const char *SHORT_YEAR = "${yy}";
-    // A full numeric representation of a year (at least 4 digits), with a '-' for BCE years. e.g., 1999, 2003, -0055.
-    const char *FULL_YEAR = "${yyyy}";
-    // Numeric representation of a month, without leading zeros (1-12).
-    const char *SHORT_MONTH = "${M}";
-    // Numeric representation of a month, with leading zeros (01-12).
-    const char *FULL_MONTH = "${MM}";
-    // A short textual representation of a month (Jan-Dec).
-    const char *ABBR_MONTH = "${MMM}";
-    // Day of the month without leading zeros (1-31).
-    const char *SHORT_DAY = "${d}";
-    // Day of the month, 2 digits with leading zeros (01-31).
-    const char *FULL_DAY = "${dd}";
-    // 12-hour format of an hour without leading zeros (0-12), with uppercase AM/PM.
-    const char *SHORT_12HOUR = "${h}";
-    // 12-hour format of an hour with leading zeros (00-12), with uppercase AM/PM, e.g., 01 AM.
-    const char *FULL_12HOUR = "${hh}";
-    // 24-hour format of an hour without leading zeros, e.g., 1, 23.
-    const char *SHORT_24HOUR = "${H}";
-    // 24-hour format of an hour with leading zeros, e.g., 01, 23.
-    const char *FULL_24HOUR = "${HH}";
-    // Minutes without leading zeros (1-59).
-    const char *SHORT_MINUTES = "${m}";
-    // Minutes with leading zeros (01-59).
-    const char *FULL_MINUTES = "${mm}";
-    // Seconds without leading zeros (1-59).
-    const char *SHORT_SECOND = "${s}";
-    // Seconds with leading zeros (01-59).
-    const char *FULL_SECOND = "${ss}";
-    // Milliseconds with leading zeros (001-999).
-    const char *MILLISECOND = "${ms}";
-    // Regex to match the thread name pattern, e.g., ${8TN}. If name is empty, use thread ID.
-    const std::regex &get_thread_name_regex() {
-        static const std::regex regex(R"(\$\{(\d{1,2})?TN\})");
-        return regex;
-    }
-    // Regex to match the thread ID pattern, e.g., ${8TH}.
-    const std::regex &get_thread_id_regex() {
-        static const std::regex regex(R"(\$\{(\d{1,2})?TH\})");
-        return regex;
-    }
-    // Log level, e.g., FATAL, ERROR, INFO.
-    const char *LOG_LEVEL = "${L}";
-    // The log message body.
-    const char *LOG_MESSAGE = "${msg}";
+    class width_placeholder_attr {
+    public:
+        const char *suffix;
+        segment_type type;
+        unsigned int default_width;
+        unsigned int max_width;
+    };
 
-    // Internal enum to determine hour format.
-    enum class HOUR_BASE : uint8_t { HOUR_NONE, HOUR_12, HOUR_24 };
+    // Placeholders with an optional 1-2 digit width prefix, e.g. ${8NM}, ${16TN}, ${8TH}.
+    constexpr std::array<width_placeholder_attr, 3> WIDTH_PLACEHOLDER_TABLE{{
+        // Logger name, left-aligned. Default width is 6, max is 64.
+        {"NM", segment_type::LOGGER_NAME, LOGGER_NAME_DEFAULT_LEN, LOGGER_NAME_MAX_LEN},
+        // Thread name, left-aligned. If the name is empty, "T" + zero-padded thread ID is used.
+        {"TN", segment_type::THREAD_NAME, THREAD_NAME_DEFAULT_LEN, THREAD_NAME_MAX_LEN},
+        // Thread ID, "T" + zero-padded thread ID.
+        {"TH", segment_type::THREAD_ID, THREAD_ID_WIDTH_MAX, THREAD_ID_WIDTH_MAX},
+    }};
 
-    // Formats date-related placeholders (year, month, day).
-    void format_day(char *buf, size_t len, const std::string &pattern, const tm &now_tm) {
-        common::log4c_scnprintf(buf, len, "%s", pattern.c_str());
-        if (pattern.find(SHORT_YEAR) != std::string::npos) {
-            char year[7];
-            common::log4c_scnprintf(year, sizeof(year), "%d", now_tm.tm_year % 100);
-            common::log4c_replace_in_place(buf, len, SHORT_YEAR, year);
-        }
-        if (pattern.find(FULL_YEAR) != std::string::npos) {
-            char year[7];
-            common::log4c_scnprintf(year, sizeof(year), "%04d", 1900 + now_tm.tm_year);
-            common::log4c_replace_in_place(buf, len, FULL_YEAR, year);
-        }
-        if (pattern.find(SHORT_MONTH) != std::string::npos) {
-            char month[3];
-            common::log4c_scnprintf(month, sizeof(month), "%d", now_tm.tm_mon + 1);
-            common::log4c_replace_in_place(buf, len, SHORT_MONTH, month);
-        }
-        if (pattern.find(FULL_MONTH) != std::string::npos) {
-            char month[3];
-            common::log4c_scnprintf(month, sizeof(month), "%02d", now_tm.tm_mon + 1);
-            common::log4c_replace_in_place(buf, len, FULL_MONTH, month);
-        }
-        if (pattern.find(ABBR_MONTH) != std::string::npos) {
-            common::log4c_replace_in_place(buf, len, ABBR_MONTH, MONTH_ABBR_NAME[now_tm.tm_mon]);
+    // Log level names, padded to the fixed width of 5, indexed by log_level.
+    constexpr std::array<const char *, 6> LEVEL_FIELD = {"FATAL", "ERROR", "WARN ", "INFO ", "DEBUG", "TRACE"};
+    constexpr size_t LEVEL_FIELD_WIDTH = 5;
+
+    /**
+     * @brief Resolve the text between "${" and "}" to a placeholder segment.
+     * @param name: The placeholder name, e.g. "yyyy" or "8TN"
+     * @param[out] segment: The resolved segment type and width
+     * @return false if the name is not a known placeholder
+     */
+    bool parse_placeholder(const std::string &name, pattern_segment &segment) {
+        for (const auto &entry: PLACEHOLDER_TABLE) {
+            if (name == entry.name) {
+                segment.type = entry.type;
+                return true;
+            }
         }
-        if (pattern.find(SHORT_DAY) != std::string::npos) {
-            char day[3];
-            common::log4c_scnprintf(day, sizeof(day), "%d", now_tm.tm_mday);
-            common::log4c_replace_in_place(buf, len, SHORT_DAY, day);
+        const size_t digits = name.find_first_not_of("0123456789");
+        if (std::string::npos == digits || digits > 2) {
+            return false;
         }
-        if (pattern.find(FULL_DAY) != std::string::npos) {
-            char day[3];
-            common::log4c_scnprintf(day, sizeof(day), "%02d", now_tm.tm_mday);
-            common::log4c_replace_in_place(buf, len, FULL_DAY, day);
+        for (const auto &entry: WIDTH_PLACEHOLDER_TABLE) {
+            if (name.compare(digits, std::string::npos, entry.suffix) == 0) {
+                unsigned int width = entry.default_width;
+                if (digits > 0) {
+                    width = static_cast<unsigned int>(std::stoul(name.substr(0, digits)));
+                }
+                segment.type = entry.type;
+                segment.width = std::min(width, entry.max_width);
+                return true;
+            }
         }
+        return false;
     }
 
-    // Formats time-related placeholders (hour, minute, second, millisecond, AM/PM).
-    void format_time(char *buf, size_t len, const std::string &pattern, const tm &now_tm, unsigned short ms) {
-        HOUR_BASE hour_base = HOUR_BASE::HOUR_NONE;
-        char time_str[16];
-        size_t tm_len = 0;
-        size_t pattern_start = std::string::npos, pattern_end = std::string::npos;
-        size_t pos = pattern.find(SHORT_12HOUR);
-        if (std::string::npos != pos) {
-            hour_base = HOUR_BASE::HOUR_12;
-            pattern_start = pos;
-            if (now_tm.tm_hour > 12) {
-                tm_len +=
-                    common::log4c_scnprintf(time_str + tm_len, sizeof(time_str) - tm_len, "%d", now_tm.tm_hour - 12);
+    bool is_time_segment(segment_type type) {
+        return type >= segment_type::SHORT_12HOUR && type <= segment_type::MILLISECOND;
+    }
+
+    bool is_datetime_segment(segment_type type) {
+        return type >= segment_type::SHORT_YEAR && type <= segment_type::MERIDIEM;
+    }
+
+    std::vector<pattern_segment> compile_pattern(const std::string &pattern) {
+        std::vector<pattern_segment> segments;
+        std::string literal;
+        auto flush_literal = [&segments, &literal] {
+            if (!literal.empty()) {
+                segments.push_back(pattern_segment{segment_type::LITERAL, 0, literal});
+                literal.clear();
             }
-            else {
-                tm_len += common::log4c_scnprintf(time_str + tm_len, sizeof(time_str) - tm_len, "%d", now_tm.tm_hour);
+        };
+
+        size_t pos = 0;
+        while (pos < pattern.size()) {
+            const size_t start = pattern.find("${", pos);
+            const size_t end = std::string::npos == start ? std::string::npos : pattern.find('}', start + 2);
+            if (std::string::npos == end) {
+                literal.append(pattern, pos, std::string::npos);
+                break;
             }
-            pattern_end = pos + strlen(SHORT_12HOUR);
-        }
-        pos = pattern.find(SHORT_24HOUR);
-        if (std::string::npos != pos) {
-            hour_base = HOUR_BASE::HOUR_24;
-            pattern_start = pos;
-            tm_len += common::log4c_scnprintf(time_str + tm_len, sizeof(time_str) - tm_len, "%d", now_tm.tm_hour);
-            pattern_end = pos + strlen(SHORT_24HOUR);
-        }
-        pos = pattern.find(FULL_12HOUR);
-        if (std::string::npos != pos) {
-            hour_base = HOUR_BASE::HOUR_12;
-            pattern_start = pos;
-            if (now_tm.tm_hour > 12) {
-                tm_len +=
-                    common::log4c_scnprintf(time_str + tm_len, sizeof(time_str) - tm_len, "%02d", now_tm.tm_hour - 12);
+            literal.append(pattern, pos, start - pos);
+            pattern_segment segment;
+            if (parse_placeholder(pattern.substr(start + 2, end - start - 2), segment)) {
+                flush_literal();
+                segment.text = pattern.substr(start, end - start + 1);
+                segments.push_back(std::move(segment));
+                pos = end + 1;
             }
             else {
-                tm_len += common::log4c_scnprintf(time_str + tm_len, sizeof(time_str) - tm_len, "%02d", now_tm.tm_hour);
+                // Not a placeholder, keep "${" and rescan the rest, e.g. "${a${msg}"
+                literal.append("${");
+                pos = start + 2;
             }
-            pattern_end = pos + strlen(FULL_12HOUR);
-        }
-        pos = pattern.find(FULL_24HOUR);
-        if (std::string::npos != pos) {
-            hour_base = HOUR_BASE::HOUR_24;
-            pattern_start = pos;
-            tm_len += common::log4c_scnprintf(time_str + tm_len, sizeof(time_str) - tm_len, "%02d", now_tm.tm_hour);
-            pattern_end = pos + strlen(FULL_24HOUR);
         }
-        pos = pattern.find(SHORT_MINUTES);
-        if (std::string::npos != pos) {
-            char delimiter = pattern[pos - 1];
-            pattern_start = std::string::npos == pattern_start ? pos : pattern_start;
-            tm_len +=
-                common::log4c_scnprintf(time_str + tm_len, sizeof(time_str) - tm_len, "%c%d", delimiter, now_tm.tm_min);
-            pattern_end = pos + strlen(SHORT_MINUTES);
-        }
-        pos = pattern.find(FULL_MINUTES);
-        if (std::string::npos != pos) {
-            char delimiter = pattern[pos - 1];
-            tm_len += common::log4c_scnprintf(time_str + tm_len, sizeof(time_str) - tm_len, "%c%02d", delimiter,
-                                              now_tm.tm_min);
-            pattern_end = pos + strlen(FULL_MINUTES);
-        }
-        pos = pattern.find(SHORT_SECOND);
-        if (std::string::npos != pos) {
-            char delimiter = pattern[pos - 1];
-            tm_len +=
-                common::log4c_scnprintf(time_str + tm_len, sizeof(time_str) - tm_len, "%c%d", delimiter, now_tm.tm_sec);
-            pattern_end = pos + strlen(SHORT_SECOND);
+        flush_literal();
+
+        // The AM/PM marker follows the whole time group, e.g. "${hh}:${mm}:${ss}" -> "01:02:03 PM"
+        const bool hour_12 = std::any_of(segments.begin(), segments.end(), [](const pattern_segment &s) {
+            return segment_type::SHORT_12HOUR == s.type || segment_type::FULL_12HOUR == s.type;
+        });
+        if (hour_12) {
+            const auto last_time = std::find_if(segments.rbegin(), segments.rend(),
+                                                [](const pattern_segment &s) { return is_time_segment(s.type); });
+            segments.insert(last_time.base(), pattern_segment{segment_type::MERIDIEM, 0, ""});
         }
-        pos = pattern.find(FULL_SECOND);
-        if (std::string::npos != pos) {
-            char delimiter = pattern[pos - 1];
-            tm_len += common::log4c_scnprintf(time_str + tm_len, sizeof(time_str) - tm_len, "%c%02d", delimiter,
-                                              now_tm.tm_sec);
-            pattern_end = pos + strlen(FULL_SECOND);
+        return segments;
+    }
+
+    // Executes a date/time segment. Other segments are written as they appear in the pattern.
+    void render_datetime_segment(common::line_writer &writer, const pattern_segment &segment, const tm &now_tm,
+                                 unsigned short ms) {
+        const int hour_12 = now_tm.tm_hour > 12 ? now_tm.tm_hour - 12 : now_tm.tm_hour;
+        switch (segment.type) {
+            case segment_type::SHORT_YEAR:
+                writer.append_int(now_tm.tm_year % 100, 2);
+                break;
+            case segment_type::FULL_YEAR:
+                writer.append_int(1900L + now_tm.tm_year, 4);
+                break;
+            case segment_type::SHORT_MONTH:
+                writer.append_int(now_tm.tm_mon + 1, 1);
+                break;
+            case segment_type::FULL_MONTH:
+                writer.append_int(now_tm.tm_mon + 1, 2);
+                break;
+            case segment_type::ABBR_MONTH:
+                writer.append(MONTH_ABBR_NAME[now_tm.tm_mon], 3);
+                break;
+            case segment_type::SHORT_DAY:
+                writer.append_int(now_tm.tm_mday, 1);
+                break;
+            case segment_type::FULL_DAY:
+                writer.append_int(now_tm.tm_mday, 2);
+                break;
+            case segment_type::SHORT_12HOUR:
+                writer.append_int(hour_12, 1);
+                break;
+            case segment_type::FULL_12HOUR:
+                writer.append_int(hour_12, 2);
+                break;
+            case segment_type::SHORT_24HOUR:
+                writer.append_int(now_tm.tm_hour, 1);
+                break;
+            case segment_type::FULL_24HOUR:
+                writer.append_int(now_tm.tm_hour, 2);
+                break;
+            case segment_type::SHORT_MINUTES:
+                writer.append_int(now_tm.tm_min, 1);
+                break;
+            case segment_type::FULL_MINUTES:
+                writer.append_int(now_tm.tm_min, 2);
+                break;
+            case segment_type::SHORT_SECOND:
+                writer.append_int(now_tm.tm_sec, 1);
+                break;
+            case segment_type::FULL_SECOND:
+                writer.append_int(now_tm.tm_sec, 2);
+                break;
+            case segment_type::MILLISECOND:
+                writer.append_uint(ms, 3);
+                break;
+            case segment_type::MERIDIEM:
+                writer.append(now_tm.tm_hour < 12 ? " AM" : " PM", 3);
+                break;
+            default:
+                writer.append(segment.text.data(), segment.text.size());
+                break;
         }
-        pos = pattern.find(MILLISECOND);
-        if (std::string::npos != pos) {
-            char delimiter = pattern[pos - 1];
-            tm_len += common::log4c_scnprintf(time_str + tm_len, sizeof(time_str) - tm_len, "%c%03d", delimiter, ms);
-            pattern_end = pos + strlen(MILLISECOND);
+    }
+
+    // Formats the date/time placeholders of `pattern` whose type lies in [first, last] into `buf`.
+    void format_datetime_range(char *buf, size_t len, const std::string &pattern, const tm &now_tm,
+                               unsigned short ms, segment_type first, segment_type last) {
+        if (0 == len) {
+            return;
         }
-        if (HOUR_BASE::HOUR_12 == hour_base) {
-            if (now_tm.tm_hour < 12) {
-                common::log4c_scnprintf(time_str + tm_len, sizeof(time_str) - tm_len, " AM");
+        common::line_writer writer(buf, len);
+        for (const auto &segment: compile_pattern(pattern)) {
+            if (segment.type >= first && segment.type <= last) {
+                render_datetime_segment(writer, segment, now_tm, ms);
             }
             else {
-                common::log4c_scnprintf(time_str + tm_len, sizeof(time_str) - tm_len, " PM");
+                writer.append(segment.text.data(), segment.text.size());
             }
         }
-        size_t placeholder_len = pattern_end - pattern_start;
-        char placeholder[32];
-        strncpy(placeholder, pattern.c_str() + pattern_start, placeholder_len);
-        placeholder[placeholder_len] = '\0';
-        common::log4c_replace_in_place(buf, len, placeholder, time_str);
+        writer.finish();
+    }
+
+    // Formats date-related placeholders (year, month, day).
+    void format_day(char *buf, size_t len, const std::string &pattern, const tm &now_tm) {
+        format_datetime_range(buf, len, pattern, now_tm, 0, segment_type::SHORT_YEAR, segment_type::FULL_DAY);
+    }
+
+    // Formats time-related placeholders (hour, minute, second, millisecond, AM/PM).
+    void format_time(char *buf, size_t len, const std::string &pattern, const tm &now_tm, unsigned short ms) {
+        format_datetime_range(buf, len, pattern, now_tm, ms, segment_type::SHORT_12HOUR, segment_type::MERIDIEM);
     }
 
     // Formats both date and time placeholders.
     void format_daytime(char *buf, size_t len, const std::string &pattern, const tm &now_tm, unsigned short ms) {
-        format_day(buf, len, pattern, now_tm);
-        format_time(buf, len, pattern, now_tm, ms);
+        format_datetime_range(buf, len, pattern, now_tm, ms, segment_type::SHORT_YEAR, segment_type::MERIDIEM);
     }
 
-    // Formats all parts of a log message according to the global `_pattern`.
-    void log_pattern::format_with_pattern(char *buf, size_t len, const char *name, log_level level,
-                                          const char *msg) const {
-        tm now_tm{};
-        unsigned short ms;
-        common::get_time_now(now_tm, ms);
-
-        format_daytime(buf, len, _pattern, now_tm, ms);
-
-        // replace ${\d+NM} with logger name
-        // Replace `${...NM}` with the logger name.
-        if (std::smatch match; std::regex_search(_pattern, match, get_logger_name_regex())) {
-            size_t width = LOGGER_NAME_DEFAULT_LEN;
-            if (match[1].matched) {
-                const std::string width_str = match[1].str();
-                width = std::stoul(width_str);
-            }
-            width = std::min<size_t>(LOGGER_NAME_MAX_LEN, width);
-            char logger_name[LOGGER_NAME_MAX_LEN];
-            common::log4c_scnprintf(logger_name, sizeof(logger_name), "%-*.*s", width, width, name);
+    constexpr size_t STAMP_CACHE_SIZE = 128;
 
-            const std::string full_match_str = match[0];
-            common::log4c_replace_in_place(buf, len, full_match_str.c_str(), logger_name);
-        }
+    /**
+     * @brief The date/time run of the last line this thread formatted, valid for one second.
+     *
+     * Within that second only the ${ms} digits differ from line to line, they are patched in on output.
+     */
+    struct stamp_cache {
+        // _stamp_id of the run the text belongs to, 0 if nothing is cached
+        unsigned long id{0};
+        std::time_t second{0};
+        size_t len{0};
+        // Offset of the ${ms} digits in text, npos if the run has none
+        size_t ms_offset{std::string::npos};
+        char text[STAMP_CACHE_SIZE]{};
+    };
+
+    thread_local stamp_cache tls_stamp_cache;
+
+    /**
+     * @brief Map the source text of a date/time run to a stable id.
+     *
+     * Loggers compile their own copy of the (usually identical) pattern, sharing the id lets them share the
+     * per-thread cache instead of evicting each other.
+     */
+    unsigned long stamp_run_id(const std::string &key) {
+        static std::mutex ids_mtx;
+        static std::unordered_map<std::string, unsigned long> ids;
+        std::lock_guard<std::mutex> lock(ids_mtx);
+        return ids.emplace(key, ids.size() + 1).first->second;
+    }
+
+    log_pattern::log_pattern(const std::string &pattern) {
+        set_pattern(pattern);
+    }
+
+    void log_pattern::set_pattern(const std::string &pattern) {
+        _pattern = pattern;
+        _segments = compile_pattern(pattern);
 
-        // Replace `${...TN}` with the thread name or ID.
-        if (std::smatch match; std::regex_search(_pattern, match, get_thread_name_regex())) {
-            size_t width = THREAD_NAME_DEFAULT_LEN;
-            if (match[1].matched) {
-                const std::string width_str = match[1].str();
-                width = std::stoul(width_str);
+        // Find the first run of date/time segments (with the literals between them), up to and including ${ms}
+        const auto first = std::find_if(_segments.begin(), _segments.end(),
+                                        [](const pattern_segment &s) { return is_datetime_segment(s.type); });
+        _stamp_begin = static_cast<size_t>(first - _segments.begin());
+        _stamp_end = _stamp_begin;
+        size_t run_end = _stamp_begin;
+        while (run_end < _segments.size() &&
+               (segment_type::LITERAL == _segments[run_end].type || is_datetime_segment(_segments[run_end].type))) {
+            const segment_type type = _segments[run_end++].type;
+            if (segment_type::LITERAL != type) {
+                _stamp_end = run_end;
             }
-            width = std::min<size_t>(THREAD_NAME_MAX_LEN, width);
-            char _name[THREAD_NAME_MAX_LEN];
-            const unsigned long tid = get_thread_name_id(_name, sizeof(_name));
-            char thread_name[THREAD_NAME_MAX_LEN];
-            if (_name[0] != '\0') {
-                common::log4c_scnprintf(thread_name, sizeof(thread_name), "%-*.*s", width, width, _name);
+            if (segment_type::MILLISECOND == type) {
+                break;
             }
-            else {
-                common::log4c_scnprintf(thread_name, sizeof(thread_name), "T%0*lu", width, tid);
+        }
+        _stamp_id = 0;
+        if (_stamp_begin < _stamp_end) {
+            std::string key;
+            for (size_t i = _stamp_begin; i < _stamp_end; ++i) {
+                // MERIDIEM has no source text, mark it so "${hh}" and "${hh} AM" do not share an id
+                key.append(segment_type::MERIDIEM == _segments[i].type ? "\x01" : _segments[i].text);
             }
-            const std::string full_match_str = match[0];
-            common::log4c_replace_in_place(buf, len, full_match_str.c_str(), thread_name);
+            _stamp_id = stamp_run_id(key);
+        }
+        _uses_thread = std::any_of(_segments.begin(), _segments.end(), [](const pattern_segment &s) {
+            return segment_type::THREAD_NAME == s.type || segment_type::THREAD_ID == s.type;
+        });
+    }
+
+    void log_pattern::set_tsc_clock(bool enable) {
+        _tsc_clock = enable && common::tsc_clock::calibrate();
+    }
+
+    void log_pattern::capture_origin(line_origin &origin) const {
+        // The TSC is converted by the thread that formats the line, the log call only reads the counter
+        origin.tsc = _tsc_clock ? common::tsc_clock::ticks() : 0;
+        if (0 == origin.tsc) {
+            origin.time = std::chrono::system_clock::now();
+        }
+        origin.thread_resolved = _uses_thread;
+        if (_uses_thread) {
+            origin.thread_id = get_thread_name_id(origin.thread_name, sizeof(origin.thread_name));
         }
+    }
 
-        // Replace `${...TH}` with the thread ID.
-        if (std::smatch match; std::regex_search(_pattern, match, get_thread_id_regex())) {
-            size_t width = THREAD_ID_WIDTH_MAX;
-            if (match[1].matched) {
-                const std::string width_str = match[1].str();
-                width = std::stoul(width_str);
+    // Executes the compiled `_segments` in one left-to-right pass.
+    template<typename Message>
+    size_t log_pattern::format_with_pattern(common::line_writer &writer, const char *name, log_level level,
+                                            const Message &message, const line_origin *origin) const {
+        std::chrono::system_clock::time_point now;
+        if (nullptr != origin) {
+            now = 0 != origin->tsc ? common::tsc_clock::to_time(origin->tsc) : origin->time;
+        }
+        else {
+            now = _tsc_clock ? common::tsc_clock::now() : std::chrono::system_clock::now();
+        }
+        const std::time_t now_sec = std::chrono::system_clock::to_time_t(now);
+        const auto ms = static_cast<unsigned short>(
+            std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch()).count() % 1000);
+        tm now_tm{};
+        bool tm_resolved = false;
+        auto resolve_tm = [&] {
+            if (!tm_resolved) {
+                common::get_local_time(now_sec, now_tm);
+                tm_resolved = true;
             }
-            width = std::min<size_t>(THREAD_ID_WIDTH_MAX, width);
-            char thread_name[THREAD_NAME_MAX_LEN];
-            const unsigned long tid = get_thread_name_id(thread_name, sizeof(thread_name));
-
-            char thread_id[THREAD_NAME_MAX_LEN + 1];
-            thread_id[0] = '\0';
-            common::log4c_scnprintf(thread_id, sizeof(thread_id), "T%0*lu", width, tid);
-            const std::string full_match_str = match[0];
-            common::log4c_replace_in_place(buf, len, full_match_str.c_str(), thread_id);
+        };
+
+        const char *thread_name = "";
+        unsigned long tid = 0;
+        bool thread_resolved = false;
+        if (nullptr != origin && origin->thread_resolved) {
+            thread_name = origin->thread_name;
+            tid = origin->thread_id;
+            thread_resolved = true;
         }
-        // replace ${L} with log level, log level fixed length is 5, align left, fill with space
-
-        // Replace `${L}` with the log level (fixed width, left-aligned).
-        if (_pattern.find(LOG_LEVEL) != std::string::npos) {
-            char log_level[16];
-            std::string level_str;
-            to_string(level, level_str);
-            common::log4c_scnprintf(log_level, sizeof(log_level), "%-5s", level_str.c_str());
-            common::log4c_replace_in_place(buf, len, LOG_LEVEL, log_level);
+
+        for (size_t i = 0; i < _segments.size(); ++i) {
+            const pattern_segment &segment = _segments[i];
+            if (i == _stamp_begin && _stamp_id != 0) {
+                stamp_cache &cache = tls_stamp_cache;
+                if (cache.id != _stamp_id || cache.second != now_sec) {
+                    resolve_tm();
+                    common::line_writer stamp_writer(cache.text, sizeof(cache.text));
+                    cache.ms_offset = std::string::npos;
+                    for (size_t j = _stamp_begin; j < _stamp_end; ++j) {
+                        if (segment_type::MILLISECOND == _segments[j].type) {
+                            cache.ms_offset = stamp_writer.size();
+                        }
+                        render_datetime_segment(stamp_writer, _segments[j], now_tm, 0);
+                    }
+                    // A run too long for the cache (huge literals) is rendered segment by segment instead
+                    const bool fits = !stamp_writer.full();
+                    cache.len = stamp_writer.finish();
+                    cache.second = now_sec;
+                    cache.id = fits ? _stamp_id : 0;
+                }
+                if (cache.id == _stamp_id) {
+                    if (std::string::npos == cache.ms_offset) {
+                        writer.append(cache.text, cache.len);
+                    }
+                    else {
+                        writer.append(cache.text, cache.ms_offset);
+                        writer.append_uint(ms, 3);
+                        writer.append(cache.text + cache.ms_offset + 3, cache.len - cache.ms_offset - 3);
+                    }
+                    i = _stamp_end - 1;
+                    continue;
+                }
+            }
+            switch (segment.type) {
+                case segment_type::LITERAL:
+                    writer.append(segment.text.data(), segment.text.size());
+                    break;
+                case segment_type::LOGGER_NAME:
+                    writer.append_field(name, segment.width);
+                    break;
+                case segment_type::THREAD_NAME:
+                case segment_type::THREAD_ID:
+                    if (!thread_resolved) {
+                        const common::thread_identity &identity = common::current_thread_identity();
+                        thread_name = identity.name;
+                        tid = identity.id;
+                        thread_resolved = true;
+                    }
+                    if (segment_type::THREAD_NAME == segment.type && thread_name[0] != '\0') {
+                        writer.append_field(thread_name, segment.width);
+                    }
+                    else {
+                        writer.append('T');
+                        writer.append_uint(tid, segment.width);
+                    }
+                    break;
+                case segment_type::LOG_LEVEL:
+                    writer.append(LEVEL_FIELD[static_cast<size_t>(level)], LEVEL_FIELD_WIDTH);
+                    break;
+                case segment_type::LOG_MESSAGE:
+                    message(writer);
+                    break;
+                default:
+                    resolve_tm();
+                    render_datetime_segment(writer, segment, now_tm, ms);
+                    break;
+            }
         }
+        return writer.finish_line();
+    }
 
-        // Replace `${msg}` with the final log message.
-        if (_pattern.find(LOG_MESSAGE) != std::string::npos) {
-            common::log4c_replace_in_place(buf, len, LOG_MESSAGE, msg);
+    /**
+     * @brief Format into buf with a bounded writer, the line is truncated to fit.
+     * @param format: Called as format(writer) -> size_t
+     */
+    template<typename Format>
+    size_t format_bounded(char *buf, size_t buf_len, const Format &format) {
+        if (buf_len < 2) {
+            if (1 == buf_len) {
+                buf[0] = '\0';
+            }
+            return 0;
         }
+        common::line_writer writer(buf, buf_len);
+        return format(writer);
+    }
+
+    size_t log_pattern::format(common::line_writer &writer, const char *name, log_level level, const char *fmt,
+                               va_list args) const {
+        return format_with_pattern(writer, name, level,
+                                   [&](common::line_writer &out) { out.append_vprintf(fmt, args); });
+    }
+
+    size_t log_pattern::format(common::line_writer &writer, const char *name, log_level level,
+                               const format::format_args &args) const {
+        return format_with_pattern(writer, name, level,
+                                   [&](common::line_writer &out) { format::vformat_to(out, args); });
+    }
+
+    size_t log_pattern::format(common::line_writer &writer, const char *name, log_level level,
+                               const line_origin &origin, const format::format_args &args) const {
+        return format_with_pattern(
+            writer, name, level, [&](common::line_writer &out) { format::vformat_to(out, args); }, &origin);
     }
 
     // Public formatting interface (va_list version).
     size_t log_pattern::format(char *buf, size_t buf_len, const char *name, log_level level, const char *fmt,
                                va_list args) const {
-        char message[LOG_LINE_MAX];
-        message[0] = '\0';
-        common::log4c_vscnprintf(message, sizeof(message), fmt, args);
-
-        format_with_pattern(buf, buf_len, name, level, message);
-        size_t used_len = strlen(buf);
-        used_len += common::log4c_scnprintf(buf + used_len, buf_len - used_len, "\n");
-        return used_len;
+        return format_bounded(buf, buf_len,
+                              [&](common::line_writer &writer) { return format(writer, name, level, fmt, args); });
     }
 
     // Public formatting interface (variadic version).
     size_t log_pattern::format(char *buf, size_t buf_len, const char *name, log_level level, const char *fmt,
                                ...) const {
-        char message[LOG_LINE_MAX];
-        message[0] = '\0';
         va_list args;
         va_start(args, fmt);
-        common::log4c_vscnprintf(message, sizeof(message), fmt, args);
+        const size_t used_len = format(buf, buf_len, name, level, fmt, args);
         va_end(args);
-        format_with_pattern(buf, buf_len, name, level, message);
-        size_t used_len = strlen(buf);
-        used_len += common::log4c_scnprintf(buf + used_len, buf_len - used_len, "\n");
         return used_len;
     }
+
+    // Public formatting interface (typed format API version).
+    size_t log_pattern::format(char *buf, size_t buf_len, const char *name, log_level level,
+                               const format::format_args &args) const {
+        return format_bounded(buf, buf_len,
+                              [&](common::line_writer &writer) { return format(writer, name, level, args); });
+    }
+
+    // Formatting interface for lines rendered away from the logging thread.
+    size_t log_pattern::format(char *buf, size_t buf_len, const char *name, log_level level,
+                               const line_origin &origin, const format::format_args &args) const {
+        return format_bounded(buf, buf_len, [&](common::line_writer &writer) {
+            return format(writer, name, level, origin, args);
+        });
+    }
 } // namespace log4cpp::pattern
@@ -0,0 +1,313 @@
+#include <atomic>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#ifndef _WIN32
+#include <ctime>
+#endif
+
+#include "log4cpp/log4cpp.hpp"
+
+#include "appender/log_appender.hpp"
+#include "async/async_dispatcher.hpp"
+#include "common/ring_buffer.hpp"
+#include "logger/real_logger.hpp"
+
+#include "../include/log4cpp_test.h"
+
+// Holds the backend thread in its first log() call until release(), so tests can fill the queue.
+class gated_appender: public log4cpp::appender::log_appender {
+public:
+    void log(const char *msg, size_t msg_len) override {
+        std::unique_lock lock(mtx);
+        lines.emplace_back(msg, msg_len);
+        entered = true;
+        cv.notify_all();
+        cv.wait(lock, [this] { return open; });
+    }
+
+    void wait_entered() {
+        std::unique_lock lock(mtx);
+        cv.wait(lock, [this] { return entered; });
+    }
+
+    void release() {
+        std::lock_guard lock(mtx);
+        open = true;
+        cv.notify_all();
+    }
+
+    std::mutex mtx;
+    std::condition_variable cv;
+    bool entered{false};
+    bool open{false};
+    std::vector<std::string> lines;
+};
+
+log4cpp::async::submit_result submit_line(log4cpp::async::async_dispatcher &dispatcher, log4cpp::log_level level,
+                                          const log4cpp::async::overflow_control &overflow,
+                                          const std::shared_ptr<const log4cpp::async::appender_list> &appenders,
+                                          const char *text) {
+    return dispatcher.submit(level, overflow, appenders, [text](char *buf, size_t len) {
+        return static_cast<size_t>(std::snprintf(buf, len, "%s", text));
+    });
+}
+
+/**
+ * Block the backend on a first record "0" and fill the queue (4 cells) with "1".."4".
+ */
+std::shared_ptr<gated_appender> fill_queue(log4cpp::async::async_dispatcher &dispatcher,
+                                           const log4cpp::async::overflow_control &overflow,
+                                           std::shared_ptr<const log4cpp::async::appender_list> &appenders) {
+    auto appender = std::make_shared<gated_appender>();
+    appenders = std::make_shared<const log4cpp::async::appender_list>(log4cpp::async::appender_list{appender});
+    EXPECT_EQ(log4cpp::async::submit_result::QUEUED,
+              submit_line(dispatcher, log4cpp::log_level::WARN, overflow, appenders, "0"));
+    appender->wait_entered();
+    for (const char *text: {"1", "2", "3", "4"}) {
+        EXPECT_EQ(log4cpp::async::submit_result::QUEUED,
+                  submit_line(dispatcher, log4cpp::log_level::WARN, overflow, appenders, text));
+    }
+    return appender;
+}
+
+TEST(async_logging_test, ring_buffer_test) {
+    log4cpp::common::ring_buffer<int> ring(3);
+    EXPECT_EQ(4U, ring.capacity());
+    for (int i = 0; i < 4; ++i) {
+        auto slot = ring.claim_push();
+        ASSERT_TRUE(slot);
+        *slot.data = i;
+        ring.publish(slot);
+    }
+    EXPECT_FALSE(ring.claim_push());
+    EXPECT_EQ(4U, ring.size());
+    for (int i = 0; i < 4; ++i) {
+        auto slot = ring.claim_pop();
+        ASSERT_TRUE(slot);
+        EXPECT_EQ(i, *slot.data);
+        ring.release(slot);
+    }
+    EXPECT_FALSE(ring.claim_pop());
+    EXPECT_EQ(0U, ring.size());
+}
+
+TEST(async_logging_test, multi_producer_test) {
+    constexpr int PRODUCERS = 4;
+    constexpr int RECORDS = 10000;
+    auto appender = std::make_shared<capture_appender>();
+    const auto appenders =
+        std::make_shared<const log4cpp::async::appender_list>(log4cpp::async::appender_list{appender});
+
+    // A small queue, producers have to wait for the backend
+    log4cpp::async::async_dispatcher dispatcher(log4cpp::config::async_mode{64});
+    std::vector<std::thread> producers;
+    for (int p = 0; p < PRODUCERS; ++p) {
+        producers.emplace_back([&dispatcher, &appenders, p] {
+            for (int i = 0; i < RECORDS; ++i) {
+                const auto result = dispatcher.submit(log4cpp::log_level::INFO, log4cpp::async::overflow_control{},
+                                                      appenders, [p, i](char *buf, size_t len) {
+                                                          return static_cast<size_t>(
+                                                              std::snprintf(buf, len, "%d %d\n", p, i));
+                                                      });
+                EXPECT_EQ(log4cpp::async::submit_result::QUEUED, result);
+            }
+        });
+    }
+    for (auto &t: producers) {
+        t.join();
+    }
+    dispatcher.shutdown();
+
+    ASSERT_EQ(static_cast<size_t>(PRODUCERS * RECORDS), appender->lines.size());
+    // Lines of one producer keep their order
+    std::vector<int> next(PRODUCERS, 0);
+    for (const auto &line: appender->lines) {
+        int p = -1;
+        int i = -1;
+        ASSERT_EQ(2, std::sscanf(line.c_str(), "%d %d", &p, &i));
+        ASSERT_TRUE(p >= 0 && p < PRODUCERS);
+        EXPECT_EQ(next[p], i);
+        next[p] = i + 1;
+    }
+}
+
+TEST(async_logging_test, submit_after_shutdown_test) {
+    auto appender = std::make_shared<capture_appender>();
+    const auto appenders =
+        std::make_shared<const log4cpp::async::appender_list>(log4cpp::async::appender_list{appender});
+    log4cpp::async::async_dispatcher dispatcher(log4cpp::config::async_mode{});
+    const log4cpp::async::overflow_control overflow;
+    ASSERT_EQ(log4cpp::async::submit_result::QUEUED,
+              submit_line(dispatcher, log4cpp::log_level::WARN, overflow, appenders, "queued\n"));
+    dispatcher.shutdown();
+    // Everything queued before shutdown() has been written
+    ASSERT_EQ(1U, appender->lines.size());
+    EXPECT_EQ("queued\n", appender->lines[0]);
+    bool formatted = false;
+    EXPECT_EQ(log4cpp::async::submit_result::REJECTED,
+              dispatcher.submit(log4cpp::log_level::WARN, overflow, appenders, [&formatted](char *, size_t) {
+                  formatted = true;
+                  return static_cast<size_t>(0);
+              }));
+    EXPECT_FALSE(formatted);
+}
+
+#ifndef _WIN32
+TEST(async_logging_test, block_sleeps_on_full_queue_test) {
+    log4cpp::async::async_dispatcher dispatcher(log4cpp::config::async_mode{4});
+    const log4cpp::async::overflow_control overflow{log4cpp::config::overflow_policy::BLOCK, log4cpp::log_level::WARN,
+                                                    nullptr};
+    std::shared_ptr<const log4cpp::async::appender_list> appenders;
+    const auto appender = fill_queue(dispatcher, overflow, appenders);
+
+    // Two producers wait for room while the backend is stuck, they must not burn a core each
+    std::atomic<long> cpu_ns[2] = {0, 0};
+    std::vector<std::thread> producers;
+    for (int i = 0; i < 2; ++i) {
+        producers.emplace_back([&, i] {
+            timespec start{};
+            timespec end{};
+            clock_gettime(CLOCK_THREAD_CPUTIME_ID, &start);
+            EXPECT_EQ(log4cpp::async::submit_result::QUEUED,
+                      submit_line(dispatcher, log4cpp::log_level::WARN, overflow, appenders, "5"));
+            clock_gettime(CLOCK_THREAD_CPUTIME_ID, &end);
+            cpu_ns[i] = (end.tv_sec - start.tv_sec) * 1000000000L + (end.tv_nsec - start.tv_nsec);
+        });
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    appender->release();
+    for (auto &producer: producers) {
+        producer.join();
+    }
+    dispatcher.shutdown();
+    EXPECT_EQ((std::vector<std::string>{"0", "1", "2", "3", "4", "5", "5"}), appender->lines);
+    for (const auto &ns: cpu_ns) {
+        EXPECT_LT(ns.load(), 100000000L);
+    }
+}
+#endif
+
+TEST(async_logging_test, drop_newest_test) {
+    log4cpp::async::async_dispatcher dispatcher(log4cpp::config::async_mode{4});
+    std::atomic<uint64_t> dropped{0};
+    const log4cpp::async::overflow_control overflow{log4cpp::config::overflow_policy::DROP_NEWEST,
+                                                    log4cpp::log_level::WARN, &dropped};
+    std::shared_ptr<const log4cpp::async::appender_list> appenders;
+    const auto appender = fill_queue(dispatcher, overflow, appenders);
+
+    EXPECT_EQ(log4cpp::async::submit_result::DROPPED,
+              submit_line(dispatcher, log4cpp::log_level::FATAL, overflow, appenders, "5"));
+    EXPECT_EQ(1U, dropped.load());
+    appender->release();
+    dispatcher.shutdown();
+    EXPECT_EQ((std::vector<std::string>{"0", "1", "2", "3", "4"}), appender->lines);
+}
+
+TEST(async_logging_test, drop_oldest_test) {
+    log4cpp::async::async_dispatcher dispatcher(log4cpp::config::async_mode{4});
+    std::atomic<uint64_t> dropped{0};
+    const log4cpp::async::overflow_control overflow{log4cpp::config::overflow_policy::DROP_OLDEST,
+                                                    log4cpp::log_level::WARN, &dropped};
+    std::shared_ptr<const log4cpp::async::appender_list> appenders;
+    const auto appender = fill_queue(dispatcher, overflow, appenders);
+
+    EXPECT_EQ(log4cpp::async::submit_result::QUEUED,
+              submit_line(dispatcher, log4cpp::log_level::INFO, overflow, appenders, "5"));
+    EXPECT_EQ(1U, dropped.load());
+    appender->release();
+    dispatcher.shutdown();
+    EXPECT_EQ((std::vector<std::string>{"0", "2", "3", "4", "5"}), appender->lines);
+}
+
+TEST(async_logging_test, drop_below_level_test) {
+    log4cpp::async::async_dispatcher dispatcher(log4cpp::config::async_mode{4});
+    std::atomic<uint64_t> dropped{0};
+    const log4cpp::async::overflow_control overflow{log4cpp::config::overflow_policy::DROP_BELOW_LEVEL,
+                                                    log4cpp::log_level::WARN, &dropped};
+    auto appender = std::make_shared<gated_appender>();
+    const auto appenders =
+        std::make_shared<const log4cpp::async::appender_list>(log4cpp::async::appender_list{appender});
+    ASSERT_EQ(log4cpp::async::submit_result::QUEUED,
+              submit_line(dispatcher, log4cpp::log_level::INFO, overflow, appenders, "0"));
+    appender->wait_entered();
+    for (const char *text: {"1", "2", "3"}) {
+        EXPECT_EQ(log4cpp::async::submit_result::QUEUED,
+                  submit_line(dispatcher, log4cpp::log_level::DEBUG, overflow, appenders, text));
+    }
+    // 3 of 4 cells used: less severe than WARN is dropped, WARN and above still get the last cell
+    EXPECT_EQ(log4cpp::async::submit_result::DROPPED,
+              submit_line(dispatcher, log4cpp::log_level::TRACE, overflow, appenders, "trace"));
+    EXPECT_EQ(log4cpp::async::submit_result::DROPPED,
+              submit_line(dispatcher, log4cpp::log_level::INFO, overflow, appenders, "info"));
+    EXPECT_EQ(log4cpp::async::submit_result::QUEUED,
+              submit_line(dispatcher, log4cpp::log_level::WARN, overflow, appenders, "warn"));
+    EXPECT_EQ(2U, dropped.load());
+    appender->release();
+    dispatcher.shutdown();
+    EXPECT_EQ((std::vector<std::string>{"0", "1", "2", "3", "warn"}), appender->lines);
+}
+
+TEST(async_logging_test, async_config_test) {
+    auto &log_mgr = log4cpp::supervisor::get_logger_manager();
+    ASSERT_NO_THROW(log_mgr.load_config("test_async.json"));
+    const auto *cfg = log_mgr.get_config();
+    ASSERT_TRUE(cfg->async.has_value());
+    EXPECT_EQ(1024U, cfg->async->queue_size);
+    EXPECT_EQ(log4cpp::config::overflow_policy::DROP_BELOW_LEVEL, cfg->async->overflow_policy);
+    EXPECT_EQ(log4cpp::log_level::ERROR, cfg->async->overflow_level);
+    EXPECT_TRUE(cfg->async->deferred_format);
+    const auto &root_cfg = cfg->loggers.at("root");
+    ASSERT_TRUE(root_cfg.overflow_policy.has_value());
+    EXPECT_EQ(log4cpp::config::overflow_policy::DROP_NEWEST, root_cfg.overflow_policy.value());
+    EXPECT_FALSE(root_cfg.overflow_level.has_value());
+
+    const auto log = log4cpp::logger_manager::get_logger("async");
+    for (int i = 0; i < 100; ++i) {
+        log->info("async record %d", i);
+        log->info(LOG4CPP_FMT("deferred record {}"), i);
+    }
+    EXPECT_LE(log_mgr.get_dropped_records("async"), 200U);
+    EXPECT_EQ(0U, log_mgr.get_dropped_records("no-such-logger"));
+}
+
+TEST(async_logging_test, deferred_format_test) {
+    log4cpp::config::async_mode cfg;
+    cfg.deferred_format = true;
+    auto dispatcher = std::make_shared<log4cpp::async::async_dispatcher>(cfg);
+    auto appender = std::make_shared<capture_appender>();
+    log4cpp::real_logger log("deferred", log4cpp::log_level::INFO, "[${16TN}] ${msg}");
+    log.add_appender(appender);
+    log.set_dispatcher(dispatcher);
+
+    std::thread producer([&log] {
+        log4cpp::set_thread_name("producer");
+        std::string user = "alice";
+        const char *c_str = "c-string";
+        log.log(log4cpp::log_level::INFO,
+                log4cpp::format::format_args{"{} {} {:.1f} {}", nullptr, 0}); // no arguments: written as is
+        log.info(LOG4CPP_FMT("{} {} {:.1f} {:x}"), user, c_str, 2.25, 255U);
+        // The arguments are copied, the record does not depend on them after the call
+        user.assign("bob");
+        // Too long to queue the arguments, the caller formats the line
+        log.info(LOG4CPP_FMT("{:.8}"), std::string(2 * log4cpp::LOG_LINE_MAX, 'x'));
+        log.warn("printf %d", 1);
+    });
+    producer.join();
+    dispatcher->shutdown();
+
+    ASSERT_EQ(4U, appender->lines.size());
+    EXPECT_EQ("[producer        ] {} {} {:.1f} {}\n", appender->lines[0]);
+    EXPECT_EQ("[producer        ] alice c-string 2.2 ff\n", appender->lines[1]);
+    EXPECT_EQ("[producer        ] xxxxxxxx\n", appender->lines[2]);
+    EXPECT_EQ("[producer        ] printf 1\n", appender->lines[3]);
+}
@@ -1,10 +1,32 @@
+#include <chrono>
+#include <condition_variable>
 #include <filesystem>
+#include <fstream>
+#include <future>
+#include <mutex>
+#include <sstream>
+#include <string>
 #include <thread>
+#include <vector>
 
 #include <gtest/gtest.h>
 
+#ifndef _WIN32
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
 #include "log4cpp/log4cpp.hpp"
 
+#include "appender/file_appender.hpp"
+#include "appender/file_archiver.hpp"
+#include "appender/file_syncer.hpp"
+#include "appender/mmap_file_appender.hpp"
+#include "common/json.hpp"
+#include "config/log4cpp.hpp"
+#include "exception/config_exception.hpp"
+#include "logger/real_logger.hpp"
+
 void info_logger() {
     const std::shared_ptr<log4cpp::logger> log = log4cpp::logger_manager::get_logger("aaa");
     log->trace("this is a trace");
@@ -44,3 +66,571 @@ TEST(file_appender_test, multithread_test) {
     info_logger_thread.join();
     warn_logger_thread.join();
 }
+
+std::string read_file(const std::string &path) {
+    std::ifstream ifs(path, std::ios::binary);
+    std::stringstream ss;
+    ss << ifs.rdbuf();
+    return ss.str();
+}
+
+log4cpp::config::file_appender buffered_config(const std::string &path, size_t buffer_size,
+                                               unsigned int flush_interval_ms) {
+    std::filesystem::remove(path);
+    log4cpp::config::file_appender cfg;
+    cfg.file_path = path;
+    cfg.buffer_size = buffer_size;
+    cfg.flush_interval_ms = flush_interval_ms;
+    return cfg;
+}
+
+TEST(file_appender_test, buffered_write_test) {
+    const std::string path = "log/file_appender_buffer_test.log";
+    {
+        log4cpp::appender::file_appender appender(buffered_config(path, 16, 0));
+        appender.log("one\n", 4);
+        appender.log("two\n", 4);
+        EXPECT_EQ("", read_file(path));
+        appender.flush();
+        EXPECT_EQ("one\ntwo\n", read_file(path));
+
+        // A full buffer is written before the record that does not fit
+        appender.log("0123456789\n", 11);
+        appender.log("abcdefghij\n", 11);
+        EXPECT_EQ("one\ntwo\n0123456789\n", read_file(path));
+
+        // A record larger than the buffer goes out right after the buffered ones, in order
+        const std::string large(40, 'x');
+        appender.log(large.c_str(), large.size());
+        EXPECT_EQ("one\ntwo\n0123456789\nabcdefghij\n" + large, read_file(path));
+        appender.log("tail\n", 5);
+    }
+    // Destruction writes out what is left
+    EXPECT_EQ("one\ntwo\n0123456789\nabcdefghij\n" + std::string(40, 'x') + "tail\n", read_file(path));
+}
+
+TEST(file_appender_test, error_level_flush_test) {
+    const std::string path = "log/file_appender_error_flush_test.log";
+    auto appender = std::make_shared<log4cpp::appender::file_appender>(buffered_config(path, 4096, 0));
+    log4cpp::real_logger log("flush", log4cpp::log_level::INFO, "${msg}");
+    log.add_appender(appender);
+    log.info("buffered");
+    EXPECT_EQ("", read_file(path));
+    log.error("flushed");
+    EXPECT_EQ("buffered\nflushed\n", read_file(path));
+}
+
+TEST(file_appender_test, flush_interval_test) {
+    const std::string path = "log/file_appender_interval_test.log";
+    log4cpp::appender::file_appender appender(buffered_config(path, 4096, 10));
+    appender.log("timed\n", 6);
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (read_file(path).empty() && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    EXPECT_EQ("timed\n", read_file(path));
+}
+
+TEST(file_appender_test, buffered_config_test) {
+    auto &log_mgr = log4cpp::supervisor::get_logger_manager();
+    ASSERT_NO_THROW(log_mgr.load_config("test_file_appender_buffered.json"));
+    const std::shared_ptr<log4cpp::logger> log = log4cpp::logger_manager::get_logger("root");
+    for (int i = 0; i < 1000; ++i) {
+        log->info("buffered record %d", i);
+    }
+    log->error("flushes the buffer");
+    const std::string content = read_file("log/file_appender_buffered_test.log");
+    EXPECT_NE(std::string::npos, content.find("buffered record 999"));
+    EXPECT_NE(std::string::npos, content.find("flushes the buffer"));
+}
+
+log4cpp::config::file_appender rolling_config(const std::string &path, size_t max_file_size,
+                                              unsigned int max_backup_index) {
+    for (const char *suffix: {"", ".1", ".2", ".3", ".1.gz", ".2.gz"}) {
+        std::filesystem::remove(path + suffix);
+    }
+    log4cpp::config::file_appender cfg;
+    cfg.file_path = path;
+    cfg.max_file_size = max_file_size;
+    cfg.max_backup_index = max_backup_index;
+    return cfg;
+}
+
+void write_records(log4cpp::appender::log_appender &appender, int first, int last) {
+    for (int i = first; i <= last; ++i) {
+        // 30 bytes per record
+        char record[32];
+        const int len = std::snprintf(record, sizeof(record), "record %02d ...................\n", i);
+        appender.log(record, static_cast<size_t>(len));
+    }
+}
+
+TEST(file_appender_test, size_rolling_test) {
+    const std::string path = "log/file_appender_size_rolling_test.log";
+    const auto cfg = rolling_config(path, 100, 2);
+    {
+        // Three records per file, the oldest file is deleted
+        log4cpp::appender::file_appender appender(cfg);
+        write_records(appender, 0, 9);
+    }
+    EXPECT_EQ(30U, read_file(path).size());
+    EXPECT_EQ(0U, read_file(path).find("record 09"));
+    EXPECT_EQ(90U, read_file(path + ".1").size());
+    EXPECT_EQ(0U, read_file(path + ".1").find("record 06"));
+    EXPECT_EQ(0U, read_file(path + ".2").find("record 03"));
+    EXPECT_FALSE(std::filesystem::exists(path + ".3"));
+}
+
+TEST(file_appender_test, gzip_rolling_test) {
+    const std::string path = "log/file_appender_gzip_rolling_test.log";
+    auto cfg = rolling_config(path, 100, 2);
+    try {
+        log4cpp::config::from_string("gzip", cfg.compress);
+    }
+    catch (const log4cpp::config::invalid_config_exception &) {
+        GTEST_SKIP() << "built without zlib";
+    }
+    {
+        log4cpp::appender::file_appender appender(cfg);
+        write_records(appender, 0, 6);
+    }
+    // The archiver has finished when the appender is destroyed
+    EXPECT_FALSE(std::filesystem::exists(path + ".1"));
+    const std::string compressed = read_file(path + ".1.gz");
+    ASSERT_GE(compressed.size(), 2U);
+    EXPECT_EQ('\x1f', compressed[0]);
+    EXPECT_EQ('\x8b', compressed[1]);
+    EXPECT_TRUE(std::filesystem::exists(path + ".2.gz"));
+    EXPECT_EQ(0U, read_file(path).find("record 06"));
+}
+
+TEST(file_appender_test, time_rolling_test) {
+    const std::string path = "log/file_appender_time_rolling_test.log";
+    auto cfg = rolling_config(path, 0, 1);
+    cfg.rolling = log4cpp::config::rolling_interval::DAILY;
+    {
+        std::ofstream ofs(path);
+        ofs << "yesterday\n";
+    }
+    std::filesystem::last_write_time(path, std::filesystem::file_time_type::clock::now() - std::chrono::hours(48));
+    {
+        // A file from an earlier day rolls with the first record
+        log4cpp::appender::file_appender appender(cfg);
+        appender.log("today\n", 6);
+        appender.log("still today\n", 12);
+    }
+    EXPECT_EQ("yesterday\n", read_file(path + ".1"));
+    EXPECT_EQ("today\nstill today\n", read_file(path));
+}
+
+TEST(file_appender_test, archiver_reload_test) {
+    const std::string path = "log/file_appender_archiver_reload_test.log";
+    const auto cfg = rolling_config(path, 100, 3);
+    std::filesystem::remove(path + ".rolling-1");
+    std::promise<void> finish;
+    std::shared_future<void> finished = finish.get_future().share();
+    auto old_archiver = std::make_unique<log4cpp::appender::file_archiver>(cfg);
+    // Rolled by the appender a hot reload replaces, still being finished by its writer
+    const std::string rolled = old_archiver->next_rolled_path();
+    {
+        std::ofstream ofs(rolled);
+        ofs << "rolled\n";
+    }
+    old_archiver->submit(rolled, [finished] { finished.wait(); });
+    // Left by a process that died before archiving it
+    {
+        std::ofstream ofs(path + ".rolling-1");
+        ofs << "leftover\n";
+    }
+    // The new archiver adopts the leftover only
+    std::make_unique<log4cpp::appender::file_archiver>(cfg).reset();
+    EXPECT_TRUE(std::filesystem::exists(rolled));
+    EXPECT_EQ("leftover\n", read_file(path + ".1"));
+    finish.set_value();
+    old_archiver.reset();
+    EXPECT_EQ("rolled\n", read_file(path + ".1"));
+    EXPECT_EQ("leftover\n", read_file(path + ".2"));
+    EXPECT_FALSE(std::filesystem::exists(path + ".3"));
+}
+
+TEST(file_appender_test, rolling_config_test) {
+    log4cpp::config::file_appender cfg;
+    const char *json = R"({"file-path": "a.log", "max-file-size": "10MB", "rolling-interval": "HOURLY"})";
+    from_json(log4cpp::json_value::parse(json), cfg);
+    EXPECT_EQ(10U * 1024 * 1024, cfg.max_file_size);
+    EXPECT_EQ(log4cpp::config::FILE_MAX_BACKUP_INDEX_DEFAULT, cfg.max_backup_index);
+    EXPECT_EQ(log4cpp::config::rolling_interval::HOURLY, cfg.rolling);
+    EXPECT_EQ(log4cpp::config::compression::NONE, cfg.compress);
+    from_json(log4cpp::json_value::parse(R"({"file-path": "a.log", "max-file-size": 4096})"), cfg);
+    EXPECT_EQ(4096U, cfg.max_file_size);
+    EXPECT_THROW(from_json(log4cpp::json_value::parse(R"({"file-path": "a.log", "max-file-size": "10XB"})"), cfg),
+                 log4cpp::config::invalid_config_exception);
+    EXPECT_THROW(from_json(log4cpp::json_value::parse(R"({"file-path": "a.log", "rolling-interval": "weekly"})"), cfg),
+                 log4cpp::config::invalid_config_exception);
+    from_json(log4cpp::json_value::parse(R"({"file-path": "a.log", "write-mode": "MMAP"})"), cfg);
+    EXPECT_EQ(log4cpp::config::write_mode::MMAP, cfg.mode);
+    from_json(log4cpp::json_value::parse(R"({"file-path": "a.log", "write-mode": "io-uring"})"), cfg);
+    EXPECT_EQ(log4cpp::config::write_mode::IO_URING, cfg.mode);
+
+    auto &log_mgr = log4cpp::supervisor::get_logger_manager();
+    ASSERT_NO_THROW(log_mgr.load_config("test_file_appender_rolling.json"));
+}
+
+TEST(file_appender_test, named_appender_test) {
+    for (const char *name: {"default", "access", "audit"}) {
+        std::filesystem::remove(std::string("log/named_appender_") + name + ".log");
+    }
+    auto &log_mgr = log4cpp::supervisor::get_logger_manager();
+    ASSERT_NO_THROW(log_mgr.load_config("test_named_appenders.json"));
+    log4cpp::logger_manager::get_logger("access")->info("GET /");
+    log4cpp::logger_manager::get_logger("audit")->info("login");
+    log4cpp::logger_manager::get_logger("other")->info("fallback");
+    // The access file is buffered on its own
+    EXPECT_EQ("", read_file("log/named_appender_access.log"));
+    log4cpp::logger_manager::get_logger("access")->error("POST /");
+    EXPECT_EQ("GET /\nPOST /\n", read_file("log/named_appender_access.log"));
+    EXPECT_EQ("login\n", read_file("log/named_appender_audit.log"));
+    EXPECT_EQ("login\nfallback\n", read_file("log/named_appender_default.log"));
+}
+
+TEST(file_appender_test, named_appender_config_test) {
+    const std::string cfg_text = read_file("test_named_appenders.json");
+    const log4cpp::config::log4cpp cfg = log4cpp::config::log4cpp::deserialize(cfg_text);
+    ASSERT_EQ(2U, cfg.appenders.named_files.size());
+    EXPECT_EQ("log/named_appender_access.log", cfg.appenders.named_files.at("access_file").file_path);
+    EXPECT_EQ(std::vector<std::string>({"audit_file"}), cfg.loggers.at("audit").named_appenders);
+    EXPECT_EQ(static_cast<unsigned char>(log4cpp::config::APPENDER_TYPE::FILE), cfg.loggers.at("audit").appender);
+    EXPECT_EQ(cfg, log4cpp::config::log4cpp::deserialize(log4cpp::config::log4cpp::serialize(cfg)));
+
+    const auto parse = [](const char *appenders, const char *logger_appenders) {
+        const std::string json = std::string(R"({"appenders": )") + appenders +
+                                 R"(, "loggers": [{"name": "root", "level": "INFO", "appenders": )" +
+                                 logger_appenders + "}]}";
+        return log4cpp::config::log4cpp::deserialize(json);
+    };
+    EXPECT_NO_THROW(parse(R"({"a": {"type": "file", "file-path": "a.log"}})", R"(["a"])"));
+    EXPECT_THROW(parse(R"({"a": {"type": "file", "file-path": "a.log"}})", R"(["b"])"),
+                 log4cpp::config::invalid_config_exception);
+    EXPECT_THROW(parse(R"({"a": {"file-path": "a.log"}})", R"(["a"])"), log4cpp::config::invalid_config_exception);
+    EXPECT_THROW(parse(R"({"a": {"type": "socket", "host": "localhost"}})", R"(["a"])"),
+                 log4cpp::config::invalid_config_exception);
+    EXPECT_THROW(parse(R"({"file": {"file-path": "a.log"}, "a": {"type": "file", "file-path": "a.log"}})", R"(["a"])"),
+                 log4cpp::config::invalid_config_exception);
+}
+
+// Counts the records and the sync() calls a logger makes
+class sync_counting_appender: public log4cpp::appender::log_appender {
+public:
+    explicit sync_counting_appender(log4cpp::log_level level) {
+        sync_level = level;
+    }
+
+    void log(const char *, size_t) override {
+        ++records;
+    }
+
+    void sync() override {
+        syncs.push_back(records);
+    }
+
+    int records{0};
+    // The number of records logged at every sync
+    std::vector<int> syncs;
+};
+
+TEST(file_appender_test, sync_level_test) {
+    auto appender = std::make_shared<sync_counting_appender>(log4cpp::log_level::WARN);
+    log4cpp::real_logger log("sync", log4cpp::log_level::TRACE, "${msg}");
+    log.add_appender(appender);
+    log.info("not synced");
+    log.debug("not synced");
+    log.warn("synced");
+    log.info("not synced");
+    log.error("synced");
+    EXPECT_EQ(std::vector<int>({3, 5}), appender->syncs);
+}
+
+TEST(file_appender_test, file_syncer_test) {
+    std::mutex mtx;
+    std::condition_variable cv;
+    int syncs = 0;
+    const auto count = [&] {
+        std::lock_guard<std::mutex> lock(mtx);
+        ++syncs;
+        cv.notify_all();
+    };
+    const auto wait_for = [&](int n) {
+        std::unique_lock<std::mutex> lock(mtx);
+        return cv.wait_for(lock, std::chrono::seconds(5), [&] { return syncs >= n; });
+    };
+    {
+        // Only the record crossing the byte limit wakes the thread
+        log4cpp::appender::file_syncer syncer(0, 100, count);
+        syncer.written(60);
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        EXPECT_EQ(0, syncs);
+        syncer.written(60);
+        EXPECT_TRUE(wait_for(1));
+        syncer.written(150);
+        EXPECT_TRUE(wait_for(2));
+    }
+    syncs = 0;
+    {
+        log4cpp::appender::file_syncer syncer(5, 0, count);
+        EXPECT_TRUE(wait_for(3));
+    }
+}
+
+TEST(file_appender_test, durability_config_test) {
+    log4cpp::config::file_appender cfg;
+    from_json(log4cpp::json_value::parse(R"({"file-path": "a.log"})"), cfg);
+    EXPECT_FALSE(cfg.syncs());
+    const char *json = R"({"file-path": "a.log", "sync-level": "error", "sync-interval-ms": 500, "sync-bytes": "1MB"})";
+    from_json(log4cpp::json_value::parse(json), cfg);
+    EXPECT_EQ(log4cpp::log_level::ERROR, cfg.sync_level);
+    EXPECT_EQ(500U, cfg.sync_interval_ms);
+    EXPECT_EQ(1024U * 1024, cfg.sync_bytes);
+    EXPECT_TRUE(cfg.syncs());
+    log4cpp::json_value j;
+    to_json(j, cfg);
+    log4cpp::config::file_appender parsed;
+    from_json(j, parsed);
+    EXPECT_EQ(cfg, parsed);
+    EXPECT_THROW(from_json(log4cpp::json_value::parse(R"({"file-path": "a.log", "sync-level": "loud"})"), cfg),
+                 std::invalid_argument);
+
+    // A synced appender writes the same content
+    const std::string path = "log/file_appender_sync_test.log";
+    auto synced = buffered_config(path, 4096, 0);
+    synced.sync_level = log4cpp::log_level::ERROR;
+    synced.sync_interval_ms = 1;
+    synced.sync_bytes = 8;
+    {
+        log4cpp::appender::file_appender appender(synced);
+        appender.log("one\n", 4);
+        appender.sync();
+        EXPECT_EQ("one\n", read_file(path));
+        appender.log("two\n", 4);
+    }
+    EXPECT_EQ("one\ntwo\n", read_file(path));
+}
+
+#ifndef _WIN32
+TEST(file_appender_test, mmap_append_test) {
+    const std::string path = "log/file_appender_mmap_append_test.log";
+    auto cfg = rolling_config(path, 0, 1);
+    cfg.mode = log4cpp::config::write_mode::MMAP;
+    {
+        std::ofstream ofs(path);
+        ofs << "old\n";
+    }
+    {
+        log4cpp::appender::mmap_file_appender appender(cfg);
+        appender.log("new\n", 4);
+        // Padded up to the end of the mapped chunk while open
+        EXPECT_LT(8U, std::filesystem::file_size(path));
+    }
+    // Truncated to the content on close
+    EXPECT_EQ("old\nnew\n", read_file(path));
+}
+
+TEST(file_appender_test, mmap_reopen_after_kill_test) {
+    const std::string path = "log/file_appender_mmap_reopen_test.log";
+    std::filesystem::remove(path);
+    auto cfg = rolling_config(path, 0, 1);
+    cfg.mode = log4cpp::config::write_mode::MMAP;
+    const pid_t pid = fork();
+    ASSERT_NE(-1, pid);
+    if (0 == pid) {
+        // Dies with the file still padded
+        auto *appender = new log4cpp::appender::mmap_file_appender(cfg);
+        appender->log("first\n", 6);
+        _exit(0);
+    }
+    int status = 0;
+    ASSERT_EQ(pid, waitpid(pid, &status, 0));
+    EXPECT_LT(6U, std::filesystem::file_size(path));
+    {
+        log4cpp::appender::mmap_file_appender appender(cfg);
+        appender.log("second\n", 7);
+    }
+    EXPECT_EQ("first\nsecond\n", read_file(path));
+}
+
+TEST(file_appender_test, mmap_reopen_same_path_test) {
+    // A hot reload that changes the configuration but keeps the path
+    const std::string path = "log/file_appender_mmap_same_path_test.log";
+    std::filesystem::remove(path);
+    auto cfg = rolling_config(path, 0, 1);
+    cfg.mode = log4cpp::config::write_mode::MMAP;
+    auto old_appender = std::make_unique<log4cpp::appender::mmap_file_appender>(cfg);
+    old_appender->log("old 1\n", 6);
+    auto new_appender = std::make_unique<log4cpp::appender::mmap_file_appender>(cfg);
+    old_appender->log("old 2\n", 6);
+    new_appender->log("new 1\n", 6);
+    old_appender.reset();
+    new_appender->log("new 2\n", 6);
+    new_appender.reset();
+    EXPECT_EQ("old 1\nold 2\nnew 1\nnew 2\n", read_file(path));
+}
+
+TEST(file_appender_test, mmap_concurrent_write_test) {
+    const std::string path = "log/file_appender_mmap_concurrent_test.log";
+    auto cfg = rolling_config(path, 0, 1);
+    cfg.mode = log4cpp::config::write_mode::MMAP;
+    constexpr int THREADS = 4;
+    // About 24 MB, records straddle the boundaries of the mapped chunks
+    constexpr int RECORDS = 6000;
+    const std::string payload(1000, '.');
+    {
+        log4cpp::appender::mmap_file_appender appender(cfg);
+        std::vector<std::thread> threads;
+        for (int t = 0; t < THREADS; ++t) {
+            threads.emplace_back([&appender, &payload, t] {
+                for (int i = 0; i < RECORDS; ++i) {
+                    const std::string record = std::to_string(t) + " " + std::to_string(i) + " " + payload + "\n";
+                    appender.log(record.c_str(), record.size());
+                }
+            });
+        }
+        for (auto &thread: threads) {
+            thread.join();
+        }
+    }
+    std::ifstream ifs(path);
+    std::vector<int> next(THREADS, 0);
+    std::string line;
+    int lines = 0;
+    while (std::getline(ifs, line)) {
+        int t = -1;
+        int i = -1;
+        char rest[8] = {};
+        ASSERT_EQ(3, std::sscanf(line.c_str(), "%d %d %7s", &t, &i, rest)) << line.substr(0, 32);
+        ASSERT_TRUE(t >= 0 && t < THREADS);
+        // Records of one thread stay in order
+        EXPECT_EQ(next[t], i);
+        next[t] = i + 1;
+        EXPECT_EQ(payload.size() + std::to_string(t).size() + std::to_string(i).size() + 2, line.size());
+        ++lines;
+    }
+    EXPECT_EQ(THREADS * RECORDS, lines);
+}
+
+TEST(file_appender_test, mmap_size_rolling_test) {
+    const std::string path = "log/file_appender_mmap_rolling_test.log";
+    auto cfg = rolling_config(path, 100, 2);
+    cfg.mode = log4cpp::config::write_mode::MMAP;
+    {
+        log4cpp::appender::mmap_file_appender appender(cfg);
+        write_records(appender, 0, 9);
+    }
+    EXPECT_EQ(0U, read_file(path).find("record 09"));
+    EXPECT_EQ(30U, read_file(path).size());
+    EXPECT_EQ(0U, read_file(path + ".1").find("record 06"));
+    EXPECT_EQ(90U, read_file(path + ".1").size());
+    EXPECT_EQ(0U, read_file(path + ".2").find("record 03"));
+    EXPECT_FALSE(std::filesystem::exists(path + ".3"));
+}
+
+TEST(file_appender_test, mmap_concurrent_rolling_test) {
+    const std::string path = "log/file_appender_mmap_concurrent_rolling_test.log";
+    constexpr unsigned int BACKUPS = 40;
+    for (unsigned int i = 1; i <= BACKUPS; ++i) {
+        std::filesystem::remove(path + "." + std::to_string(i));
+    }
+    auto cfg = rolling_config(path, 4096, BACKUPS);
+    cfg.mode = log4cpp::config::write_mode::MMAP;
+    constexpr int THREADS = 4;
+    constexpr int RECORDS = 1000;
+    {
+        log4cpp::appender::mmap_file_appender appender(cfg);
+        std::vector<std::thread> threads;
+        for (int t = 0; t < THREADS; ++t) {
+            threads.emplace_back([&appender] {
+                for (int i = 0; i < RECORDS / 100; ++i) {
+                    write_records(appender, 0, 99);
+                }
+            });
+        }
+        for (auto &thread: threads) {
+            thread.join();
+        }
+    }
+    // Every record is in exactly one file, no file has padding left
+    size_t total = 0;
+    for (unsigned int i = 0; i <= BACKUPS; ++i) {
+        const std::string content = read_file(0 == i ? path : path + "." + std::to_string(i));
+        EXPECT_EQ(std::string::npos, content.find('\0')) << "file " << i;
+        EXPECT_EQ(0U, content.size() % 30) << "file " << i;
+        total += content.size();
+    }
+    EXPECT_EQ(30U * THREADS * RECORDS, total);
+}
+#endif
+
+TEST(file_appender_test, uring_write_test) {
+    // Falls back to write() where the kernel has no io_uring, the content is the same
+    const std::string path = "log/file_appender_uring_test.log";
+    auto cfg = buffered_config(path, 16, 0);
+    cfg.mode = log4cpp::config::write_mode::IO_URING;
+    {
+        log4cpp::appender::file_appender appender(cfg);
+        appender.log("one\n", 4);
+        appender.log("two\n", 4);
+        EXPECT_EQ("", read_file(path));
+        appender.flush();
+        EXPECT_EQ("one\ntwo\n", read_file(path));
+
+        // Full buffers are submitted while the next one fills, a large record is copied through all of them
+        appender.log("0123456789\n", 11);
+        appender.log("abcdefghij\n", 11);
+        appender.log("ABCDEFGHIJ\n", 11);
+        const std::string large(40, 'x');
+        appender.log(large.c_str(), large.size());
+        appender.flush();
+        EXPECT_EQ("one\ntwo\n0123456789\nabcdefghij\nABCDEFGHIJ\n" + large, read_file(path));
+        appender.log("tail\n", 5);
+        // Larger than all the buffers together, the oldest ones are reused once written
+        const std::string huge(100, 'y');
+        appender.log(huge.c_str(), huge.size());
+        appender.log("end\n", 4);
+    }
+    const std::string expected = "one\ntwo\n0123456789\nabcdefghij\nABCDEFGHIJ\n" + std::string(40, 'x') + "tail\n";
+    EXPECT_EQ(expected + std::string(100, 'y') + "end\n", read_file(path));
+}
+
+TEST(file_appender_test, uring_concurrent_rolling_test) {
+    const std::string path = "log/file_appender_uring_rolling_test.log";
+    constexpr unsigned int BACKUPS = 40;
+    for (unsigned int i = 1; i <= BACKUPS; ++i) {
+        std::filesystem::remove(path + "." + std::to_string(i));
+    }
+    auto cfg = rolling_config(path, 4096, BACKUPS);
+    cfg.mode = log4cpp::config::write_mode::IO_URING;
+    cfg.buffer_size = 1024;
+    constexpr int THREADS = 4;
+    constexpr int RECORDS = 1000;
+    {
+        log4cpp::appender::file_appender appender(cfg);
+        std::vector<std::thread> threads;
+        for (int t = 0; t < THREADS; ++t) {
+            threads.emplace_back([&appender] {
+                for (int i = 0; i < RECORDS / 100; ++i) {
+                    write_records(appender, 0, 99);
+                }
+            });
+        }
+        for (auto &thread: threads) {
+            thread.join();
+        }
+    }
+    // Every record is in exactly one file, a rolled file has all of its records
+    size_t total = 0;
+    for (unsigned int i = 0; i <= BACKUPS; ++i) {
+        const std::string content = read_file(0 == i ? path : path + "." + std::to_string(i));
+        EXPECT_EQ(0U, content.size() % 30) << "file " << i;
+        EXPECT_GE(4096U, content.size()) << "file " << i;
+        total += content.size();
+    }
+    EXPECT_EQ(30U * THREADS * RECORDS, total);
+}
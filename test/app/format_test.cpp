@@ -0,0 +1,133 @@
+#include <climits>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "log4cpp/log4cpp.hpp"
+
+#include "appender/log_appender.hpp"
+#include "logger/real_logger.hpp"
+
+#include "../include/log4cpp_test.h"
+
+using log4cpp::format::arg_type;
+using log4cpp::format::check;
+using log4cpp::format::format_error;
+
+#define FORMAT(fmt, ...)                                                                                               \
+    [&] {                                                                                                              \
+        char buf[256];                                                                                                 \
+        const size_t len = log4cpp::format::format_to(buf, sizeof(buf), LOG4CPP_FMT(fmt), ##__VA_ARGS__);             \
+        EXPECT_EQ(len, std::strlen(buf));                                                                              \
+        return std::string(buf, len);                                                                                  \
+    }()
+
+// The checks the typed logging methods run in static_assert
+struct two_fields {
+    static constexpr std::string_view value() {
+        return "{} and {:x}";
+    }
+};
+
+struct escaped {
+    static constexpr std::string_view value() {
+        return "{{}} {}";
+    }
+};
+
+struct unmatched {
+    static constexpr std::string_view value() {
+        return "{";
+    }
+};
+
+struct bad_spec {
+    static constexpr std::string_view value() {
+        return "{0}";
+    }
+};
+
+static_assert(format_error::NONE == check<two_fields, const char *, int>());
+static_assert(format_error::TYPE_MISMATCH == check<two_fields, int, const char *>());
+static_assert(format_error::TOO_FEW_ARGS == check<two_fields, int>());
+static_assert(format_error::TOO_MANY_ARGS == check<two_fields, int, int, int>());
+static_assert(format_error::NONE == check<escaped, std::string>());
+static_assert(format_error::UNMATCHED_BRACE == check<unmatched>());
+static_assert(format_error::BAD_SPEC == check<bad_spec, int>());
+static_assert(format_error::UNSUPPORTED_TYPE == check<escaped, std::vector<int>>());
+static_assert(arg_type::STRING == log4cpp::format::type_of<const std::string &>());
+static_assert(arg_type::CSTRING == log4cpp::format::type_of<const char (&)[4]>());
+static_assert(arg_type::UINT == log4cpp::format::type_of<unsigned char>());
+
+TEST(format_tests, integers) {
+    EXPECT_EQ("0 -1 42", FORMAT("{} {} {}", 0, -1, 42L));
+    EXPECT_EQ(std::to_string(LLONG_MIN), FORMAT("{}", LLONG_MIN));
+    EXPECT_EQ(std::to_string(ULLONG_MAX), FORMAT("{}", ULLONG_MAX));
+    EXPECT_EQ("ff FF 17 101", FORMAT("{:x} {:X} {:o} {:b}", 255, 255, 15, 5u));
+    EXPECT_EQ("-2a", FORMAT("{:x}", -42));
+}
+
+TEST(format_tests, floating_point) {
+    EXPECT_EQ("0.1 1.5 -2", FORMAT("{} {} {}", 0.1, 1.5f, -2.0));
+    EXPECT_EQ("3.14 3.141593 1.23e+04", FORMAT("{:.2f} {:f} {:.2e}", 3.14159, 3.14159265, 12345.0));
+    EXPECT_EQ("0.333", FORMAT("{:.3}", 1.0 / 3));
+}
+
+TEST(format_tests, width_and_alignment) {
+    EXPECT_EQ("   42|42   |", FORMAT("{:5}|{:<5}|", 42, 42));
+    EXPECT_EQ("-0042|0000ff|  -42", FORMAT("{:05}|{:06x}|{:>05}", -42, 255, -42));
+    EXPECT_EQ("ab   |   ab", FORMAT("{:5}|{:>5}", "ab", std::string("ab")));
+    EXPECT_EQ("  1.50", FORMAT("{:6.2f}", 1.5));
+}
+
+TEST(format_tests, text_arguments) {
+    const std::string str = "string";
+    const std::string_view view = std::string_view("view and more").substr(0, 4);
+    const char *null_str = nullptr;
+    EXPECT_EQ("literal string view (null)", FORMAT("{} {} {} {}", "literal", str, view, null_str));
+    EXPECT_EQ("str", FORMAT("{:.3}", str));
+    EXPECT_EQ("true 0 x 120", FORMAT("{} {:d} {} {:d}", true, false, 'x', 'x'));
+    EXPECT_EQ("0x0 0x10", FORMAT("{} {}", nullptr, reinterpret_cast<const void *>(0x10)));
+}
+
+TEST(format_tests, braces_and_literals) {
+    EXPECT_EQ("{} 1 }", FORMAT("{{}} {} }}", 1));
+    EXPECT_EQ("no fields", FORMAT("no fields"));
+}
+
+TEST(format_tests, output_is_truncated) {
+    char buf[8];
+    const size_t len = log4cpp::format::format_to(buf, sizeof(buf), LOG4CPP_FMT("{}-{}"), 123456, 789);
+    EXPECT_EQ(7U, len);
+    EXPECT_STREQ("123456-", buf);
+}
+
+TEST(format_tests, runtime_mismatch_is_written_as_is) {
+    // vformat() does not trust its input, fields without an argument are copied
+    char buf[64];
+    const log4cpp::format::format_args args{"{} {:q}", nullptr, 0};
+    log4cpp::format::vformat(buf, sizeof(buf), args);
+    EXPECT_STREQ("{} {:q}", buf);
+}
+
+TEST(format_tests, typed_logger_api) {
+    auto appender = std::make_shared<capture_appender>();
+    auto real = std::make_shared<log4cpp::real_logger>("format", log4cpp::log_level::INFO, "${msg}");
+    real->add_appender(appender);
+    const std::shared_ptr<log4cpp::logger> log = real;
+
+    const std::string user = "alice";
+    log->info(LOG4CPP_FMT("user {} logged in after {:.2f} ms"), user, 12.5);
+    log->error(LOG4CPP_FMT("code {:04}"), 7);
+    log->debug(LOG4CPP_FMT("not written {}"), 1);
+    log->log(log4cpp::log_level::WARN, LOG4CPP_FMT("{}/{}"), 3, 4U);
+
+    ASSERT_EQ(3U, appender->lines.size());
+    EXPECT_EQ("user alice logged in after 12.50 ms\n", appender->lines[0]);
+    EXPECT_EQ("code 0007\n", appender->lines[1]);
+    EXPECT_EQ("3/4\n", appender->lines[2]);
+}
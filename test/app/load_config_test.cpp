@@ -226,3 +226,111 @@ TEST(load_config_test, invalid_socket_protocol) {
         R"({"appenders":{"socket":{"host":"localhost","port":1234,"protocol":"unknown","prefer-stack":"auto"}},"loggers":[{"name":"root","level":"INFO","appenders":["socket"]}]})";
     EXPECT_THROW(log4cpp::config::log4cpp::deserialize(bad_json), std::invalid_argument);
 }
+
+TEST(load_config_test, max_line_size) {
+    constexpr const char *default_json =
+        R"({"appenders":{"console":{"out-stream":"stdout"}},"loggers":[{"name":"root","level":"INFO","appenders":["console"]}]})";
+    EXPECT_EQ(log4cpp::config::MAX_LINE_SIZE_DEFAULT, log4cpp::config::log4cpp::deserialize(default_json).max_line_size);
+    constexpr const char *sized_json =
+        R"({"max-line-size":"64KB","appenders":{"console":{"out-stream":"stdout"}},"loggers":[{"name":"root","level":"INFO","appenders":["console"]}]})";
+    const log4cpp::config::log4cpp cfg = log4cpp::config::log4cpp::deserialize(sized_json);
+    EXPECT_EQ(64U * 1024, cfg.max_line_size);
+    EXPECT_EQ(cfg, log4cpp::config::log4cpp::deserialize(log4cpp::config::log4cpp::serialize(cfg)));
+    constexpr const char *bad_json =
+        R"({"max-line-size":100,"appenders":{"console":{"out-stream":"stdout"}},"loggers":[{"name":"root","level":"INFO","appenders":["console"]}]})";
+    EXPECT_THROW(log4cpp::config::log4cpp::deserialize(bad_json), log4cpp::config::invalid_config_exception);
+}
+
+TEST(load_config_test, clock_source) {
+    constexpr const char *default_json =
+        R"({"appenders":{"console":{"out-stream":"stdout"}},"loggers":[{"name":"root","level":"INFO","appenders":["console"]}]})";
+    EXPECT_EQ(log4cpp::config::clock_source::SYSTEM, log4cpp::config::log4cpp::deserialize(default_json).clock);
+    constexpr const char *tsc_json =
+        R"({"clock":"TSC","appenders":{"console":{"out-stream":"stdout"}},"loggers":[{"name":"root","level":"INFO","appenders":["console"]}]})";
+    const log4cpp::config::log4cpp cfg = log4cpp::config::log4cpp::deserialize(tsc_json);
+    EXPECT_EQ(log4cpp::config::clock_source::TSC, cfg.clock);
+    EXPECT_EQ(cfg, log4cpp::config::log4cpp::deserialize(log4cpp::config::log4cpp::serialize(cfg)));
+    constexpr const char *bad_json =
+        R"({"clock":"hpet","appenders":{"console":{"out-stream":"stdout"}},"loggers":[{"name":"root","level":"INFO","appenders":["console"]}]})";
+    EXPECT_THROW(log4cpp::config::log4cpp::deserialize(bad_json), log4cpp::config::invalid_config_exception);
+}
+
+TEST(load_config_test, socket_send_buffer_size) {
+    constexpr const char *default_json =
+        R"({"appenders":{"socket":{"host":"localhost","port":1234,"protocol":"tcp","prefer-stack":"auto"}},"loggers":[{"name":"root","level":"INFO","appenders":["socket"]}]})";
+    EXPECT_EQ(log4cpp::config::SOCKET_SEND_BUFFER_SIZE_DEFAULT,
+              log4cpp::config::log4cpp::deserialize(default_json).appenders.socket->send_buffer_size);
+    constexpr const char *sized_json =
+        R"({"appenders":{"socket":{"host":"localhost","port":1234,"protocol":"tcp","prefer-stack":"auto","send-buffer-size":"4MB"}},"loggers":[{"name":"root","level":"INFO","appenders":["socket"]}]})";
+    const log4cpp::config::log4cpp cfg = log4cpp::config::log4cpp::deserialize(sized_json);
+    EXPECT_EQ(4U * 1024 * 1024, cfg.appenders.socket->send_buffer_size);
+    EXPECT_EQ(cfg, log4cpp::config::log4cpp::deserialize(log4cpp::config::log4cpp::serialize(cfg)));
+    constexpr const char *bad_json =
+        R"({"appenders":{"socket":{"host":"localhost","port":1234,"protocol":"tcp","prefer-stack":"auto","send-buffer-size":16}},"loggers":[{"name":"root","level":"INFO","appenders":["socket"]}]})";
+    EXPECT_THROW(log4cpp::config::log4cpp::deserialize(bad_json), log4cpp::config::invalid_config_exception);
+}
+
+TEST(load_config_test, socket_framing) {
+    constexpr const char *default_json =
+        R"({"appenders":{"socket":{"host":"localhost","port":1234,"protocol":"tcp","prefer-stack":"auto"}},"loggers":[{"name":"root","level":"INFO","appenders":["socket"]}]})";
+    EXPECT_EQ(log4cpp::config::framing::NONE,
+              log4cpp::config::log4cpp::deserialize(default_json).appenders.socket->frame);
+    constexpr const char *framed_json =
+        R"({"appenders":{"socket":{"host":"localhost","port":1234,"protocol":"tcp","prefer-stack":"auto","framing":"Octet-Counting"}},"loggers":[{"name":"root","level":"INFO","appenders":["socket"]}]})";
+    const log4cpp::config::log4cpp cfg = log4cpp::config::log4cpp::deserialize(framed_json);
+    EXPECT_EQ(log4cpp::config::framing::OCTET_COUNTING, cfg.appenders.socket->frame);
+    EXPECT_EQ(cfg, log4cpp::config::log4cpp::deserialize(log4cpp::config::log4cpp::serialize(cfg)));
+    constexpr const char *bad_json =
+        R"({"appenders":{"socket":{"host":"localhost","port":1234,"protocol":"tcp","prefer-stack":"auto","framing":"netstring"}},"loggers":[{"name":"root","level":"INFO","appenders":["socket"]}]})";
+    EXPECT_THROW(log4cpp::config::log4cpp::deserialize(bad_json), log4cpp::config::invalid_config_exception);
+}
+
+TEST(load_config_test, socket_udp_batching) {
+    constexpr const char *batched_json =
+        R"({"appenders":{"socket":{"host":"localhost","port":1234,"protocol":"udp","prefer-stack":"auto","flush-interval-ms":5,"datagram-size":"1400"}},"loggers":[{"name":"root","level":"INFO","appenders":["socket"]}]})";
+    const log4cpp::config::log4cpp cfg = log4cpp::config::log4cpp::deserialize(batched_json);
+    EXPECT_EQ(5U, cfg.appenders.socket->flush_interval_ms);
+    EXPECT_EQ(1400U, cfg.appenders.socket->datagram_size);
+    EXPECT_EQ(cfg, log4cpp::config::log4cpp::deserialize(log4cpp::config::log4cpp::serialize(cfg)));
+    constexpr const char *bad_json =
+        R"({"appenders":{"socket":{"host":"localhost","port":1234,"protocol":"udp","prefer-stack":"auto","datagram-size":"64KB"}},"loggers":[{"name":"root","level":"INFO","appenders":["socket"]}]})";
+    EXPECT_THROW(log4cpp::config::log4cpp::deserialize(bad_json), log4cpp::config::invalid_config_exception);
+}
+
+TEST(load_config_test, socket_spill_file) {
+    constexpr const char *spill_json =
+        R"({"appenders":{"socket":{"host":"localhost","port":1234,"protocol":"tcp","prefer-stack":"auto","spill-file":"/tmp/app.spill","spill-size":"16MB","replay-rate":"256KB"}},"loggers":[{"name":"root","level":"INFO","appenders":["socket"]}]})";
+    const log4cpp::config::log4cpp cfg = log4cpp::config::log4cpp::deserialize(spill_json);
+    EXPECT_EQ("/tmp/app.spill", cfg.appenders.socket->spill_file);
+    EXPECT_EQ(16U * 1024 * 1024, cfg.appenders.socket->spill_size);
+    EXPECT_EQ(256U * 1024, cfg.appenders.socket->replay_rate);
+    EXPECT_EQ(cfg, log4cpp::config::log4cpp::deserialize(log4cpp::config::log4cpp::serialize(cfg)));
+    constexpr const char *bad_json =
+        R"({"appenders":{"socket":{"host":"localhost","port":1234,"protocol":"tcp","prefer-stack":"auto","spill-file":"/tmp/app.spill","replay-rate":0}},"loggers":[{"name":"root","level":"INFO","appenders":["socket"]}]})";
+    EXPECT_THROW(log4cpp::config::log4cpp::deserialize(bad_json), log4cpp::config::invalid_config_exception);
+}
+
+TEST(load_config_test, socket_endpoints) {
+    constexpr const char *endpoints_json =
+        R"({"appenders":{"socket":{"endpoints":[{"host":"10.0.0.1","port":514},{"host":"10.0.0.2","port":601}],"balance":"Hash-By-Logger","protocol":"tcp","prefer-stack":"auto"}},"loggers":[{"name":"root","level":"INFO","appenders":["socket"]}]})";
+    const log4cpp::config::log4cpp cfg = log4cpp::config::log4cpp::deserialize(endpoints_json);
+    ASSERT_EQ(2U, cfg.appenders.socket->endpoints.size());
+    EXPECT_EQ("10.0.0.2", cfg.appenders.socket->endpoints[1].host);
+    EXPECT_EQ(601, cfg.appenders.socket->endpoints[1].port);
+    EXPECT_EQ("10.0.0.1", cfg.appenders.socket->host);
+    EXPECT_EQ(514, cfg.appenders.socket->port);
+    EXPECT_EQ(log4cpp::config::balance_policy::HASH_BY_LOGGER, cfg.appenders.socket->balance);
+    EXPECT_EQ(cfg, log4cpp::config::log4cpp::deserialize(log4cpp::config::log4cpp::serialize(cfg)));
+    // A single endpoint is the same as host and port
+    constexpr const char *single_json =
+        R"({"appenders":{"socket":{"endpoints":[{"host":"localhost","port":1234}],"protocol":"tcp","prefer-stack":"auto"}},"loggers":[{"name":"root","level":"INFO","appenders":["socket"]}]})";
+    constexpr const char *host_json =
+        R"({"appenders":{"socket":{"host":"localhost","port":1234,"protocol":"tcp","prefer-stack":"auto"}},"loggers":[{"name":"root","level":"INFO","appenders":["socket"]}]})";
+    EXPECT_EQ(log4cpp::config::log4cpp::deserialize(host_json), log4cpp::config::log4cpp::deserialize(single_json));
+    constexpr const char *empty_json =
+        R"({"appenders":{"socket":{"endpoints":[],"protocol":"tcp","prefer-stack":"auto"}},"loggers":[{"name":"root","level":"INFO","appenders":["socket"]}]})";
+    EXPECT_THROW(log4cpp::config::log4cpp::deserialize(empty_json), log4cpp::config::invalid_config_exception);
+    constexpr const char *bad_json =
+        R"({"appenders":{"socket":{"endpoints":[{"host":"10.0.0.1","port":514},{"host":"10.0.0.2","port":601}],"balance":"random","protocol":"tcp","prefer-stack":"auto"}},"loggers":[{"name":"root","level":"INFO","appenders":["socket"]}]})";
+    EXPECT_THROW(log4cpp::config::log4cpp::deserialize(bad_json), log4cpp::config::invalid_config_exception);
+}
@@ -0,0 +1,107 @@
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#ifndef _WIN32
+#include <pthread.h>
+#include <time.h>
+#endif
+
+#include <gtest/gtest.h>
+
+#include "common/log_lock.hpp"
+
+TEST(log_lock_test, mutual_exclusion_test) {
+    log4cpp::common::log_lock lock;
+    constexpr int THREADS = 8;
+    constexpr int ROUNDS = 100000;
+    long counter = 0;
+    std::vector<std::thread> threads;
+    for (int i = 0; i < THREADS; ++i) {
+        threads.emplace_back([&] {
+            for (int j = 0; j < ROUNDS; ++j) {
+                std::lock_guard guard(lock);
+                ++counter;
+            }
+        });
+    }
+    for (auto &t: threads) {
+        t.join();
+    }
+    EXPECT_EQ(static_cast<long>(THREADS) * ROUNDS, counter);
+}
+
+#ifndef _WIN32
+namespace {
+    class pthread_spin final {
+    public:
+        pthread_spin() {
+            pthread_spin_init(&spin, PTHREAD_PROCESS_PRIVATE);
+        }
+
+        ~pthread_spin() {
+            pthread_spin_destroy(&spin);
+        }
+
+        pthread_spin(const pthread_spin &other) = delete;
+
+        pthread_spin &operator=(const pthread_spin &other) = delete;
+
+        void lock() {
+            pthread_spin_lock(&spin);
+        }
+
+        void unlock() {
+            pthread_spin_unlock(&spin);
+        }
+
+    private:
+        pthread_spinlock_t spin{};
+    };
+
+    double cpu_seconds() {
+        timespec ts{};
+        clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+        return static_cast<double>(ts.tv_sec) + static_cast<double>(ts.tv_nsec) / 1e9;
+    }
+
+    /**
+     * @brief Threads take turns on the lock, the holder sleeps as if blocked writing to a slow sink.
+     * @return CPU seconds the process used, over the wall seconds in wall
+     */
+    template<typename LOCK>
+    double slow_sink_cpu(double &wall) {
+        constexpr int THREADS = 4;
+        constexpr int ROUNDS = 25;
+        LOCK lock;
+        const auto start = std::chrono::steady_clock::now();
+        const double cpu_start = cpu_seconds();
+        std::vector<std::thread> threads;
+        for (int i = 0; i < THREADS; ++i) {
+            threads.emplace_back([&lock] {
+                for (int j = 0; j < ROUNDS; ++j) {
+                    std::lock_guard guard(lock);
+                    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+                }
+            });
+        }
+        for (auto &t: threads) {
+            t.join();
+        }
+        wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        return cpu_seconds() - cpu_start;
+    }
+} // namespace
+
+TEST(log_lock_test, slow_sink_cpu_test) {
+    double spin_wall = 0;
+    const double spin_cpu = slow_sink_cpu<pthread_spin>(spin_wall);
+    double lock_wall = 0;
+    const double lock_cpu = slow_sink_cpu<log4cpp::common::log_lock>(lock_wall);
+    // The waiters sleep while the holder is in the sink, the process is idle most of the time
+    EXPECT_LT(lock_cpu, lock_wall / 4);
+    // Spinning waiters burn a core each for the same wall time
+    EXPECT_LT(lock_cpu, spin_cpu) << "spinlock: cpu " << spin_cpu << "s, wall " << spin_wall << "s";
+}
+#endif
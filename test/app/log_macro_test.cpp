@@ -0,0 +1,60 @@
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+// Strip TRACE in this file, as a release build configured with LOG4CPP_ACTIVE_LEVEL=DEBUG would
+#undef LOG4CPP_ACTIVE_LEVEL
+#define LOG4CPP_ACTIVE_LEVEL LOG4CPP_LEVEL_DEBUG
+#include "log4cpp/log4cpp.hpp"
+
+#include "appender/log_appender.hpp"
+#include "logger/real_logger.hpp"
+
+#include "../include/log4cpp_test.h"
+
+TEST(log_macro_tests, arguments_evaluated_only_when_enabled) {
+    auto appender = std::make_shared<capture_appender>();
+    auto real = std::make_shared<log4cpp::real_logger>("macro", log4cpp::log_level::INFO, "${msg}");
+    real->add_appender(appender);
+    const std::shared_ptr<log4cpp::logger> log = real;
+
+    int evaluated = 0;
+    auto next = [&evaluated] { return ++evaluated; };
+
+    LOG4CPP_INFO(log, "info %d", next());
+    LOG4CPP_ERROR(log, LOG4CPP_FMT("error {}"), next());
+    // Disabled at run time, the level is checked before the arguments
+    LOG4CPP_DEBUG(log, "debug %d", next());
+    EXPECT_EQ(2, evaluated);
+
+    log->set_level(log4cpp::log_level::TRACE);
+    LOG4CPP_DEBUG(log, LOG4CPP_FMT("debug {}"), next());
+    // Stripped at compile time, whatever the logger's level
+    LOG4CPP_TRACE(log, "trace %d", next());
+    EXPECT_EQ(3, evaluated);
+
+    ASSERT_EQ(3U, appender->lines.size());
+    EXPECT_EQ("info 1\n", appender->lines[0]);
+    EXPECT_EQ("error 2\n", appender->lines[1]);
+    EXPECT_EQ("debug 3\n", appender->lines[2]);
+}
+
+TEST(log_macro_tests, statement_form) {
+    auto appender = std::make_shared<capture_appender>();
+    auto real = std::make_shared<log4cpp::real_logger>("macro", log4cpp::log_level::WARN, "${msg}");
+    real->add_appender(appender);
+
+    // The macros are single statements, safe in an unbraced if/else
+    const bool failed = true;
+    if (failed)
+        LOG4CPP_WARN(real, "failed");
+    else
+        LOG4CPP_INFO(real, "succeeded");
+    LOG4CPP_FATAL(real.get(), "raw pointer");
+
+    ASSERT_EQ(2U, appender->lines.size());
+    EXPECT_EQ("failed\n", appender->lines[0]);
+    EXPECT_EQ("raw pointer\n", appender->lines[1]);
+}
@@ -1,4 +1,7 @@
+#include <cctype>
+#include <cstring>
 #include <filesystem>
+#include <thread>
 
 #ifdef __GNUC__
 
@@ -445,6 +448,102 @@ TEST(log_pattern_tests, thread_id_format_test) {
     LOG4C_EXPECT_STR_EQ(actual + offset, expected + offset, "Thread name or id format mismatch");
 }
 
+TEST(log_pattern_tests, thread_name_cache_test) {
+    std::thread worker([] {
+        log4cpp::pattern::log_pattern formatter("[${16TN}] ${msg}");
+        char actual[128];
+        const log4cpp::common::thread_identity &identity = log4cpp::common::current_thread_identity();
+        // Each thread has its own cache, a new thread has no name yet
+        if ('\0' == identity.name[0]) {
+            formatter.format(actual, sizeof(actual), "TEST", log4cpp::log_level::INFO, "unnamed");
+            EXPECT_EQ('T', actual[1]);
+        }
+        // Renaming drops the cached name
+        log4cpp::set_thread_name("cache_first");
+        formatter.format(actual, sizeof(actual), "TEST", log4cpp::log_level::INFO, "one");
+        LOG4C_EXPECT_STR_EQ("[cache_first     ] one\n", actual, "Thread name after the first rename");
+        log4cpp::set_thread_name("cache_second");
+        formatter.format(actual, sizeof(actual), "TEST", log4cpp::log_level::INFO, "two");
+        LOG4C_EXPECT_STR_EQ("[cache_second    ] two\n", actual, "Thread name after the second rename");
+        char name[16];
+        const unsigned long tid = log4cpp::get_thread_name_id(name, sizeof(name));
+        EXPECT_STREQ("cache_second", name);
+        EXPECT_EQ(identity.id, tid);
+        // A short buffer gets a truncated, NUL-terminated name
+        char short_name[6];
+        log4cpp::get_thread_name_id(short_name, sizeof(short_name));
+        EXPECT_STREQ("cache", short_name);
+    });
+    worker.join();
+}
+
+TEST(log_pattern_tests, compile_pattern_test) {
+    const auto segments = log4cpp::pattern::compile_pattern("${yyyy}-${MM} ${hh}:${mm} [${12TN}] ${foo} ${msg}");
+    std::vector<log4cpp::pattern::segment_type> types;
+    for (const auto &segment: segments) {
+        types.push_back(segment.type);
+    }
+    using log4cpp::pattern::segment_type;
+    const std::vector<segment_type> expected = {
+        segment_type::FULL_YEAR,    segment_type::LITERAL,      segment_type::FULL_MONTH, segment_type::LITERAL,
+        segment_type::FULL_12HOUR,  segment_type::LITERAL,      segment_type::FULL_MINUTES,
+        segment_type::MERIDIEM,     segment_type::LITERAL,      segment_type::THREAD_NAME,
+        segment_type::LITERAL,      segment_type::LOG_MESSAGE};
+    EXPECT_EQ(types, expected);
+    EXPECT_EQ(segments[9].width, 12U);
+    // Unknown placeholders are kept verbatim
+    EXPECT_EQ(segments[10].text, "] ${foo} ");
+}
+
+TEST(log_pattern_tests, repeated_placeholder_test) {
+    log4cpp::pattern::log_pattern formatter("${L}|${L}|${3NM}|${msg}|${msg}");
+    char actual[128];
+    const size_t len = formatter.format(actual, sizeof(actual), "TEST", log4cpp::log_level::WARN, "%d", 42);
+    LOG4C_EXPECT_STR_EQ("WARN |WARN |TES|42|42\n", actual, "Repeated placeholder format mismatch");
+    EXPECT_EQ(len, strlen(actual));
+}
+
+TEST(log_pattern_tests, small_buffer_keeps_newline_test) {
+    log4cpp::pattern::log_pattern formatter("[${L}] ${msg}");
+    char actual[8];
+    const size_t len = formatter.format(actual, sizeof(actual), "TEST", log4cpp::log_level::INFO, "hello");
+    LOG4C_EXPECT_STR_EQ("[INFO \n", actual, "Truncated line must end with a newline");
+    EXPECT_EQ(len, strlen(actual));
+}
+
+TEST(log_pattern_tests, cached_timestamp_test) {
+    // Two patterns formatted alternately on one thread must not see each other's cached date/time prefix
+    log4cpp::pattern::log_pattern day_formatter("${yyyy}-${MM}-${dd} ${HH}:${mm}:${ss} ${msg}");
+    log4cpp::pattern::log_pattern time_formatter("[${L}] ${hh}:${mm}:${ss}.${ms} ${msg}");
+    for (int i = 0; i < 16; ++i) {
+        tm before_tm{};
+        tm after_tm{};
+        unsigned short ms;
+        char day_actual[128];
+        char time_actual[128];
+        log4cpp::common::get_time_now(before_tm, ms);
+        day_formatter.format(day_actual, sizeof(day_actual), "TEST", log4cpp::log_level::INFO, "day");
+        time_formatter.format(time_actual, sizeof(time_actual), "TEST", log4cpp::log_level::INFO, "time");
+        log4cpp::common::get_time_now(after_tm, ms);
+        if (before_tm.tm_sec != after_tm.tm_sec) {
+            continue;
+        }
+        char expected[128];
+        log4cpp::pattern::format_daytime(expected, sizeof(expected), "${yyyy}-${MM}-${dd} ${HH}:${mm}:${ss} day\n",
+                                         before_tm, 0);
+        EXPECT_STREQ(day_actual, expected);
+        const int hour_12 = before_tm.tm_hour > 12 ? before_tm.tm_hour - 12 : before_tm.tm_hour;
+        log4cpp::common::log4c_scnprintf(expected, sizeof(expected), "[INFO ] %02d:%02d:%02d.", hour_12,
+                                         before_tm.tm_min, before_tm.tm_sec);
+        EXPECT_EQ(0, std::strncmp(time_actual, expected, std::strlen(expected)));
+        const char *suffix = before_tm.tm_hour < 12 ? " AM time\n" : " PM time\n";
+        const size_t ms_pos = std::strlen(expected);
+        EXPECT_TRUE(std::isdigit(time_actual[ms_pos]) && std::isdigit(time_actual[ms_pos + 1]) &&
+                    std::isdigit(time_actual[ms_pos + 2]));
+        EXPECT_STREQ(time_actual + ms_pos + 3, suffix);
+    }
+}
+
 struct log_level_format_param {
     log4cpp::log_level level;
     const char *name;
@@ -1,11 +1,30 @@
 #include <gtest/gtest.h>
 
+#include <cstdarg>
 #include <cstring>
+#include <memory>
 #include <string>
+#include <thread>
+#include <vector>
 
 #include <log4cpp/log4cpp.hpp>
+#include "appender/log_appender.hpp"
+#include "async/async_dispatcher.hpp"
+#include "common/line_writer.hpp"
+#include "logger/real_logger.hpp"
 #include "pattern/log_pattern.hpp"
 
+#include "../include/log4cpp_test.h"
+
+size_t format_printf(const log4cpp::pattern::log_pattern &formatter, log4cpp::common::line_writer &writer,
+                     const char *fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    const size_t used_len = formatter.format(writer, "grow", log4cpp::log_level::INFO, fmt, args);
+    va_end(args);
+    return used_len;
+}
+
 TEST(log_truncate_tests, pattern_format_does_not_overflow_on_long_message) {
     char buf[2048];
     // Construct a message far exceeding LOG_LINE_MAX (512)
@@ -22,25 +41,109 @@ TEST(log_truncate_tests, pattern_format_does_not_overflow_on_long_message) {
     EXPECT_EQ(buf[used_len], '\0');
 }
 
-TEST(log_truncate_tests, message_content_is_truncated_to_log_line_max) {
-    char buf[2048];
-    // The raw message is 600 'A's; after formatting it should be truncated
-    // to at most LOG_LINE_MAX - 1 characters (vsnprintf reserves one for '\0')
-    const std::string long_msg(600, 'A');
+TEST(log_truncate_tests, message_longer_than_log_line_max_is_kept) {
+    // The message is no longer cut at LOG_LINE_MAX, only the buffer bounds the line
+    char buf[4096];
+    const std::string long_msg(2 * log4cpp::LOG_LINE_MAX, 'A');
 
     log4cpp::pattern::log_pattern formatter;
-    formatter.format(buf, sizeof(buf), "test", log4cpp::log_level::WARN, long_msg.c_str());
+    formatter.format(buf, sizeof(buf), "test", log4cpp::log_level::WARN, "%s", long_msg.c_str());
 
-    // The formatted buffer should not contain the full 600 'A's
     const char *msg_start = std::strstr(buf, " -- ");
     ASSERT_NE(msg_start, nullptr);
     msg_start += 4; // skip " -- "
+    EXPECT_EQ(long_msg + "\n", msg_start);
+}
 
-    size_t msg_len = std::strlen(msg_start);
-    // Remove trailing '\n' for the count
-    if (msg_len > 0 && msg_start[msg_len - 1] == '\n') {
-        --msg_len;
-    }
+TEST(log_truncate_tests, line_is_truncated_to_buffer) {
+    char buf[64];
+    const std::string long_msg(200, 'B');
+    log4cpp::pattern::log_pattern formatter("${msg}");
+    const size_t used_len = formatter.format(buf, sizeof(buf), "test", log4cpp::log_level::WARN, "%s",
+                                             long_msg.c_str());
+    EXPECT_EQ(sizeof(buf) - 1, used_len);
+    EXPECT_EQ(std::string(sizeof(buf) - 2, 'B') + "\n", buf);
+}
+
+TEST(log_truncate_tests, vector_writer_grows_for_long_message) {
+    const std::string long_msg(5000, 'G');
+    log4cpp::pattern::log_pattern formatter("${msg}");
+    std::vector<char> buffer(64);
+    log4cpp::common::line_writer writer(buffer);
+    const size_t used_len = format_printf(formatter, writer, "[%s]", long_msg.c_str());
+    EXPECT_EQ("[" + long_msg + "]\n", std::string(buffer.data(), used_len));
+    EXPECT_EQ('\0', buffer[used_len]);
+}
 
-    EXPECT_LE(msg_len, log4cpp::LOG_LINE_MAX - 1) << "Message portion should be truncated to fit LOG_LINE_MAX";
+TEST(log_truncate_tests, repeated_message_longer_than_buffer) {
+    // The buffer grows while printing the first ${msg}, the second one prints from the same arguments
+    const std::string long_msg(2 * log4cpp::LOG_LINE_MAX, 'R');
+    log4cpp::pattern::log_pattern formatter("${msg}|${msg}");
+    std::vector<char> buffer(64);
+    log4cpp::common::line_writer writer(buffer);
+    const size_t used_len = format_printf(formatter, writer, "%s:%d", long_msg.c_str(), 7);
+    EXPECT_EQ(long_msg + ":7|" + long_msg + ":7\n", std::string(buffer.data(), used_len));
+}
+
+TEST(log_truncate_tests, logger_writes_long_lines_whole) {
+    auto appender = std::make_shared<capture_appender>();
+    auto real = std::make_shared<log4cpp::real_logger>("long", log4cpp::log_level::INFO, "${msg}");
+    real->add_appender(appender);
+    const std::shared_ptr<log4cpp::logger> log = real;
+    const std::string trace(3 * log4cpp::LOG_LINE_MAX, 'S');
+    log->info("%s", trace.c_str());
+    log->info(LOG4CPP_FMT("{}|{}"), trace, trace);
+    log->info("short");
+    ASSERT_EQ(3U, appender->lines.size());
+    EXPECT_EQ(trace + "\n", appender->lines[0]);
+    EXPECT_EQ(trace + "|" + trace + "\n", appender->lines[1]);
+    EXPECT_EQ("short\n", appender->lines[2]);
+}
+
+TEST(log_truncate_tests, logger_truncates_at_max_line_size) {
+    auto appender = std::make_shared<capture_appender>();
+    auto real = std::make_shared<log4cpp::real_logger>("long", log4cpp::log_level::INFO, "${msg}");
+    real->add_appender(appender);
+    real->set_max_line_size(2 * log4cpp::LOG_LINE_MAX);
+    const std::shared_ptr<log4cpp::logger> log = real;
+    const std::string huge(5 * log4cpp::LOG_LINE_MAX, 'H');
+    log->info("%s", huge.c_str());
+    log->info(LOG4CPP_FMT("{}"), huge);
+    ASSERT_EQ(2U, appender->lines.size());
+    const std::string expected = std::string(2 * log4cpp::LOG_LINE_MAX - 1, 'H') + "\n";
+    EXPECT_EQ(expected, appender->lines[0]);
+    EXPECT_EQ(expected, appender->lines[1]);
+}
+
+TEST(log_truncate_tests, async_logger_queues_long_lines_whole) {
+    for (const bool deferred: {false, true}) {
+        log4cpp::config::async_mode cfg;
+        cfg.queue_size = 8;
+        cfg.deferred_format = deferred;
+        auto dispatcher = std::make_shared<log4cpp::async::async_dispatcher>(cfg);
+        auto appender = std::make_shared<capture_appender>();
+        log4cpp::real_logger log("long", log4cpp::log_level::INFO, "${msg}");
+        log.add_appender(appender);
+        log.set_dispatcher(dispatcher);
+
+        const std::string trace(20 * log4cpp::LOG_LINE_MAX, 'Q');
+        std::thread producer([&log, &trace] {
+            for (int i = 0; i < 50; ++i) {
+                log.info("%d %s", i, trace.c_str());
+                log.info(LOG4CPP_FMT("{} {:>1000} {:>1000}"), i, "a", "b");
+                log.info("short %d", i);
+            }
+        });
+        producer.join();
+        dispatcher->shutdown();
+
+        ASSERT_EQ(150U, appender->lines.size());
+        for (int i = 0; i < 50; ++i) {
+            const std::string index = std::to_string(i);
+            EXPECT_EQ(index + " " + trace + "\n", appender->lines[3 * i]);
+            const std::string pad(999, ' ');
+            EXPECT_EQ(index + " " + pad + "a " + pad + "b\n", appender->lines[3 * i + 1]);
+            EXPECT_EQ("short " + index + "\n", appender->lines[3 * i + 2]);
+        }
+    }
 }
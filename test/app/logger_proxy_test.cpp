@@ -0,0 +1,42 @@
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "log4cpp/log4cpp.hpp"
+#include "log4cpp/logger.hpp"
+
+#include "appender/log_appender.hpp"
+#include "logger/real_logger.hpp"
+
+#include "../include/log4cpp_test.h"
+
+TEST(logger_proxy_tests, cached_level_follows_set_level) {
+    auto appender = std::make_shared<capture_appender>();
+    auto real = std::make_shared<log4cpp::real_logger>("proxy", log4cpp::log_level::INFO, "${msg}");
+    real->add_appender(appender);
+    log4cpp::logger_proxy proxy(real);
+    EXPECT_EQ(log4cpp::log_level::INFO, proxy.get_level());
+
+    proxy.debug("dropped %d", 1);
+    proxy.debug(LOG4CPP_FMT("dropped {}"), 2);
+    proxy.info("kept %d", 3);
+    ASSERT_EQ(1U, appender->lines.size());
+
+    proxy.set_level(log4cpp::log_level::DEBUG);
+    EXPECT_EQ(log4cpp::log_level::DEBUG, proxy.get_level());
+    EXPECT_EQ(log4cpp::log_level::DEBUG, real->get_level());
+    proxy.debug(LOG4CPP_FMT("kept {}"), 4);
+    proxy.trace("dropped %d", 5);
+
+    proxy.set_level(log4cpp::log_level::ERROR);
+    proxy.warn("dropped %d", 6);
+    proxy.log(log4cpp::log_level::INFO, LOG4CPP_FMT("dropped {}"), 7);
+    proxy.error("kept %d", 8);
+
+    ASSERT_EQ(3U, appender->lines.size());
+    EXPECT_EQ("kept 3\n", appender->lines[0]);
+    EXPECT_EQ("kept 4\n", appender->lines[1]);
+    EXPECT_EQ("kept 8\n", appender->lines[2]);
+}
@@ -0,0 +1,82 @@
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "common/rcu.hpp"
+
+namespace rcu = log4cpp::common::rcu;
+
+TEST(rcu_test, synchronize_without_readers_test) {
+    rcu::synchronize();
+    {
+        // Nested sections end with the outermost one
+        rcu::read_guard outer;
+        rcu::read_guard inner;
+    }
+    rcu::synchronize();
+}
+
+TEST(rcu_test, synchronize_waits_for_reader_test) {
+    std::atomic<bool> entered{false};
+    std::atomic<bool> leave{false};
+    std::atomic<bool> synchronized{false};
+    std::thread reader([&] {
+        rcu::read_guard guard;
+        entered = true;
+        while (!leave) {
+            std::this_thread::yield();
+        }
+    });
+    while (!entered) {
+        std::this_thread::yield();
+    }
+    std::thread writer([&] {
+        rcu::synchronize();
+        synchronized = true;
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    EXPECT_FALSE(synchronized);
+    leave = true;
+    reader.join();
+    writer.join();
+    EXPECT_TRUE(synchronized);
+}
+
+TEST(rcu_test, reader_never_sees_freed_object_test) {
+    constexpr int MAGIC = 0x5a5a5a5a;
+    struct object {
+        std::atomic<int> magic{MAGIC};
+    };
+    std::atomic<object *> current{new object()};
+    std::atomic<bool> stop{false};
+    std::atomic<long> bad{0};
+
+    std::vector<std::thread> readers;
+    for (int i = 0; i < 4; ++i) {
+        readers.emplace_back([&] {
+            while (!stop) {
+                rcu::read_guard guard;
+                const object *obj = current.load(std::memory_order_acquire);
+                if (obj->magic.load(std::memory_order_relaxed) != MAGIC) {
+                    ++bad;
+                }
+            }
+        });
+    }
+    for (int i = 0; i < 1000; ++i) {
+        object *old = current.exchange(new object(), std::memory_order_seq_cst);
+        rcu::synchronize();
+        // Poison before freeing, a reader still holding it would see the change
+        old->magic = 0;
+        delete old;
+    }
+    stop = true;
+    for (auto &t: readers) {
+        t.join();
+    }
+    delete current.load();
+    EXPECT_EQ(0, bad.load());
+}
@@ -1,5 +1,6 @@
 #include <filesystem>
 #include <thread>
+#include <vector>
 
 #ifdef _WIN32
 #include <WS2tcpip.h>
@@ -11,6 +12,7 @@
 
 #include <arpa/inet.h>
 #include <netinet/in.h>
+#include <poll.h>
 #include <sys/socket.h>
 
 #endif
@@ -24,6 +26,9 @@ typedef SSIZE_T ssize_t;
 
 #include "log4cpp/log4cpp.hpp"
 
+#include "appender/balanced_socket_appender.hpp"
+#include "appender/socket_appender.hpp"
+#include "appender/spill_file.hpp"
 #include "common/log_net.hpp"
 #include "config/log4cpp.hpp"
 
@@ -420,3 +425,537 @@ TEST_F(socket_appender_test, udp_socket_appender_test) {
     ASSERT_NE(status->state.load(), server_status::state::FAILED) << status->error_message;
     ASSERT_EQ(expected_log_count, received_count);
 }
+
+#ifndef _WIN32
+class loopback_peer {
+public:
+    log4cpp::common::socket_fd server_fd{log4cpp::common::INVALID_FD};
+    log4cpp::common::socket_fd client_fd{log4cpp::common::INVALID_FD};
+    std::unique_ptr<log4cpp::appender::socket_appender> appender;
+
+    ~loopback_peer() {
+        appender.reset();
+        log4cpp::common::close_socket(client_fd);
+        log4cpp::common::close_socket(server_fd);
+    }
+
+    /**
+     * Listen on an ephemeral loopback port, point a TCP appender at it and log probe records until one arrives,
+     * records are dropped until the appender sees the connection established. Nothing is left to read on return.
+     */
+    bool connect(log4cpp::config::socket_appender &cfg) {
+        server_fd = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+        sockaddr_in local_addr{};
+        local_addr.sin_family = AF_INET;
+        local_addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        socklen_t addr_len = sizeof(local_addr);
+        if (log4cpp::common::INVALID_FD == server_fd ||
+            bind(server_fd, reinterpret_cast<sockaddr *>(&local_addr), addr_len) != 0 || listen(server_fd, 1) != 0 ||
+            getsockname(server_fd, reinterpret_cast<sockaddr *>(&local_addr), &addr_len) != 0) {
+            return false;
+        }
+        cfg.host = "127.0.0.1";
+        cfg.port = ntohs(local_addr.sin_port);
+        cfg.proto = log4cpp::config::socket_appender::protocol::TCP;
+        cfg.prefer = log4cpp::common::prefer_stack::IPv4;
+        appender = std::make_unique<log4cpp::appender::socket_appender>(cfg);
+        client_fd = accept(server_fd, nullptr, nullptr);
+        if (log4cpp::common::INVALID_FD == client_fd) {
+            return false;
+        }
+        set_socket_recv_timeout(client_fd);
+        const char probe[] = "probe\n";
+        for (int i = 0; i < 50; ++i) {
+            appender->log(probe, sizeof(probe) - 1);
+            if (readable(100)) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(100));
+                char buffer[4096];
+                while (readable(0) && recv(client_fd, buffer, sizeof(buffer), 0) > 0) {
+                }
+                return true;
+            }
+        }
+        return false;
+    }
+
+    [[nodiscard]] bool readable(int timeout_ms) const {
+        pollfd pfd{client_fd, POLLIN, 0};
+        return poll(&pfd, 1, timeout_ms) > 0;
+    }
+
+    /**
+     * Read until nothing arrives for 200 ms
+     */
+    [[nodiscard]] std::string receive() const {
+        std::string received;
+        char buffer[4096];
+        while (readable(200)) {
+            const ssize_t len = recv(client_fd, buffer, sizeof(buffer), 0);
+            if (len <= 0) {
+                break;
+            }
+            received.append(buffer, static_cast<size_t>(len));
+        }
+        return received;
+    }
+};
+
+TEST_F(socket_appender_test, tcp_log_does_not_block_on_stalled_peer_test) {
+    log4cpp::config::socket_appender cfg;
+    cfg.send_buffer_size = 64 * 1024;
+    loopback_peer peer;
+    ASSERT_TRUE(peer.connect(cfg));
+
+    // The peer reads nothing: the socket buffers fill up, then the send queue, then records are dropped
+    const std::string line = std::string(999, 'x') + "\n";
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < 20000; ++i) {
+        peer.appender->log(line.c_str(), line.size());
+    }
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+    EXPECT_LT(elapsed, std::chrono::milliseconds(500));
+
+    // Whatever arrives is made of whole records
+    const std::string received = peer.receive();
+    size_t records = 0;
+    for (size_t pos = 0; pos < received.size();) {
+        const size_t nl = received.find('\n', pos);
+        ASSERT_NE(std::string::npos, nl);
+        EXPECT_EQ(999U, nl - pos);
+        ++records;
+        pos = nl + 1;
+    }
+    EXPECT_GT(records, 0U);
+    EXPECT_LT(records, 20000U);
+}
+
+TEST_F(socket_appender_test, tcp_length_prefix_framing_test) {
+    log4cpp::config::socket_appender cfg;
+    cfg.frame = log4cpp::config::framing::LENGTH_PREFIX;
+    loopback_peer peer;
+    ASSERT_TRUE(peer.connect(cfg));
+
+    // A record may hold newlines, the receiver finds its end from the header
+    const std::string records[] = {"stack trace:\n  at main()\n", "hello\n", std::string(70000, 'y') + "\n"};
+    for (const auto &record: records) {
+        peer.appender->log(record.c_str(), record.size());
+    }
+    const std::string received = peer.receive();
+    size_t pos = 0;
+    for (const auto &record: records) {
+        ASSERT_LE(pos + 4, received.size());
+        const auto *header = reinterpret_cast<const unsigned char *>(received.data() + pos);
+        const size_t len = static_cast<size_t>(header[0]) << 24 | static_cast<size_t>(header[1]) << 16 |
+                           static_cast<size_t>(header[2]) << 8 | header[3];
+        pos += 4;
+        ASSERT_LE(pos + len, received.size());
+        // Sent without the trailing newline
+        EXPECT_EQ(record.substr(0, record.size() - 1), received.substr(pos, len));
+        pos += len;
+    }
+    EXPECT_EQ(received.size(), pos);
+}
+
+TEST_F(socket_appender_test, tcp_octet_counting_framing_test) {
+    log4cpp::config::socket_appender cfg;
+    cfg.frame = log4cpp::config::framing::OCTET_COUNTING;
+    loopback_peer peer;
+    ASSERT_TRUE(peer.connect(cfg));
+
+    const std::string first = "<14>1 line one\n  continued\n";
+    const std::string second = "<11>1 line two\n";
+    peer.appender->log(first.c_str(), first.size());
+    peer.appender->log(second.c_str(), second.size());
+    EXPECT_EQ("26 <14>1 line one\n  continued14 <11>1 line two", peer.receive());
+}
+
+class udp_peer {
+public:
+    log4cpp::common::socket_fd server_fd{log4cpp::common::INVALID_FD};
+
+    ~udp_peer() {
+        log4cpp::common::close_socket(server_fd);
+    }
+
+    /**
+     * Bind an ephemeral loopback port and point cfg at it
+     */
+    bool bind_to(log4cpp::config::socket_appender &cfg) {
+        server_fd = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+        sockaddr_in local_addr{};
+        local_addr.sin_family = AF_INET;
+        local_addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        socklen_t addr_len = sizeof(local_addr);
+        if (log4cpp::common::INVALID_FD == server_fd ||
+            bind(server_fd, reinterpret_cast<sockaddr *>(&local_addr), addr_len) != 0 ||
+            getsockname(server_fd, reinterpret_cast<sockaddr *>(&local_addr), &addr_len) != 0) {
+            return false;
+        }
+        int rcvbuf = 8 * 1024 * 1024;
+        (void)setsockopt(server_fd, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+        cfg.host = "127.0.0.1";
+        cfg.port = ntohs(local_addr.sin_port);
+        cfg.proto = log4cpp::config::socket_appender::protocol::UDP;
+        cfg.prefer = log4cpp::common::prefer_stack::IPv4;
+        return true;
+    }
+
+    /**
+     * Receive datagrams until none arrives for 300 ms
+     */
+    [[nodiscard]] std::vector<std::string> receive() const {
+        std::vector<std::string> datagrams;
+        std::vector<char> buffer(65536);
+        pollfd pfd{server_fd, POLLIN, 0};
+        while (poll(&pfd, 1, 300) > 0) {
+            const ssize_t len = recv(server_fd, buffer.data(), buffer.size(), 0);
+            if (len < 0) {
+                break;
+            }
+            datagrams.emplace_back(buffer.data(), static_cast<size_t>(len));
+        }
+        return datagrams;
+    }
+};
+
+TEST_F(socket_appender_test, udp_batched_datagrams_test) {
+    log4cpp::config::socket_appender cfg;
+    udp_peer peer;
+    ASSERT_TRUE(peer.bind_to(cfg));
+    cfg.flush_interval_ms = 20;
+    std::string expected;
+    {
+        log4cpp::appender::socket_appender appender(cfg);
+        for (int i = 0; i < 200; ++i) {
+            const std::string record = "record " + std::to_string(i) + "\n";
+            appender.log(record.c_str(), record.size());
+            expected += record;
+        }
+    }
+    // Still one record per datagram, in order
+    const std::vector<std::string> datagrams = peer.receive();
+    ASSERT_EQ(200U, datagrams.size());
+    std::string received;
+    for (const auto &datagram: datagrams) {
+        received += datagram;
+    }
+    EXPECT_EQ(expected, received);
+}
+
+TEST_F(socket_appender_test, udp_packed_datagrams_test) {
+    log4cpp::config::socket_appender cfg;
+    udp_peer peer;
+    ASSERT_TRUE(peer.bind_to(cfg));
+    cfg.flush_interval_ms = 20;
+    cfg.datagram_size = 1400;
+    std::string expected;
+    {
+        log4cpp::appender::socket_appender appender(cfg);
+        for (int i = 0; i < 200; ++i) {
+            const std::string record = "record " + std::to_string(i) + "\n";
+            appender.log(record.c_str(), record.size());
+            expected += record;
+        }
+        // Longer than a datagram: sent in pieces of at most UDP_PAYLOAD_MAX
+        const std::string large = std::string(70000, 'z') + "\n";
+        appender.log(large.c_str(), large.size());
+        expected += large;
+    }
+    const std::vector<std::string> datagrams = peer.receive();
+    std::string received;
+    for (const auto &datagram: datagrams) {
+        EXPECT_LE(datagram.size(), log4cpp::appender::UDP_PAYLOAD_MAX);
+        received += datagram;
+    }
+    EXPECT_EQ(expected, received);
+    // About 1400 / 11 records fit in a datagram
+    EXPECT_LT(datagrams.size(), 10U);
+}
+
+TEST_F(socket_appender_test, spill_file_test) {
+    const std::string path = (std::filesystem::temp_directory_path() / "log4cpp_spill_file_test.spill").string();
+    std::filesystem::remove(path);
+    {
+        auto spill = log4cpp::appender::spill_file::open(path, 1024);
+        ASSERT_NE(nullptr, spill);
+        // The file is locked while open
+        EXPECT_EQ(nullptr, log4cpp::appender::spill_file::open(path, 1024));
+        EXPECT_TRUE(spill->empty());
+        ASSERT_TRUE(spill->push("7 ", 2, "hello\n", 6));
+        std::vector<char> out;
+        EXPECT_EQ(8U, spill->pop(out, 1024));
+        EXPECT_EQ("7 hello\n", std::string(out.begin(), out.end()));
+        EXPECT_TRUE(spill->empty());
+        // Records wrap around the end of the ring and come out whole
+        const std::string record(300, 'r');
+        for (int round = 0; round < 10; ++round) {
+            ASSERT_TRUE(spill->push("", 0, record.c_str(), record.size()));
+            ASSERT_TRUE(spill->push("", 0, record.c_str(), record.size()));
+            out.clear();
+            EXPECT_EQ(600U, spill->pop(out, 600));
+            EXPECT_EQ(record + record, std::string(out.begin(), out.end()));
+        }
+        // Full: 3 records of 300 bytes and their lengths fit in 1024 bytes, a fourth does not
+        for (int i = 0; i < 3; ++i) {
+            ASSERT_TRUE(spill->push("", 0, record.c_str(), record.size()));
+        }
+        EXPECT_FALSE(spill->push("", 0, record.c_str(), record.size()));
+        // A slice holds whole records only, and at least one
+        out.clear();
+        EXPECT_EQ(300U, spill->pop(out, 500));
+        EXPECT_EQ(300U, spill->pop(out, 10));
+    }
+    {
+        // The record left behind is still there when the file is opened again
+        auto spill = log4cpp::appender::spill_file::open(path, 1024);
+        ASSERT_NE(nullptr, spill);
+        std::vector<char> out;
+        EXPECT_EQ(300U, spill->pop(out, 1024));
+        EXPECT_TRUE(spill->empty());
+    }
+    {
+        // Another capacity starts afresh
+        auto spill = log4cpp::appender::spill_file::open(path, 2048);
+        ASSERT_NE(nullptr, spill);
+        EXPECT_TRUE(spill->empty());
+        // Peeked records stay until consumed, a record sent in part stays whole
+        ASSERT_TRUE(spill->push("", 0, "one\n", 4));
+        ASSERT_TRUE(spill->push("", 0, "two\n", 4));
+        std::vector<char> out;
+        EXPECT_EQ(8U, spill->peek(out, 1024));
+        EXPECT_EQ(16U, spill->size());
+        spill->consume(6);
+        out.clear();
+        EXPECT_EQ(4U, spill->peek(out, 1024));
+        EXPECT_EQ("two\n", std::string(out.begin(), out.end()));
+        spill->consume(4);
+        EXPECT_TRUE(spill->empty());
+    }
+    std::filesystem::remove(path);
+}
+
+TEST_F(socket_appender_test, tcp_spill_and_replay_test) {
+    const std::string path = (std::filesystem::temp_directory_path() / "log4cpp_tcp_spill_test.spill").string();
+    std::filesystem::remove(path);
+    // Bound but not listening yet: the appender's connection is refused and it backs off for a second
+    log4cpp::common::socket_fd server_fd = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    ASSERT_NE(log4cpp::common::INVALID_FD, server_fd);
+    set_reuse_addr_port(server_fd);
+    sockaddr_in local_addr{};
+    local_addr.sin_family = AF_INET;
+    local_addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t addr_len = sizeof(local_addr);
+    ASSERT_EQ(0, bind(server_fd, reinterpret_cast<sockaddr *>(&local_addr), addr_len));
+    ASSERT_EQ(0, getsockname(server_fd, reinterpret_cast<sockaddr *>(&local_addr), &addr_len));
+
+    log4cpp::config::socket_appender cfg;
+    cfg.host = "127.0.0.1";
+    cfg.port = ntohs(local_addr.sin_port);
+    cfg.prefer = log4cpp::common::prefer_stack::IPv4;
+    cfg.spill_file = path;
+    cfg.spill_size = 64 * 1024;
+    cfg.replay_rate = 4000;
+    auto appender = std::make_unique<log4cpp::appender::socket_appender>(cfg);
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    std::string expected;
+    for (int i = 0; i < 100; ++i) {
+        const std::string record = "spilled " + std::to_string(i) + "\n";
+        appender->log(record.c_str(), record.size());
+        expected += record;
+    }
+    ASSERT_EQ(0, listen(server_fd, 1));
+    log4cpp::common::socket_fd client_fd = accept(server_fd, nullptr, nullptr);
+    ASSERT_NE(log4cpp::common::INVALID_FD, client_fd);
+
+    // Replayed in order, in slices of 400 bytes every 100 ms
+    std::string received;
+    char buffer[4096];
+    std::chrono::steady_clock::time_point first;
+    std::chrono::steady_clock::time_point last;
+    pollfd pfd{client_fd, POLLIN, 0};
+    while (received.size() < expected.size() && poll(&pfd, 1, 3000) > 0) {
+        const ssize_t len = recv(client_fd, buffer, sizeof(buffer), 0);
+        if (len <= 0) {
+            break;
+        }
+        last = std::chrono::steady_clock::now();
+        if (received.empty()) {
+            first = last;
+        }
+        received.append(buffer, static_cast<size_t>(len));
+    }
+    EXPECT_EQ(expected, received);
+    EXPECT_GE(last - first, std::chrono::milliseconds(150));
+
+    appender.reset();
+    log4cpp::common::close_socket(client_fd);
+    log4cpp::common::close_socket(server_fd);
+    std::filesystem::remove(path);
+}
+
+/**
+ * Bind a TCP socket to an ephemeral loopback port, listening if listening is set
+ */
+log4cpp::common::socket_fd bind_loopback(unsigned short &port, bool listening) {
+    log4cpp::common::socket_fd fd = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    sockaddr_in local_addr{};
+    local_addr.sin_family = AF_INET;
+    local_addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t addr_len = sizeof(local_addr);
+    if (log4cpp::common::INVALID_FD == fd || bind(fd, reinterpret_cast<sockaddr *>(&local_addr), addr_len) != 0 ||
+        (listening && listen(fd, 1) != 0) ||
+        getsockname(fd, reinterpret_cast<sockaddr *>(&local_addr), &addr_len) != 0) {
+        log4cpp::common::close_socket(fd);
+        return log4cpp::common::INVALID_FD;
+    }
+    port = ntohs(local_addr.sin_port);
+    return fd;
+}
+
+bool readable(log4cpp::common::socket_fd fd, int timeout_ms) {
+    pollfd pfd{fd, POLLIN, 0};
+    return poll(&pfd, 1, timeout_ms) > 0;
+}
+
+/**
+ * Read until nothing arrives for 200 ms, and count the records
+ */
+size_t receive_records(log4cpp::common::socket_fd fd, const std::string &tag) {
+    std::string received;
+    char buffer[4096];
+    while (readable(fd, 200)) {
+        const ssize_t len = recv(fd, buffer, sizeof(buffer), 0);
+        if (len <= 0) {
+            break;
+        }
+        received.append(buffer, static_cast<size_t>(len));
+    }
+    size_t records = 0;
+    for (size_t pos = received.find(tag); std::string::npos != pos; pos = received.find(tag, pos + 1)) {
+        ++records;
+    }
+    return records;
+}
+
+log4cpp::config::socket_appender balanced_config(unsigned short port0, unsigned short port1) {
+    log4cpp::config::socket_appender cfg;
+    cfg.host = "127.0.0.1";
+    cfg.port = port0;
+    cfg.endpoints = {{"127.0.0.1", port0}, {"127.0.0.1", port1}};
+    cfg.prefer = log4cpp::common::prefer_stack::IPv4;
+    return cfg;
+}
+
+/**
+ * Accept both endpoints and log probes until both have received one, then drain them
+ */
+bool connect_both(log4cpp::appender::balanced_socket_appender &appender, const log4cpp::common::socket_fd server_fds[2],
+                  log4cpp::common::socket_fd client_fds[2]) {
+    for (int i = 0; i < 2; ++i) {
+        client_fds[i] = accept(server_fds[i], nullptr, nullptr);
+        if (log4cpp::common::INVALID_FD == client_fds[i]) {
+            return false;
+        }
+    }
+    const char probe[] = "probe\n";
+    bool seen[2] = {false, false};
+    for (int i = 0; i < 100 && !(seen[0] && seen[1]); ++i) {
+        appender.log(probe, sizeof(probe) - 1);
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        for (int j = 0; j < 2; ++j) {
+            seen[j] = seen[j] || readable(client_fds[j], 0);
+        }
+    }
+    for (int j = 0; j < 2; ++j) {
+        (void)receive_records(client_fds[j], "probe");
+    }
+    return seen[0] && seen[1];
+}
+
+TEST_F(socket_appender_test, balanced_round_robin_test) {
+    unsigned short ports[2];
+    log4cpp::common::socket_fd server_fds[2] = {bind_loopback(ports[0], true), bind_loopback(ports[1], true)};
+    ASSERT_NE(log4cpp::common::INVALID_FD, server_fds[0]);
+    ASSERT_NE(log4cpp::common::INVALID_FD, server_fds[1]);
+    auto appender = std::make_unique<log4cpp::appender::balanced_socket_appender>(balanced_config(ports[0], ports[1]));
+    log4cpp::common::socket_fd client_fds[2] = {log4cpp::common::INVALID_FD, log4cpp::common::INVALID_FD};
+    ASSERT_TRUE(connect_both(*appender, server_fds, client_fds));
+
+    // Both connected: the records alternate, whatever logger they come from
+    const char record[] = "round-robin\n";
+    for (uint32_t i = 0; i < 10; ++i) {
+        appender->log_keyed(7, record, sizeof(record) - 1);
+    }
+    EXPECT_EQ(5U, receive_records(client_fds[0], "round-robin"));
+    EXPECT_EQ(5U, receive_records(client_fds[1], "round-robin"));
+
+    appender.reset();
+    for (int i = 0; i < 2; ++i) {
+        log4cpp::common::close_socket(client_fds[i]);
+        log4cpp::common::close_socket(server_fds[i]);
+    }
+}
+
+TEST_F(socket_appender_test, balanced_hash_by_logger_test) {
+    unsigned short ports[2];
+    log4cpp::common::socket_fd server_fds[2] = {bind_loopback(ports[0], true), bind_loopback(ports[1], true)};
+    ASSERT_NE(log4cpp::common::INVALID_FD, server_fds[0]);
+    ASSERT_NE(log4cpp::common::INVALID_FD, server_fds[1]);
+    log4cpp::config::socket_appender cfg = balanced_config(ports[0], ports[1]);
+    cfg.balance = log4cpp::config::balance_policy::HASH_BY_LOGGER;
+    auto appender = std::make_unique<log4cpp::appender::balanced_socket_appender>(cfg);
+    log4cpp::common::socket_fd client_fds[2] = {log4cpp::common::INVALID_FD, log4cpp::common::INVALID_FD};
+    ASSERT_TRUE(connect_both(*appender, server_fds, client_fds));
+
+    // A logger's records all go to one endpoint, in order
+    const char even[] = "even\n";
+    const char odd[] = "odd\n";
+    for (int i = 0; i < 10; ++i) {
+        appender->log_keyed(4, even, sizeof(even) - 1);
+        appender->log_keyed(9, odd, sizeof(odd) - 1);
+    }
+    EXPECT_EQ(10U, receive_records(client_fds[0], "even"));
+    EXPECT_EQ(10U, receive_records(client_fds[1], "odd"));
+
+    appender.reset();
+    for (int i = 0; i < 2; ++i) {
+        log4cpp::common::close_socket(client_fds[i]);
+        log4cpp::common::close_socket(server_fds[i]);
+    }
+}
+
+TEST_F(socket_appender_test, balanced_failover_test) {
+    // The second endpoint is bound but not listening, its connection is refused
+    unsigned short ports[2];
+    log4cpp::common::socket_fd server_fds[2] = {bind_loopback(ports[0], true), bind_loopback(ports[1], false)};
+    ASSERT_NE(log4cpp::common::INVALID_FD, server_fds[0]);
+    ASSERT_NE(log4cpp::common::INVALID_FD, server_fds[1]);
+    log4cpp::config::socket_appender cfg = balanced_config(ports[0], ports[1]);
+    cfg.balance = log4cpp::config::balance_policy::HASH_BY_LOGGER;
+    auto appender = std::make_unique<log4cpp::appender::balanced_socket_appender>(cfg);
+    log4cpp::common::socket_fd client_fd = accept(server_fds[0], nullptr, nullptr);
+    ASSERT_NE(log4cpp::common::INVALID_FD, client_fd);
+    const char probe[] = "probe\n";
+    bool seen = false;
+    for (int i = 0; i < 100 && !seen; ++i) {
+        appender->log_keyed(0, probe, sizeof(probe) - 1);
+        seen = readable(client_fd, 20);
+    }
+    ASSERT_TRUE(seen);
+    (void)receive_records(client_fd, "probe");
+
+    // Records of either policy that would go to the refused endpoint go to the live one
+    const char record[] = "failover\n";
+    for (uint32_t i = 0; i < 10; ++i) {
+        appender->log_keyed(i, record, sizeof(record) - 1);
+        appender->log(record, sizeof(record) - 1);
+    }
+    EXPECT_EQ(20U, receive_records(client_fd, "failover"));
+
+    appender.reset();
+    log4cpp::common::close_socket(client_fd);
+    log4cpp::common::close_socket(server_fds[0]);
+    log4cpp::common::close_socket(server_fds[1]);
+}
+#endif
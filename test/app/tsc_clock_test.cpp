@@ -0,0 +1,67 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+
+#include <gtest/gtest.h>
+
+#include "common/tsc_clock.hpp"
+#include "pattern/log_pattern.hpp"
+
+namespace tsc_clock = log4cpp::common::tsc_clock;
+
+namespace {
+    long long since_ms(std::chrono::system_clock::time_point a, std::chrono::system_clock::time_point b) {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(a - b).count();
+    }
+
+    // Milliseconds into the minute of a "${ss}.${ms}" line
+    int minute_ms(const char *line) {
+        int ss = 0;
+        int ms = 0;
+        (void)std::sscanf(line, "%d.%d", &ss, &ms);
+        return ss * 1000 + ms;
+    }
+} // namespace
+
+TEST(tsc_clock_tests, now_follows_system_clock_test) {
+    const bool enabled = tsc_clock::calibrate();
+    EXPECT_EQ(enabled, tsc_clock::enabled());
+    // Calibrated once, a second call returns at once with the same result
+    EXPECT_EQ(enabled, tsc_clock::calibrate());
+    for (int i = 0; i < 5; ++i) {
+        const auto system = std::chrono::system_clock::now();
+        const auto tsc = tsc_clock::now();
+        EXPECT_LE(std::llabs(since_ms(tsc, system)), 5);
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+}
+
+TEST(tsc_clock_tests, ticks_convert_later_test) {
+    if (!tsc_clock::calibrate()) {
+        GTEST_SKIP() << "no invariant TSC";
+    }
+    const uint64_t ticks = tsc_clock::ticks();
+    const auto system = std::chrono::system_clock::now();
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    // Converted after the fact, as the async backend does: the time of the read, not of the conversion
+    EXPECT_LE(std::llabs(since_ms(tsc_clock::to_time(ticks), system)), 5);
+    EXPECT_GT(tsc_clock::ticks(), ticks);
+}
+
+TEST(tsc_clock_tests, deferred_line_keeps_call_time_test) {
+    log4cpp::pattern::log_pattern formatter("${ss}.${ms}");
+    formatter.set_tsc_clock(true);
+    log4cpp::pattern::line_origin origin;
+    formatter.capture_origin(origin);
+    EXPECT_EQ(tsc_clock::enabled(), 0 != origin.tsc);
+    char expected[64];
+    const log4cpp::format::format_args args{"", nullptr, 0};
+    log4cpp::pattern::log_pattern system_formatter("${ss}.${ms}");
+    (void)system_formatter.format(expected, sizeof(expected), "", log4cpp::log_level::INFO, args);
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    char actual[64];
+    (void)formatter.format(actual, sizeof(actual), "", log4cpp::log_level::INFO, origin, args);
+    const int diff = (minute_ms(actual) - minute_ms(expected) + 60000) % 60000;
+    EXPECT_TRUE(diff <= 5 || diff >= 60000 - 5) << "expected " << expected << ", got " << actual;
+}
@@ -2,6 +2,10 @@
 
 #include <cstring>
 #include <iostream>
+#include <string>
+#include <vector>
+
+#include "appender/log_appender.hpp"
 
 #define LOG4C_EXPECT_STR_EQ(expected, actual, message) \
     do { \
@@ -36,3 +40,13 @@
             ADD_FAILURE_AT(__FILE__, __LINE__) << message; \
         } \
     } while (0)
+
+// Collects the lines written by a logger. Not thread-safe, an async dispatcher calls it from the backend thread only.
+class capture_appender: public log4cpp::appender::log_appender {
+public:
+    void log(const char *msg, size_t msg_len) override {
+        lines.emplace_back(msg, msg_len);
+    }
+
+    std::vector<std::string> lines;
+};